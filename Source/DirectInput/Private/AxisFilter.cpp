@@ -0,0 +1,212 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "AxisFilter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogAxisFilter, Log, All);
+
+void FAxisFilterStore::LoadConfig()
+{
+	Profiles.Reset();
+
+	TArray<FString> Entries;
+	GConfig->GetArray(TEXT("DirectInput"), TEXT("AxisFilter"), Entries, GInputIni);
+
+	for (const FString& Entry : Entries)
+	{
+		TArray<FString> Fields;
+		Entry.ParseIntoArray(Fields, TEXT(","));
+
+		FGuid Product;
+		const uint32 Axis = Fields.Num() >= 3 ? FCString::Atoi(*Fields[1]) : 0;
+		if (Fields.Num() < 3 || !FGuid::Parse(Fields[0].TrimStartAndEnd(), Product) || Axis >= FAxisFilterProfile::MaxAxes)
+		{
+			UE_LOG(LogAxisFilter, Warning, TEXT("Ignoring AxisFilter=%s, expected <ProductGuid>,<Axis>,<Filter>[,<Parameters>]"), *Entry);
+			continue;
+		}
+
+		FAxisFilterSettings Settings;
+		const FString Type = Fields[2].TrimStartAndEnd();
+		if (Type == TEXT("LowPass") && Fields.Num() >= 4)
+		{
+			Settings.Type = EAxisFilter::LowPass;
+			Settings.MinCutoff = FCString::Atof(*Fields[3]);
+		}
+		else if (Type == TEXT("OneEuro") && Fields.Num() >= 5)
+		{
+			Settings.Type = EAxisFilter::OneEuro;
+			Settings.MinCutoff = FCString::Atof(*Fields[3]);
+			Settings.Beta = FCString::Atof(*Fields[4]);
+			Settings.DerivativeCutoff = Fields.Num() >= 6 ? FCString::Atof(*Fields[5]) : 1.0f;
+		}
+		else if (Type == TEXT("Median3"))
+		{
+			Settings.Type = EAxisFilter::Median3;
+		}
+		else if (Type == TEXT("Median5"))
+		{
+			Settings.Type = EAxisFilter::Median5;
+		}
+		else
+		{
+			UE_LOG(LogAxisFilter, Warning, TEXT("Ignoring AxisFilter=%s, unknown filter or missing parameters"), *Entry);
+			continue;
+		}
+
+		Profiles.FindOrAdd(Product).Axes[Axis] = Settings;
+	}
+}
+
+static FAxisFilterRegister MakeLanes(const FAxisFilterProfile& Profile, const uint32 Register, TFunctionRef<float(const FAxisFilterSettings&)> Value)
+{
+	const FAxisFilterSettings* Axes = Profile.Axes + Register * 4;
+	return MakeVectorRegister(Value(Axes[0]), Value(Axes[1]), Value(Axes[2]), Value(Axes[3]));
+}
+
+static FAxisFilterRegister MakeMask(const FAxisFilterProfile& Profile, const uint32 Register, TFunctionRef<bool(const FAxisFilterSettings&)> Predicate)
+{
+	return VectorCompareGT(MakeLanes(Profile, Register, [&Predicate](const FAxisFilterSettings& Settings) { return Predicate(Settings) ? 1.0f : 0.0f; }), VectorZero());
+}
+
+FAxisFilterBank::FAxisFilterBank(const FAxisFilterProfile& Profile) :
+	bPrimed(false)
+{
+	for (uint32 Register = 0; Register < NumRegisters; Register++)
+	{
+		// A low-pass is a one-euro filter whose cut-off doesn't rise with speed
+		MinCutoff[Register] = MakeLanes(Profile, Register, [](const FAxisFilterSettings& Settings) { return 2.0f * PI * Settings.MinCutoff; });
+		Beta[Register] = MakeLanes(Profile, Register, [](const FAxisFilterSettings& Settings) { return Settings.Type == EAxisFilter::OneEuro ? 2.0f * PI * Settings.Beta : 0.0f; });
+		DerivativeCutoff[Register] = MakeLanes(Profile, Register, [](const FAxisFilterSettings& Settings) { return 2.0f * PI * Settings.DerivativeCutoff; });
+
+		SmoothMask[Register] = MakeMask(Profile, Register, [](const FAxisFilterSettings& Settings) { return Settings.Type == EAxisFilter::LowPass || Settings.Type == EAxisFilter::OneEuro; });
+		Median3Mask[Register] = MakeMask(Profile, Register, [](const FAxisFilterSettings& Settings) { return Settings.Type == EAxisFilter::Median3; });
+		Median5Mask[Register] = MakeMask(Profile, Register, [](const FAxisFilterSettings& Settings) { return Settings.Type == EAxisFilter::Median5; });
+	}
+}
+
+static FORCEINLINE FAxisFilterRegister VectorMedian3(const FAxisFilterRegister& A, const FAxisFilterRegister& B, const FAxisFilterRegister& C)
+{
+	return VectorMax(VectorMin(A, B), VectorMin(VectorMax(A, B), C));
+}
+
+void FAxisFilterBank::Apply(const float* In, float* Out, const float DeltaTime)
+{
+	const FAxisFilterRegister Dt = VectorSetFloat1(FMath::Max(DeltaTime, SMALL_NUMBER));
+	const FAxisFilterRegister InvDt = VectorSetFloat1(1.0f / FMath::Max(DeltaTime, SMALL_NUMBER));
+
+	for (uint32 Register = 0; Register < NumRegisters; Register++)
+	{
+		const FAxisFilterRegister Input = VectorLoad(In + Register * 4);
+
+		if (!bPrimed)
+		{
+			Smoothed[Register] = Input;
+			Derivative[Register] = VectorZero();
+			PreviousInput[Register] = Input;
+			for (uint32 Tap = 0; Tap < MedianTaps; Tap++)
+			{
+				History[Tap][Register] = Input;
+			}
+		}
+
+		// Exponential smoothing with Alpha = 2 pi Cutoff Dt / (2 pi Cutoff Dt + 1), the one-euro filter raises the
+		// cut-off with the smoothed speed of the axis so it follows fast moves and stays steady at rest
+		const FAxisFilterRegister Speed = VectorMultiply(VectorSubtract(Input, PreviousInput[Register]), InvDt);
+		const FAxisFilterRegister DerivativeCutoffDt = VectorMultiply(DerivativeCutoff[Register], Dt);
+		const FAxisFilterRegister DerivativeAlpha = VectorDivide(DerivativeCutoffDt, VectorAdd(DerivativeCutoffDt, VectorOne()));
+		Derivative[Register] = VectorMultiplyAdd(DerivativeAlpha, VectorSubtract(Speed, Derivative[Register]), Derivative[Register]);
+
+		const FAxisFilterRegister CutoffDt = VectorMultiply(VectorMultiplyAdd(Beta[Register], VectorAbs(Derivative[Register]), MinCutoff[Register]), Dt);
+		const FAxisFilterRegister Alpha = VectorDivide(CutoffDt, VectorAdd(CutoffDt, VectorOne()));
+		Smoothed[Register] = VectorMultiplyAdd(Alpha, VectorSubtract(Input, Smoothed[Register]), Smoothed[Register]);
+		PreviousInput[Register] = Input;
+
+		for (uint32 Tap = MedianTaps - 1; Tap > 0; Tap--)
+		{
+			History[Tap][Register] = History[Tap - 1][Register];
+		}
+		History[0][Register] = Input;
+
+		// Median of five is the median of the fifth and the middle two of the other four
+		const FAxisFilterRegister Median3 = VectorMedian3(History[0][Register], History[1][Register], History[2][Register]);
+		const FAxisFilterRegister Low = VectorMax(VectorMin(History[0][Register], History[1][Register]), VectorMin(History[2][Register], History[3][Register]));
+		const FAxisFilterRegister High = VectorMin(VectorMax(History[0][Register], History[1][Register]), VectorMax(History[2][Register], History[3][Register]));
+		const FAxisFilterRegister Median5 = VectorMedian3(History[4][Register], Low, High);
+
+		FAxisFilterRegister Result = VectorSelect(SmoothMask[Register], Smoothed[Register], Input);
+		Result = VectorSelect(Median3Mask[Register], Median3, Result);
+		Result = VectorSelect(Median5Mask[Register], Median5, Result);
+		VectorStore(Result, Out + Register * 4);
+	}
+
+	// Whole counts, like the raw axes, so a smoothed axis stops reporting changes once it is within half a count of
+	// the input instead of creeping towards it for ever
+	for (uint32 Axis = 0; Axis < NumAxes; Axis++)
+	{
+		Out[Axis] = FMath::RoundToFloat(Out[Axis]);
+	}
+
+	bPrimed = true;
+}
+
+double FAxisFilterBank::Benchmark(const uint32 NumDevices, const uint32 NumSamples)
+{
+	FAxisFilterProfile Profile;
+	const EAxisFilter Types[] = { EAxisFilter::None, EAxisFilter::LowPass, EAxisFilter::OneEuro, EAxisFilter::Median3, EAxisFilter::Median5 };
+	for (uint32 Axis = 0; Axis < FAxisFilterProfile::MaxAxes; Axis++)
+	{
+		Profile.Axes[Axis].Type = Types[Axis % UE_ARRAY_COUNT(Types)];
+		Profile.Axes[Axis].MinCutoff = 5.0f;
+		Profile.Axes[Axis].Beta = 0.001f;
+	}
+
+	TArray<TUniquePtr<FAxisFilterBank>> Banks;
+	for (uint32 Device = 0; Device < NumDevices; Device++)
+	{
+		Banks.Add(MakeUnique<FAxisFilterBank>(Profile));
+	}
+
+	// Noisy ramps so the median and one-euro paths see changing input
+	FRandomStream Random(0);
+	TArray<float> Input;
+	Input.SetNumUninitialized(NumSamples * NumAxes);
+	for (uint32 Index = 0; Index < NumSamples * NumAxes; Index++)
+	{
+		Input[Index] = (Index / NumAxes) * 16.0f + Random.FRandRange(-64.0f, 64.0f);
+	}
+
+	float Output[NumAxes];
+	float Checksum = 0.0f;
+
+	const double StartTime = FPlatformTime::Seconds();
+	for (uint32 Sample = 0; Sample < NumSamples; Sample++)
+	{
+		for (TUniquePtr<FAxisFilterBank>& Bank : Banks)
+		{
+			Bank->Apply(&Input[Sample * NumAxes], Output, 0.001f);
+			Checksum += Output[0];
+		}
+	}
+	const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+	UE_LOG(LogAxisFilter, Verbose, TEXT("Filter benchmark checksum %f"), Checksum);
+	return Elapsed * 1.0e9 / FMath::Max<double>(static_cast<double>(NumDevices) * NumSamples, 1.0);
+}
@@ -0,0 +1,74 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "AxisNormalizer.h"
+
+uint32 FAxisNormalizer::AddDevice()
+{
+	const uint32 Lane = Input.Num();
+
+	for (FLaneArray* Lanes : { &Input, &Center, &ScaleBelow, &ScaleAbove, &DeadZone, &DeadZoneScale, &Sign, &Output })
+	{
+		Lanes->AddZeroed(LanesPerDevice);
+	}
+
+	return Lane;
+}
+
+void FAxisNormalizer::Reset()
+{
+	for (FLaneArray* Lanes : { &Input, &Center, &ScaleBelow, &ScaleAbove, &DeadZone, &DeadZoneScale, &Sign, &Output })
+	{
+		Lanes->Reset();
+	}
+}
+
+void FAxisNormalizer::SetAxis(const uint32 Lane, const FAxisCalibration& Calibration, const float InDeadZone)
+{
+	// Matches FAxisCalibration::Normalize, a side of the centre without any range reads as centred
+	Center[Lane] = Calibration.Center;
+	ScaleBelow[Lane] = Calibration.Center > Calibration.Min ? 1.0f / (Calibration.Center - Calibration.Min) : 0.0f;
+	ScaleAbove[Lane] = Calibration.Max > Calibration.Center ? 1.0f / (Calibration.Max - Calibration.Center) : 0.0f;
+	DeadZone[Lane] = FMath::Clamp(InDeadZone, 0.0f, 0.99f);
+	DeadZoneScale[Lane] = 1.0f / (1.0f - DeadZone[Lane]);
+	Sign[Lane] = Calibration.bInvert ? -1.0f : 1.0f;
+}
+
+void FAxisNormalizer::Convert()
+{
+	const FAxisFilterRegister Zero = VectorZero();
+	const FAxisFilterRegister One = VectorOne();
+
+	for (int32 Lane = 0; Lane < Input.Num(); Lane += 4)
+	{
+		const FAxisFilterRegister Value = VectorSubtract(VectorLoadAligned(&Input[Lane]), VectorLoadAligned(&Center[Lane]));
+		const FAxisFilterRegister Below = VectorCompareLT(Value, Zero);
+
+		// Distance from the centre as a fraction of that side's range, with the dead zone cut out of it
+		const FAxisFilterRegister Scale = VectorSelect(Below, VectorLoadAligned(&ScaleBelow[Lane]), VectorLoadAligned(&ScaleAbove[Lane]));
+		FAxisFilterRegister Magnitude = VectorAbs(VectorMultiply(Value, Scale));
+		Magnitude = VectorMax(VectorSubtract(Magnitude, VectorLoadAligned(&DeadZone[Lane])), Zero);
+		Magnitude = VectorMin(VectorMultiply(Magnitude, VectorLoadAligned(&DeadZoneScale[Lane])), One);
+
+		const FAxisFilterRegister LaneSign = VectorLoadAligned(&Sign[Lane]);
+		VectorStoreAligned(VectorMultiply(Magnitude, VectorSelect(Below, VectorNegate(LaneSign), LaneSign)), &Output[Lane]);
+	}
+}
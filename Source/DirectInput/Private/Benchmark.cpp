@@ -0,0 +1,442 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "Benchmark.h"
+#include "DirectInputDevice.h"
+#include "Joystick.h"
+#include "SimulatedDevice.h"
+
+extern FJoystickArray GInputDevices;
+
+static const TCHAR* BenchmarkSection = TEXT("DirectInput.Benchmarks");
+
+// Counts the events the dispatch sends instead of passing them on
+class FCountingMessageHandler : public FGenericApplicationMessageHandler
+{
+public:
+	virtual bool OnControllerAnalog(FGamepadKeyNames::Type KeyName, int32 ControllerId, float AnalogValue) override
+	{
+		NumEvents++;
+		return false;
+	}
+
+	virtual bool OnControllerButtonPressed(FGamepadKeyNames::Type KeyName, int32 ControllerId, bool IsRepeat) override
+	{
+		NumEvents++;
+		return false;
+	}
+
+	virtual bool OnControllerButtonReleased(FGamepadKeyNames::Type KeyName, int32 ControllerId, bool IsRepeat) override
+	{
+		NumEvents++;
+		return false;
+	}
+
+	uint64 NumEvents = 0;
+};
+
+enum class EBenchmarkPattern : uint8
+{
+	// Nothing changes, the cost of polling and finding that out
+	Idle,
+	// Idle, and the dispatch pass is timed against the layout from before the metadata was split off
+	Dispatch,
+	// Every axis, button and POV changes every frame
+	FullChange,
+	// Every button toggles every frame
+	ButtonStorm,
+	// A few random objects change on each device every frame
+	RandomChange,
+	// Many force feedback updates per device every frame, input is idle
+	ForceFeedback,
+	// The axis filters alone
+	Filter,
+	// Creating the devices, with and without their objects in the device cache
+	Startup,
+};
+
+struct FBenchmarkCase
+{
+	const TCHAR* Name;
+	EBenchmarkPattern Pattern;
+	uint32 NumDevices;
+	uint32 NumAxes;
+	uint32 NumButtons;
+	uint32 NumPovs;
+};
+
+static const FBenchmarkCase BenchmarkCases[] =
+{
+	{ TEXT("Idle"), EBenchmarkPattern::Idle, 4, 6, 32, 1 },
+	{ TEXT("FullChange"), EBenchmarkPattern::FullChange, 4, 8, 32, 1 },
+	{ TEXT("ButtonStorm"), EBenchmarkPattern::ButtonStorm, 4, 2, 128, 0 },
+	{ TEXT("ManyDevices"), EBenchmarkPattern::RandomChange, 32, 6, 32, 1 },
+	{ TEXT("Dispatch"), EBenchmarkPattern::Dispatch, 16, 8, 32, 1 },
+	{ TEXT("ForceFeedback"), EBenchmarkPattern::ForceFeedback, 4, 6, 32, 1 },
+	{ TEXT("Filter"), EBenchmarkPattern::Filter, 4, 8, 0, 0 },
+	{ TEXT("Startup"), EBenchmarkPattern::Startup, 6, 8, 32, 1 },
+};
+
+static constexpr uint32 EffectUpdatesPerFrame = 16;
+
+// Dispatch passes timed for each layout, and the memory written between them to evict the devices from every cache
+static constexpr uint32 LayoutPasses = 101;
+static constexpr int32 EvictionSize = 64 * 1024 * 1024;
+
+// FJoystick as it was before its metadata moved to FInfo, with the members in their old order and the state in an
+// allocation of its own. Only the members the dispatch of an unchanged device reads are set.
+struct FLegacyJoystick
+{
+	LPDIRECTINPUTEFFECT Effect = nullptr;
+	int ConstantForce = 0;
+
+	LPDIRECTINPUTEFFECT ConditionEffects[static_cast<uint32>(EForceCondition::Count)] = {};
+	uint32 HardwareConditions = 0;
+	FForceConditions ConditionSettings;
+	FConditionSynthesizer Conditions;
+
+	TUniquePtr<FForceStream> Stream;
+	LPDIRECTINPUTEFFECT StreamEffect = nullptr;
+	bool bStreamPeriodic = false;
+
+	TMap<FGuid, TArray<LPDIRECTINPUTEFFECT>> EffectCache;
+
+	LPDIRECTINPUTDEVICE8 Device = nullptr;
+	DIDEVICEINSTANCE Instance = {};
+	DIDEVCAPS Capabilities = {};
+
+	bool Available = true;
+
+	TArray<FDeviceObject> Objects;
+	TArray<DIOBJECTDATAFORMAT> ObjectFormats;
+	uint32 NumAxes = 0;
+	uint32 NumButtons = 0;
+	uint32 NumPovs = 0;
+	uint32 PovOffset = 0;
+	uint32 ButtonOffset = 0;
+	uint32 DataSize = 0;
+
+	TArray<uint8> State;
+	uint32 StateIndex = 0;
+
+	TSharedPtr<FInputHistory, ESPMode::ThreadSafe> History;
+	FStateSnapshot* Snapshot = nullptr;
+	FTelemetryPublisher* Telemetry = nullptr;
+	uint32 TelemetrySlot = 0;
+
+	DIEFFECT EffectConfig = {};
+
+	FAxisCalibration AxisCalibrations[FJoystick::MaxAxes];
+
+	FAxisNormalizer* Normalizer = nullptr;
+	uint32 NormalizerLane = 0;
+	float DeadZone = 0.0f;
+
+	FRemapTable Remap;
+
+	TUniquePtr<FAxisFilterBank> Filter;
+	float FilteredAxes[2][FJoystick::MaxAxes] = {};
+	double LastFilterTime = 0.0;
+
+	FPollSchedule Schedule;
+
+	bool bInputLost = false;
+
+	bool bCalibrating = false;
+	int32 ObservedMin[FJoystick::MaxAxes] = {};
+	int32 ObservedMax[FJoystick::MaxAxes] = {};
+
+	// What the dispatch read of an unchanged device: the stream, the software conditions and the state comparison
+	bool IsIdle() const
+	{
+		if (Stream.IsValid() || Conditions.IsActive())
+			return false;
+		if (Filter.IsValid() && FMemory::Memcmp(FilteredAxes[0], FilteredAxes[1], NumAxes * sizeof(float)) != 0)
+			return false;
+		return FMemory::Memcmp(State.GetData() + StateIndex * DataSize, State.GetData() + (StateIndex ^ 1) * DataSize, DataSize) == 0;
+	}
+};
+
+static bool IsIdle(const FJoystick& Joy)
+{
+	return Joy.GetForceStream() == nullptr && !Joy.HasSoftwareConditions() && !Joy.IsStateChanged();
+}
+
+static bool IsIdle(const FLegacyJoystick& Joy)
+{
+	return Joy.IsIdle();
+}
+
+// Median time of a pass over the devices in ns per device, each pass starting with nothing of them in any cache
+template <typename DeviceArrayType>
+static double TimeDispatchPass(const DeviceArrayType& Devices, TArray<uint8>& Eviction, uint32& OutNumIdle)
+{
+	TArray<double> Passes;
+	for (uint32 Pass = 0; Pass < LayoutPasses; Pass++)
+	{
+		for (int32 Offset = 0; Offset < Eviction.Num(); Offset += PLATFORM_CACHE_LINE_SIZE)
+		{
+			Eviction[Offset]++;
+		}
+
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		for (const auto& Device : Devices)
+		{
+			OutNumIdle += IsIdle(Device) ? 1 : 0;
+		}
+		Passes.Add((FPlatformTime::Cycles64() - StartCycles) * FPlatformTime::GetSecondsPerCycle64() * 1.0e9 / FMath::Max(Devices.Num(), 1));
+	}
+
+	Passes.Sort();
+	return Passes[Passes.Num() / 2];
+}
+
+static void CompareLayouts(FBenchmarkResult& OutResult)
+{
+	// The same devices in the old layout, each with its state in an allocation of its own
+	TArray<FLegacyJoystick> LegacyDevices;
+	LegacyDevices.SetNum(GInputDevices.Num());
+	for (int32 Index = 0; Index < GInputDevices.Num(); Index++)
+	{
+		FLegacyJoystick& Legacy = LegacyDevices[Index];
+		Legacy.NumAxes = GInputDevices[Index].GetNumAxes();
+		Legacy.NumButtons = GInputDevices[Index].GetNumButtons();
+		Legacy.NumPovs = GInputDevices[Index].GetNumPovs();
+		Legacy.DataSize = Align(Legacy.NumAxes * sizeof(LONG) + Legacy.NumPovs * sizeof(DWORD) + Legacy.NumButtons, sizeof(DWORD));
+		Legacy.State.SetNumZeroed(Legacy.DataSize * 2);
+	}
+
+	TArray<uint8> Eviction;
+	Eviction.SetNumZeroed(EvictionSize);
+
+	uint32 NumIdle = 0;
+	OutResult.DispatchNanoseconds = TimeDispatchPass(GInputDevices, Eviction, NumIdle);
+	OutResult.LegacyDispatchNanoseconds = TimeDispatchPass(LegacyDevices, Eviction, NumIdle);
+
+	// Every device is idle in both layouts, checking that also keeps the passes from being optimised away
+	if (NumIdle != LayoutPasses * (GInputDevices.Num() + LegacyDevices.Num()))
+	{
+		OutResult.DispatchNanoseconds = 0.0;
+		OutResult.LegacyDispatchNanoseconds = 0.0;
+	}
+}
+
+// Every device created logs its objects when they are enumerated, so startup is timed a fixed number of times
+static constexpr uint32 StartupRounds = 20;
+
+// Median time to create the devices of a case in ns per device, with every device enumerating its objects like on the
+// first run or with all of them in the cache like on a rig Devices.bin was saved on
+static double TimeStartup(const FBenchmarkCase& Case, const bool bCached)
+{
+	FDeviceCache Cache;
+	TArray<double> Rounds;
+
+	// The first cached round fills the cache and isn't counted
+	for (uint32 Round = 0; Round < StartupRounds + (bCached ? 1 : 0); Round++)
+	{
+		TArray<FSimulatedDevice*> Devices;
+		for (uint32 Index = 0; Index < Case.NumDevices; Index++)
+		{
+			Devices.Add(new FSimulatedDevice(Index, Case.NumAxes, Case.NumButtons, Case.NumPovs));
+		}
+
+		FJoystickArray Joysticks;
+		Joysticks.Reserve(Devices.Num());
+
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		for (FSimulatedDevice* Device : Devices)
+		{
+			Joysticks.Emplace(Device, bCached ? &Cache : nullptr);
+		}
+		const double Nanoseconds = (FPlatformTime::Cycles64() - StartCycles) * FPlatformTime::GetSecondsPerCycle64() * 1.0e9 / FMath::Max(Devices.Num(), 1);
+
+		if (!bCached || Round > 0)
+		{
+			Rounds.Add(Nanoseconds);
+		}
+
+		// Releasing the joysticks releases the simulated devices
+		for (FJoystick& Joy : Joysticks)
+		{
+			Joy.Release();
+		}
+	}
+
+	Rounds.Sort();
+	return Rounds[Rounds.Num() / 2];
+}
+
+const TArray<FString>& FDirectInputBenchmark::GetCaseNames()
+{
+	static TArray<FString> Names;
+	if (Names.Num() == 0)
+	{
+		for (const FBenchmarkCase& Case : BenchmarkCases)
+		{
+			Names.Add(Case.Name);
+		}
+	}
+	return Names;
+}
+
+static void SetAllButtons(FSimulatedDevice& Simulated, const bool bPressed)
+{
+	for (uint32 Button = 0; Button < Simulated.GetNumButtons(); Button++)
+	{
+		Simulated.SetButton(Button, bPressed);
+	}
+}
+
+static void ChangeState(FSimulatedDevice& Simulated, const EBenchmarkPattern Pattern, const uint32 Frame, FRandomStream& Random)
+{
+	const bool bOdd = (Frame & 1) != 0;
+
+	switch (Pattern)
+	{
+	case EBenchmarkPattern::FullChange:
+		for (uint32 Axis = 0; Axis < Simulated.GetNumAxes(); Axis++)
+		{
+			Simulated.SetAxis(Axis, bOdd ? 1000 : 64000);
+		}
+		for (uint32 Pov = 0; Pov < Simulated.GetNumPovs(); Pov++)
+		{
+			Simulated.SetPov(Pov, bOdd ? 9000 : 27000);
+		}
+		SetAllButtons(Simulated, bOdd);
+		break;
+	case EBenchmarkPattern::ButtonStorm:
+		SetAllButtons(Simulated, bOdd);
+		break;
+	case EBenchmarkPattern::RandomChange:
+		for (uint32 Change = 0; Change < 4; Change++)
+		{
+			if (Simulated.GetNumAxes() > 0)
+			{
+				Simulated.SetAxis(Random.RandHelper(Simulated.GetNumAxes()), Random.RandRange(0, 65535));
+			}
+			if (Simulated.GetNumButtons() > 0)
+			{
+				const uint32 Button = Random.RandHelper(Simulated.GetNumButtons());
+				Simulated.SetButton(Button, !Simulated.GetButton(Button));
+			}
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+bool FDirectInputBenchmark::Run(FDirectInputDevice& InputDevice, const FString& Name, const uint32 NumFrames, FBenchmarkResult& OutResult)
+{
+	const FBenchmarkCase* Case = nullptr;
+	for (const FBenchmarkCase& Candidate : BenchmarkCases)
+	{
+		if (Name.Equals(Candidate.Name, ESearchCase::IgnoreCase))
+		{
+			Case = &Candidate;
+		}
+	}
+
+	if (Case == nullptr)
+	{
+		return false;
+	}
+
+	OutResult.Name = Case->Name;
+	OutResult.NumDevices = Case->NumDevices;
+	OutResult.NumFrames = NumFrames;
+
+	if (Case->Pattern == EBenchmarkPattern::Filter)
+	{
+		OutResult.NanosecondsPerDeviceFrame = FAxisFilterBank::Benchmark(Case->NumDevices, NumFrames);
+		OutResult.EventsPerSecond = 0.0;
+		return true;
+	}
+
+	if (Case->Pattern == EBenchmarkPattern::Startup)
+	{
+		OutResult.NumFrames = StartupRounds;
+		OutResult.UncachedStartupNanoseconds = TimeStartup(*Case, false);
+		OutResult.NanosecondsPerDeviceFrame = TimeStartup(*Case, true);
+		OutResult.EventsPerSecond = 0.0;
+		return true;
+	}
+
+	const TSharedRef<FCountingMessageHandler> CountingHandler = MakeShared<FCountingMessageHandler>();
+	FSimulatedDeviceScope Simulated(InputDevice, CountingHandler, Case->NumDevices, Case->NumAxes, Case->NumButtons, Case->NumPovs);
+
+	FRandomStream Random(Case->NumDevices);
+	const double StartTime = FPlatformTime::Seconds();
+
+	for (uint32 Frame = 0; Frame < NumFrames; Frame++)
+	{
+		for (uint32 Index = 0; Index < Simulated.Num(); Index++)
+		{
+			ChangeState(Simulated.GetDevice(Index), Case->Pattern, Frame, Random);
+		}
+
+		InputDevice.SendDeviceEvents();
+
+		if (Case->Pattern == EBenchmarkPattern::ForceFeedback)
+		{
+			for (uint32 Index = 0; Index < Case->NumDevices; Index++)
+			{
+				for (uint32 Update = 0; Update < EffectUpdatesPerFrame; Update++)
+				{
+					InputDevice.SetChannelValue(Index, FForceFeedbackChannelType::LEFT_LARGE, (Frame + Update) % 2 ? 5000.0f : -5000.0f);
+				}
+			}
+		}
+	}
+
+	const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+	OutResult.DeviceStride = sizeof(FJoystick);
+	if (Case->Pattern == EBenchmarkPattern::Dispatch)
+	{
+		CompareLayouts(OutResult);
+	}
+
+	OutResult.NanosecondsPerDeviceFrame = Elapsed * 1.0e9 / FMath::Max<double>(static_cast<double>(Case->NumDevices) * NumFrames, 1.0);
+	OutResult.EventsPerSecond = Elapsed > 0.0 ? CountingHandler->NumEvents / Elapsed : 0.0;
+
+	return true;
+}
+
+bool FDirectInputBenchmark::CompareWithBaseline(const FBenchmarkResult& Result, const float Threshold, double& OutBaseline)
+{
+	OutBaseline = 0.0;
+
+	FString Baseline;
+	if (!GConfig->GetString(BenchmarkSection, *Result.Name, Baseline, GInputIni))
+	{
+		return false;
+	}
+
+	OutBaseline = FCString::Atod(*Baseline);
+	return OutBaseline > 0.0 && Result.NanosecondsPerDeviceFrame <= OutBaseline * (1.0 + Threshold);
+}
+
+void FDirectInputBenchmark::SaveBaseline(const FBenchmarkResult& Result)
+{
+	GConfig->SetString(BenchmarkSection, *Result.Name, *FString::Printf(TEXT("%.2f"), Result.NanosecondsPerDeviceFrame), GInputIni);
+	GConfig->Flush(false, GInputIni);
+}
@@ -1,310 +1,225 @@
-﻿/* 
- * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
- * 
- * Permission is hereby granted, free of charge, to any person obtaining a copy of 
- * this software and associated documentation files (the "Software"), to deal in the 
- * Software without restriction, including without limitation the rights to use, copy, 
- * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
- * and to permit persons to whom the Software is furnished to do so, subject to the 
- * following conditions:
- *
- * The above copyright notice and this permission notice shall be included in all 
- * copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
- * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
- * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
- * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
- * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
- * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
-*/
-
-#include "Bindings.h"
-
-// FName
-const FGamepadKeyNames::Type FDirectInputKeyNames::Axis1("DirectInput_Axis1");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Axis2("DirectInput_Axis2");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Axis3("DirectInput_Axis3");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Axis4("DirectInput_Axis4");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Axis5("DirectInput_Axis5");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Axis6("DirectInput_Axis6");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Axis7("DirectInput_Axis7");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Axis8("DirectInput_Axis8");
-
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button1("DirectInput_Button1");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button2("DirectInput_Button2");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button3("DirectInput_Button3");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button4("DirectInput_Button4");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button5("DirectInput_Button5");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button6("DirectInput_Button6");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button7("DirectInput_Button7");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button8("DirectInput_Button8");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button9("DirectInput_Button9");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button10("DirectInput_Button10");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button11("DirectInput_Button11");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button12("DirectInput_Button12");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button13("DirectInput_Button13");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button14("DirectInput_Button14");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button15("DirectInput_Button15");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button16("DirectInput_Button16");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button17("DirectInput_Button17");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button18("DirectInput_Button18");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button19("DirectInput_Button19");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button20("DirectInput_Button20");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button21("DirectInput_Button21");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button22("DirectInput_Button22");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button23("DirectInput_Button23");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button24("DirectInput_Button24");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button25("DirectInput_Button25");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button26("DirectInput_Button26");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button27("DirectInput_Button27");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button28("DirectInput_Button28");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button29("DirectInput_Button29");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button30("DirectInput_Button30");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button31("DirectInput_Button31");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button32("DirectInput_Button32");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button33("DirectInput_Button33");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button34("DirectInput_Button34");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button35("DirectInput_Button35");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button36("DirectInput_Button36");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button37("DirectInput_Button37");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button38("DirectInput_Button38");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button39("DirectInput_Button39");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button40("DirectInput_Button40");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button41("DirectInput_Button41");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button42("DirectInput_Button42");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button43("DirectInput_Button43");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button44("DirectInput_Button44");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button45("DirectInput_Button45");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button46("DirectInput_Button46");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button47("DirectInput_Button47");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button48("DirectInput_Button48");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button49("DirectInput_Button49");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button50("DirectInput_Button50");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button51("DirectInput_Button51");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button52("DirectInput_Button52");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button53("DirectInput_Button53");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button54("DirectInput_Button54");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button55("DirectInput_Button55");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button56("DirectInput_Button56");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button57("DirectInput_Button57");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button58("DirectInput_Button58");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button59("DirectInput_Button59");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button60("DirectInput_Button60");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button61("DirectInput_Button61");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button62("DirectInput_Button62");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button63("DirectInput_Button63");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button64("DirectInput_Button64");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button65("DirectInput_Button65");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button66("DirectInput_Button66");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button67("DirectInput_Button67");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button68("DirectInput_Button68");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button69("DirectInput_Button69");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button70("DirectInput_Button70");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button71("DirectInput_Button71");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button72("DirectInput_Button72");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button73("DirectInput_Button73");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button74("DirectInput_Button74");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button75("DirectInput_Button75");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button76("DirectInput_Button76");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button77("DirectInput_Button77");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button78("DirectInput_Button78");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button79("DirectInput_Button79");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button80("DirectInput_Button80");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button81("DirectInput_Button81");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button82("DirectInput_Button82");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button83("DirectInput_Button83");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button84("DirectInput_Button84");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button85("DirectInput_Button85");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button86("DirectInput_Button86");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button87("DirectInput_Button87");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button88("DirectInput_Button88");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button89("DirectInput_Button89");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button90("DirectInput_Button90");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button91("DirectInput_Button91");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button92("DirectInput_Button92");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button93("DirectInput_Button93");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button94("DirectInput_Button94");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button95("DirectInput_Button95");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button96("DirectInput_Button96");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button97("DirectInput_Button97");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button98("DirectInput_Button98");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button99("DirectInput_Button99");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button100("DirectInput_Button100");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button101("DirectInput_Button101");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button102("DirectInput_Button102");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button103("DirectInput_Button103");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button104("DirectInput_Button104");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button105("DirectInput_Button105");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button106("DirectInput_Button106");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button107("DirectInput_Button107");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button108("DirectInput_Button108");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button109("DirectInput_Button109");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button110("DirectInput_Button110");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button111("DirectInput_Button111");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button112("DirectInput_Button112");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button113("DirectInput_Button113");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button114("DirectInput_Button114");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button115("DirectInput_Button115");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button116("DirectInput_Button116");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button117("DirectInput_Button117");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button118("DirectInput_Button118");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button119("DirectInput_Button119");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button120("DirectInput_Button120");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button121("DirectInput_Button121");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button122("DirectInput_Button122");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button123("DirectInput_Button123");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button124("DirectInput_Button124");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button125("DirectInput_Button125");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button126("DirectInput_Button126");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button127("DirectInput_Button127");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Button128("DirectInput_Button128");
-
-const FGamepadKeyNames::Type FDirectInputKeyNames::Pov1("DirectInput_Pov1");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Pov2("DirectInput_Pov2");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Pov3("DirectInput_Pov3");
-const FGamepadKeyNames::Type FDirectInputKeyNames::Pov4("DirectInput_Pov4");
-
-// FKey
-const FKey FDirectInputKeys::Axis1(FDirectInputKeyNames::Axis1);
-const FKey FDirectInputKeys::Axis2(FDirectInputKeyNames::Axis2);
-const FKey FDirectInputKeys::Axis3(FDirectInputKeyNames::Axis3);
-const FKey FDirectInputKeys::Axis4(FDirectInputKeyNames::Axis4);
-const FKey FDirectInputKeys::Axis5(FDirectInputKeyNames::Axis5);
-const FKey FDirectInputKeys::Axis6(FDirectInputKeyNames::Axis6);
-const FKey FDirectInputKeys::Axis7(FDirectInputKeyNames::Axis7);
-const FKey FDirectInputKeys::Axis8(FDirectInputKeyNames::Axis8);
-
-const FKey FDirectInputKeys::Button1(FDirectInputKeyNames::Button1);
-const FKey FDirectInputKeys::Button2(FDirectInputKeyNames::Button2);
-const FKey FDirectInputKeys::Button3(FDirectInputKeyNames::Button3);
-const FKey FDirectInputKeys::Button4(FDirectInputKeyNames::Button4);
-const FKey FDirectInputKeys::Button5(FDirectInputKeyNames::Button5);
-const FKey FDirectInputKeys::Button6(FDirectInputKeyNames::Button6);
-const FKey FDirectInputKeys::Button7(FDirectInputKeyNames::Button7);
-const FKey FDirectInputKeys::Button8(FDirectInputKeyNames::Button8);
-const FKey FDirectInputKeys::Button9(FDirectInputKeyNames::Button9);
-const FKey FDirectInputKeys::Button10(FDirectInputKeyNames::Button10);
-const FKey FDirectInputKeys::Button11(FDirectInputKeyNames::Button11);
-const FKey FDirectInputKeys::Button12(FDirectInputKeyNames::Button12);
-const FKey FDirectInputKeys::Button13(FDirectInputKeyNames::Button13);
-const FKey FDirectInputKeys::Button14(FDirectInputKeyNames::Button14);
-const FKey FDirectInputKeys::Button15(FDirectInputKeyNames::Button15);
-const FKey FDirectInputKeys::Button16(FDirectInputKeyNames::Button16);
-const FKey FDirectInputKeys::Button17(FDirectInputKeyNames::Button17);
-const FKey FDirectInputKeys::Button18(FDirectInputKeyNames::Button18);
-const FKey FDirectInputKeys::Button19(FDirectInputKeyNames::Button19);
-const FKey FDirectInputKeys::Button20(FDirectInputKeyNames::Button20);
-const FKey FDirectInputKeys::Button21(FDirectInputKeyNames::Button21);
-const FKey FDirectInputKeys::Button22(FDirectInputKeyNames::Button22);
-const FKey FDirectInputKeys::Button23(FDirectInputKeyNames::Button23);
-const FKey FDirectInputKeys::Button24(FDirectInputKeyNames::Button24);
-const FKey FDirectInputKeys::Button25(FDirectInputKeyNames::Button25);
-const FKey FDirectInputKeys::Button26(FDirectInputKeyNames::Button26);
-const FKey FDirectInputKeys::Button27(FDirectInputKeyNames::Button27);
-const FKey FDirectInputKeys::Button28(FDirectInputKeyNames::Button28);
-const FKey FDirectInputKeys::Button29(FDirectInputKeyNames::Button29);
-const FKey FDirectInputKeys::Button30(FDirectInputKeyNames::Button30);
-const FKey FDirectInputKeys::Button31(FDirectInputKeyNames::Button31);
-const FKey FDirectInputKeys::Button32(FDirectInputKeyNames::Button32);
-const FKey FDirectInputKeys::Button33(FDirectInputKeyNames::Button33);
-const FKey FDirectInputKeys::Button34(FDirectInputKeyNames::Button34);
-const FKey FDirectInputKeys::Button35(FDirectInputKeyNames::Button35);
-const FKey FDirectInputKeys::Button36(FDirectInputKeyNames::Button36);
-const FKey FDirectInputKeys::Button37(FDirectInputKeyNames::Button37);
-const FKey FDirectInputKeys::Button38(FDirectInputKeyNames::Button38);
-const FKey FDirectInputKeys::Button39(FDirectInputKeyNames::Button39);
-const FKey FDirectInputKeys::Button40(FDirectInputKeyNames::Button40);
-const FKey FDirectInputKeys::Button41(FDirectInputKeyNames::Button41);
-const FKey FDirectInputKeys::Button42(FDirectInputKeyNames::Button42);
-const FKey FDirectInputKeys::Button43(FDirectInputKeyNames::Button43);
-const FKey FDirectInputKeys::Button44(FDirectInputKeyNames::Button44);
-const FKey FDirectInputKeys::Button45(FDirectInputKeyNames::Button45);
-const FKey FDirectInputKeys::Button46(FDirectInputKeyNames::Button46);
-const FKey FDirectInputKeys::Button47(FDirectInputKeyNames::Button47);
-const FKey FDirectInputKeys::Button48(FDirectInputKeyNames::Button48);
-const FKey FDirectInputKeys::Button49(FDirectInputKeyNames::Button49);
-const FKey FDirectInputKeys::Button50(FDirectInputKeyNames::Button50);
-const FKey FDirectInputKeys::Button51(FDirectInputKeyNames::Button51);
-const FKey FDirectInputKeys::Button52(FDirectInputKeyNames::Button52);
-const FKey FDirectInputKeys::Button53(FDirectInputKeyNames::Button53);
-const FKey FDirectInputKeys::Button54(FDirectInputKeyNames::Button54);
-const FKey FDirectInputKeys::Button55(FDirectInputKeyNames::Button55);
-const FKey FDirectInputKeys::Button56(FDirectInputKeyNames::Button56);
-const FKey FDirectInputKeys::Button57(FDirectInputKeyNames::Button57);
-const FKey FDirectInputKeys::Button58(FDirectInputKeyNames::Button58);
-const FKey FDirectInputKeys::Button59(FDirectInputKeyNames::Button59);
-const FKey FDirectInputKeys::Button60(FDirectInputKeyNames::Button60);
-const FKey FDirectInputKeys::Button61(FDirectInputKeyNames::Button61);
-const FKey FDirectInputKeys::Button62(FDirectInputKeyNames::Button62);
-const FKey FDirectInputKeys::Button63(FDirectInputKeyNames::Button63);
-const FKey FDirectInputKeys::Button64(FDirectInputKeyNames::Button64);
-const FKey FDirectInputKeys::Button65(FDirectInputKeyNames::Button65);
-const FKey FDirectInputKeys::Button66(FDirectInputKeyNames::Button66);
-const FKey FDirectInputKeys::Button67(FDirectInputKeyNames::Button67);
-const FKey FDirectInputKeys::Button68(FDirectInputKeyNames::Button68);
-const FKey FDirectInputKeys::Button69(FDirectInputKeyNames::Button69);
-const FKey FDirectInputKeys::Button70(FDirectInputKeyNames::Button70);
-const FKey FDirectInputKeys::Button71(FDirectInputKeyNames::Button71);
-const FKey FDirectInputKeys::Button72(FDirectInputKeyNames::Button72);
-const FKey FDirectInputKeys::Button73(FDirectInputKeyNames::Button73);
-const FKey FDirectInputKeys::Button74(FDirectInputKeyNames::Button74);
-const FKey FDirectInputKeys::Button75(FDirectInputKeyNames::Button75);
-const FKey FDirectInputKeys::Button76(FDirectInputKeyNames::Button76);
-const FKey FDirectInputKeys::Button77(FDirectInputKeyNames::Button77);
-const FKey FDirectInputKeys::Button78(FDirectInputKeyNames::Button78);
-const FKey FDirectInputKeys::Button79(FDirectInputKeyNames::Button79);
-const FKey FDirectInputKeys::Button80(FDirectInputKeyNames::Button80);
-const FKey FDirectInputKeys::Button81(FDirectInputKeyNames::Button81);
-const FKey FDirectInputKeys::Button82(FDirectInputKeyNames::Button82);
-const FKey FDirectInputKeys::Button83(FDirectInputKeyNames::Button83);
-const FKey FDirectInputKeys::Button84(FDirectInputKeyNames::Button84);
-const FKey FDirectInputKeys::Button85(FDirectInputKeyNames::Button85);
-const FKey FDirectInputKeys::Button86(FDirectInputKeyNames::Button86);
-const FKey FDirectInputKeys::Button87(FDirectInputKeyNames::Button87);
-const FKey FDirectInputKeys::Button88(FDirectInputKeyNames::Button88);
-const FKey FDirectInputKeys::Button89(FDirectInputKeyNames::Button89);
-const FKey FDirectInputKeys::Button90(FDirectInputKeyNames::Button90);
-const FKey FDirectInputKeys::Button91(FDirectInputKeyNames::Button91);
-const FKey FDirectInputKeys::Button92(FDirectInputKeyNames::Button92);
-const FKey FDirectInputKeys::Button93(FDirectInputKeyNames::Button93);
-const FKey FDirectInputKeys::Button94(FDirectInputKeyNames::Button94);
-const FKey FDirectInputKeys::Button95(FDirectInputKeyNames::Button95);
-const FKey FDirectInputKeys::Button96(FDirectInputKeyNames::Button96);
-const FKey FDirectInputKeys::Button97(FDirectInputKeyNames::Button97);
-const FKey FDirectInputKeys::Button98(FDirectInputKeyNames::Button98);
-const FKey FDirectInputKeys::Button99(FDirectInputKeyNames::Button99);
-const FKey FDirectInputKeys::Button100(FDirectInputKeyNames::Button100);
-const FKey FDirectInputKeys::Button101(FDirectInputKeyNames::Button101);
-const FKey FDirectInputKeys::Button102(FDirectInputKeyNames::Button102);
-const FKey FDirectInputKeys::Button103(FDirectInputKeyNames::Button103);
-const FKey FDirectInputKeys::Button104(FDirectInputKeyNames::Button104);
-const FKey FDirectInputKeys::Button105(FDirectInputKeyNames::Button105);
-const FKey FDirectInputKeys::Button106(FDirectInputKeyNames::Button106);
-const FKey FDirectInputKeys::Button107(FDirectInputKeyNames::Button107);
-const FKey FDirectInputKeys::Button108(FDirectInputKeyNames::Button108);
-const FKey FDirectInputKeys::Button109(FDirectInputKeyNames::Button109);
-const FKey FDirectInputKeys::Button110(FDirectInputKeyNames::Button110);
-const FKey FDirectInputKeys::Button111(FDirectInputKeyNames::Button111);
-const FKey FDirectInputKeys::Button112(FDirectInputKeyNames::Button112);
-const FKey FDirectInputKeys::Button113(FDirectInputKeyNames::Button113);
-const FKey FDirectInputKeys::Button114(FDirectInputKeyNames::Button114);
-const FKey FDirectInputKeys::Button115(FDirectInputKeyNames::Button115);
-const FKey FDirectInputKeys::Button116(FDirectInputKeyNames::Button116);
-const FKey FDirectInputKeys::Button117(FDirectInputKeyNames::Button117);
-const FKey FDirectInputKeys::Button118(FDirectInputKeyNames::Button118);
-const FKey FDirectInputKeys::Button119(FDirectInputKeyNames::Button119);
-const FKey FDirectInputKeys::Button120(FDirectInputKeyNames::Button120);
-const FKey FDirectInputKeys::Button121(FDirectInputKeyNames::Button121);
-const FKey FDirectInputKeys::Button122(FDirectInputKeyNames::Button122);
-const FKey FDirectInputKeys::Button123(FDirectInputKeyNames::Button123);
-const FKey FDirectInputKeys::Button124(FDirectInputKeyNames::Button124);
-const FKey FDirectInputKeys::Button125(FDirectInputKeyNames::Button125);
-const FKey FDirectInputKeys::Button126(FDirectInputKeyNames::Button126);
-const FKey FDirectInputKeys::Button127(FDirectInputKeyNames::Button127);
-const FKey FDirectInputKeys::Button128(FDirectInputKeyNames::Button128);
-
-const FKey FDirectInputKeys::Pov1(FDirectInputKeyNames::Pov1);
-const FKey FDirectInputKeys::Pov2(FDirectInputKeyNames::Pov2);
-const FKey FDirectInputKeys::Pov3(FDirectInputKeyNames::Pov3);
-const FKey FDirectInputKeys::Pov4(FDirectInputKeyNames::Pov4);
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "Bindings.h"
+#include "Misc/ConfigCacheIni.h"
+
+#define LOCTEXT_NAMESPACE "DirectInputPlugin"
+
+struct FPovDirectionDescription
+{
+	const TCHAR* Name;
+	const TCHAR* DisplayName;
+};
+
+// Clockwise from up, matching the direction index decoded from the POV value
+static constexpr FPovDirectionDescription PovDirectionDescriptions[FDirectInputKeys::NumPovDirections] =
+{
+	{ TEXT("Up"), TEXT("Up") },
+	{ TEXT("UpRight"), TEXT("Up Right") },
+	{ TEXT("Right"), TEXT("Right") },
+	{ TEXT("DownRight"), TEXT("Down Right") },
+	{ TEXT("Down"), TEXT("Down") },
+	{ TEXT("DownLeft"), TEXT("Down Left") },
+	{ TEXT("Left"), TEXT("Left") },
+	{ TEXT("UpLeft"), TEXT("Up Left") },
+};
+
+FDirectInputKeySet FDirectInputKeys::Shared;
+
+PRAGMA_DISABLE_DEPRECATION_WARNINGS
+#define DIRECTINPUT_DEFINE_LEGACY_KEY_NAME(Name) const FGamepadKeyNames::Type FDirectInputKeyNames::Name("DirectInput_" #Name);
+#define DIRECTINPUT_DEFINE_LEGACY_KEY(Name) const FKey FDirectInputKeys::Name(FDirectInputKeyNames::Name);
+DIRECTINPUT_LEGACY_KEYS(DIRECTINPUT_DEFINE_LEGACY_KEY_NAME)
+DIRECTINPUT_LEGACY_KEYS(DIRECTINPUT_DEFINE_LEGACY_KEY)
+#undef DIRECTINPUT_DEFINE_LEGACY_KEY_NAME
+#undef DIRECTINPUT_DEFINE_LEGACY_KEY
+PRAGMA_ENABLE_DEPRECATION_WARNINGS
+FName FDirectInputKeys::CombinedAxes[NumAxes];
+FName FDirectInputKeys::CombinedButtons[NumButtons];
+FName FDirectInputKeys::CombinedPovs[NumPovs];
+TMap<uint32, TUniquePtr<FDirectInputKeySet>> FDirectInputKeys::DeviceKeys;
+
+uint32 FDirectInputKeys::NumRegisteredCombinedAxes = 0;
+uint32 FDirectInputKeys::NumRegisteredCombinedButtons = 0;
+uint32 FDirectInputKeys::NumRegisteredCombinedPovs = 0;
+
+static const TCHAR* KeySlotSection = TEXT("DirectInput.KeySlots");
+
+void FDirectInputKeySet::Generate(const FString& Namespace, const FText& InDisplayPrefix, const FName InCategory)
+{
+	DisplayPrefix = InDisplayPrefix;
+	Category = InCategory;
+
+	for (uint32 Axis = 0; Axis < NumAxes; Axis++)
+	{
+		Axes[Axis] = FName(*FString::Printf(TEXT("DirectInput_%sAxis%d"), *Namespace, Axis + 1));
+	}
+
+	for (uint32 Button = 0; Button < NumButtons; Button++)
+	{
+		Buttons[Button] = FName(*FString::Printf(TEXT("DirectInput_%sButton%d"), *Namespace, Button + 1));
+	}
+
+	for (uint32 Pov = 0; Pov < NumPovs; Pov++)
+	{
+		Povs[Pov] = FName(*FString::Printf(TEXT("DirectInput_%sPov%d"), *Namespace, Pov + 1));
+		PovX[Pov] = FName(*FString::Printf(TEXT("DirectInput_%sPov%d_X"), *Namespace, Pov + 1));
+		PovY[Pov] = FName(*FString::Printf(TEXT("DirectInput_%sPov%d_Y"), *Namespace, Pov + 1));
+
+		for (uint32 Direction = 0; Direction < NumPovDirections; Direction++)
+		{
+			PovDirections[Pov * NumPovDirections + Direction] = FName(*FString::Printf(TEXT("DirectInput_%sPov%d_%s"), *Namespace, Pov + 1, PovDirectionDescriptions[Direction].Name));
+		}
+	}
+}
+
+void FDirectInputKeySet::Register(uint32 InNumAxes, uint32 InNumButtons, uint32 InNumPovs)
+{
+	InNumAxes = FMath::Min(InNumAxes, NumAxes);
+	InNumButtons = FMath::Min(InNumButtons, NumButtons);
+	InNumPovs = FMath::Min(InNumPovs, NumPovs);
+
+	for (; NumRegisteredAxes < InNumAxes; NumRegisteredAxes++)
+	{
+		const uint32 Axis = NumRegisteredAxes;
+		EKeys::AddKey(FKeyDetails(FKey(Axes[Axis]), FText::Format(LOCTEXT("DirectInput_Axis", "{0}Axis {1}"), DisplayPrefix, Axis + 1), FKeyDetails::ButtonAxis, Category));
+	}
+
+	for (; NumRegisteredButtons < InNumButtons; NumRegisteredButtons++)
+	{
+		const uint32 Button = NumRegisteredButtons;
+		EKeys::AddKey(FKeyDetails(FKey(Buttons[Button]), FText::Format(LOCTEXT("DirectInput_Button", "{0}Button {1}"), DisplayPrefix, Button + 1), FKeyDetails::GamepadKey, Category));
+	}
+
+	for (; NumRegisteredPovs < InNumPovs; NumRegisteredPovs++)
+	{
+		const uint32 Pov = NumRegisteredPovs;
+		EKeys::AddKey(FKeyDetails(FKey(Povs[Pov]), FText::Format(LOCTEXT("DirectInput_Pov", "{0}POV {1}"), DisplayPrefix, Pov + 1), FKeyDetails::Axis1D, Category));
+		EKeys::AddKey(FKeyDetails(FKey(PovX[Pov]), FText::Format(LOCTEXT("DirectInput_Pov_X", "{0}POV {1} X"), DisplayPrefix, Pov + 1), FKeyDetails::Axis1D, Category));
+		EKeys::AddKey(FKeyDetails(FKey(PovY[Pov]), FText::Format(LOCTEXT("DirectInput_Pov_Y", "{0}POV {1} Y"), DisplayPrefix, Pov + 1), FKeyDetails::Axis1D, Category));
+
+		for (uint32 Direction = 0; Direction < NumPovDirections; Direction++)
+		{
+			const FText DisplayName = FText::Format(LOCTEXT("DirectInput_Pov_Direction", "{0}POV {1} {2}"), DisplayPrefix, Pov + 1, FText::FromString(PovDirectionDescriptions[Direction].DisplayName));
+			EKeys::AddKey(FKeyDetails(FKey(PovDirections[Pov * NumPovDirections + Direction]), DisplayName, FKeyDetails::GamepadKey, Category));
+		}
+	}
+}
+
+void FDirectInputKeys::Initialize()
+{
+	Shared.Generate(FString(), FText::GetEmpty(), TEXT("DirectInput"));
+
+	for (uint32 Axis = 0; Axis < NumAxes; Axis++)
+	{
+		CombinedAxes[Axis] = FName(*FString::Printf(TEXT("DirectInput_Combined_Axis%d"), Axis + 1));
+	}
+
+	for (uint32 Button = 0; Button < NumButtons; Button++)
+	{
+		CombinedButtons[Button] = FName(*FString::Printf(TEXT("DirectInput_Combined_Button%d"), Button + 1));
+	}
+
+	for (uint32 Pov = 0; Pov < NumPovs; Pov++)
+	{
+		CombinedPovs[Pov] = FName(*FString::Printf(TEXT("DirectInput_Combined_Pov%d"), Pov + 1));
+	}
+}
+
+void FDirectInputKeys::RegisterCombinedKeys(uint32 InNumAxes, uint32 InNumButtons, uint32 InNumPovs)
+{
+	InNumAxes = FMath::Min(InNumAxes, NumAxes);
+	InNumButtons = FMath::Min(InNumButtons, NumButtons);
+	InNumPovs = FMath::Min(InNumPovs, NumPovs);
+
+	const FName NAME_DirectInput(TEXT("DirectInput"));
+
+	for (; NumRegisteredCombinedAxes < InNumAxes; NumRegisteredCombinedAxes++)
+	{
+		const uint32 Axis = NumRegisteredCombinedAxes;
+		EKeys::AddKey(FKeyDetails(FKey(CombinedAxes[Axis]), FText::Format(LOCTEXT("DirectInput_Combined_Axis", "Combined Axis {0}"), Axis + 1), FKeyDetails::ButtonAxis, NAME_DirectInput));
+	}
+
+	for (; NumRegisteredCombinedButtons < InNumButtons; NumRegisteredCombinedButtons++)
+	{
+		const uint32 Button = NumRegisteredCombinedButtons;
+		EKeys::AddKey(FKeyDetails(FKey(CombinedButtons[Button]), FText::Format(LOCTEXT("DirectInput_Combined_Button", "Combined Button {0}"), Button + 1), FKeyDetails::GamepadKey, NAME_DirectInput));
+	}
+
+	for (; NumRegisteredCombinedPovs < InNumPovs; NumRegisteredCombinedPovs++)
+	{
+		const uint32 Pov = NumRegisteredCombinedPovs;
+		EKeys::AddKey(FKeyDetails(FKey(CombinedPovs[Pov]), FText::Format(LOCTEXT("DirectInput_Combined_Pov", "Combined POV {0}"), Pov + 1), FKeyDetails::Axis1D, NAME_DirectInput));
+	}
+}
+
+uint32 FDirectInputKeys::GetDeviceSlot(const FGuid& InstanceGuid)
+{
+	const FString Instance = InstanceGuid.ToString();
+
+	int32 Slot = 0;
+	if (GConfig->GetInt(KeySlotSection, *Instance, Slot, GInputIni) && Slot > 0)
+	{
+		return Slot;
+	}
+
+	// Slots stay with the devices that had them, even while those are unplugged
+	TArray<FString> Entries;
+	GConfig->GetSection(KeySlotSection, Entries, GInputIni);
+
+	TSet<int32> Taken;
+	for (const FString& Entry : Entries)
+	{
+		FString Value;
+		if (Entry.Split(TEXT("="), nullptr, &Value))
+		{
+			Taken.Add(FCString::Atoi(*Value));
+		}
+	}
+
+	for (Slot = 1; Taken.Contains(Slot); Slot++)
+	{
+	}
+
+	GConfig->SetInt(KeySlotSection, *Instance, Slot, GInputIni);
+	GConfig->Flush(false, GInputIni);
+	return Slot;
+}
+
+const FDirectInputKeySet& FDirectInputKeys::RegisterDeviceKeys(const uint32 Slot, const FString& DeviceName, const uint32 InNumAxes, const uint32 InNumButtons, const uint32 InNumPovs)
+{
+	TUniquePtr<FDirectInputKeySet>& Keys = DeviceKeys.FindOrAdd(Slot);
+	if (!Keys.IsValid())
+	{
+		// Each slot gets a category of its own in the key selector, named after the device that first had it
+		const FName Category(*FString::Printf(TEXT("DirectInput_Dev%d"), Slot));
+		EKeys::AddMenuCategoryDisplayInfo(Category, FText::Format(LOCTEXT("DirectInput_DeviceCategory", "DirectInput {0}: {1}"), Slot, FText::FromString(DeviceName)), TEXT("GraphEditor.KeyEvent_16x"));
+
+		Keys = MakeUnique<FDirectInputKeySet>();
+		Keys->Generate(FString::Printf(TEXT("Dev%d_"), Slot), FText::Format(LOCTEXT("DirectInput_DevicePrefix", "Device {0} "), Slot), Category);
+	}
+
+	Keys->Register(InNumAxes, InNumButtons, InNumPovs);
+	return *Keys;
+}
+
+#undef LOCTEXT_NAMESPACE
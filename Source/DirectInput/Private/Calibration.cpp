@@ -0,0 +1,142 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "Calibration.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCalibration, Log, All);
+
+static constexpr uint32 CalibrationMagic = 0x4C434944; // 'DICL'
+static constexpr uint32 CalibrationVersion = 1;
+
+float FAxisCalibration::Normalize(const int32 Value) const
+{
+	float Result = 0.0f;
+
+	if (Value < Center && Center > Min)
+	{
+		Result = static_cast<float>(Value - Center) / static_cast<float>(Center - Min);
+	}
+	else if (Value > Center && Max > Center)
+	{
+		Result = static_cast<float>(Value - Center) / static_cast<float>(Max - Center);
+	}
+
+	Result = FMath::Clamp(Result, -1.0f, 1.0f);
+	return bInvert ? -Result : Result;
+}
+
+bool FCalibrationStore::Load(const FString& Filename)
+{
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *Filename, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Data);
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	uint32 Count = 0;
+	Reader << Magic << Version << Count;
+
+	if (Magic != CalibrationMagic || Version != CalibrationVersion)
+	{
+		UE_LOG(LogCalibration, Warning, TEXT("Ignoring %s, unknown format"), *Filename);
+		return false;
+	}
+
+	// Every profile takes at least its product and axis count, a count that can't fit in the rest of the file is corrupt
+	static constexpr int64 MinProfileSize = sizeof(FGuid) + sizeof(uint8);
+	if (Reader.IsError() || static_cast<int64>(Count) * MinProfileSize > Reader.TotalSize() - Reader.Tell())
+	{
+		UE_LOG(LogCalibration, Warning, TEXT("Ignoring %s, it claims %u profiles in %lld bytes"), *Filename, Count, Reader.TotalSize());
+		return false;
+	}
+
+	Profiles.Empty(Count);
+
+	for (uint32 Index = 0; Index < Count && !Reader.IsError(); Index++)
+	{
+		FGuid Product;
+		uint8 NumAxes = 0;
+		Reader << Product << NumAxes;
+
+		FCalibrationProfile Profile;
+		FMemory::Memzero(Profile);
+		Profile.NumAxes = FMath::Min<uint32>(NumAxes, FCalibrationProfile::MaxAxes);
+
+		for (uint32 Axis = 0; Axis < NumAxes; Axis++)
+		{
+			FAxisCalibration Calibration;
+			uint8 Flags = 0;
+			Reader << Calibration.Min << Calibration.Center << Calibration.Max << Flags;
+			Calibration.bInvert = Flags & 1;
+
+			if (Axis < Profile.NumAxes)
+			{
+				Profile.Axes[Axis] = Calibration;
+			}
+		}
+
+		Profiles.Add(Product, Profile);
+	}
+
+	if (Reader.IsError())
+	{
+		UE_LOG(LogCalibration, Warning, TEXT("Ignoring %s, file is truncated"), *Filename);
+		Profiles.Empty();
+		return false;
+	}
+
+	UE_LOG(LogCalibration, Display, TEXT("Loaded %d calibration profiles from %s"), Profiles.Num(), *Filename);
+	return true;
+}
+
+bool FCalibrationStore::Save(const FString& Filename) const
+{
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+
+	uint32 Magic = CalibrationMagic;
+	uint32 Version = CalibrationVersion;
+	uint32 Count = Profiles.Num();
+	Writer << Magic << Version << Count;
+
+	for (const TPair<FGuid, FCalibrationProfile>& Pair : Profiles)
+	{
+		FGuid Product = Pair.Key;
+		uint8 NumAxes = Pair.Value.NumAxes;
+		Writer << Product << NumAxes;
+
+		for (uint32 Axis = 0; Axis < NumAxes; Axis++)
+		{
+			FAxisCalibration Calibration = Pair.Value.Axes[Axis];
+			uint8 Flags = Calibration.bInvert ? 1 : 0;
+			Writer << Calibration.Min << Calibration.Center << Calibration.Max << Flags;
+		}
+	}
+
+	return FFileHelper::SaveArrayToFile(Data, *Filename);
+}
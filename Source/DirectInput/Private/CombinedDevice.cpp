@@ -0,0 +1,134 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "CombinedDevice.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCombinedDevice, Log, All);
+
+FCombinedDevice::FCombinedDevice() :
+	NumAxes(0),
+	NumButtons(0),
+	NumPovs(0),
+	StateIndex(0)
+{
+	FMemory::Memzero(States, sizeof(States));
+
+	// Hats start out centred
+	for (FState& State : States)
+	{
+		for (uint32& Pov : State.Povs)
+		{
+			Pov = MAXDWORD;
+		}
+	}
+}
+
+void FCombinedDevice::LoadConfig()
+{
+	LoadMappings(TEXT("CombinedAxis"), FJoystick::MaxAxes, AxisMappings, NumAxes);
+	LoadMappings(TEXT("CombinedButton"), FJoystick::MaxButtons, ButtonMappings, NumButtons);
+	LoadMappings(TEXT("CombinedPov"), FJoystick::MaxPovs, PovMappings, NumPovs);
+}
+
+void FCombinedDevice::LoadMappings(const TCHAR* Key, const uint32 MaxTarget, TArray<FMapping>& OutMappings, uint32& OutCount)
+{
+	OutMappings.Reset();
+	OutCount = 0;
+
+	TArray<FString> Entries;
+	GConfig->GetArray(TEXT("DirectInput"), Key, Entries, GInputIni);
+
+	for (const FString& Entry : Entries)
+	{
+		TArray<FString> Fields;
+		Entry.ParseIntoArray(Fields, TEXT(","));
+
+		FMapping Mapping;
+		if (Fields.Num() != 3 || !FGuid::Parse(Fields[0].TrimStartAndEnd(), Mapping.Product))
+		{
+			UE_LOG(LogCombinedDevice, Warning, TEXT("Ignoring %s=%s, expected <ProductGuid>,<Source>,<Target>"), Key, *Entry);
+			continue;
+		}
+
+		Mapping.Source = FCString::Atoi(*Fields[1]);
+		Mapping.Target = FCString::Atoi(*Fields[2]);
+		Mapping.DeviceIndex = INDEX_NONE;
+
+		if (Mapping.Target >= MaxTarget)
+		{
+			UE_LOG(LogCombinedDevice, Warning, TEXT("Ignoring %s=%s, target must be less than %d"), Key, *Entry, MaxTarget);
+			continue;
+		}
+
+		OutMappings.Add(Mapping);
+		OutCount = FMath::Max(OutCount, Mapping.Target + 1);
+	}
+}
+
+void FCombinedDevice::Bind(const FJoystickArray& Devices)
+{
+	for (TArray<FMapping>* Mappings : { &AxisMappings, &ButtonMappings, &PovMappings })
+	{
+		for (FMapping& Mapping : *Mappings)
+		{
+			Mapping.DeviceIndex = Devices.IndexOfByPredicate([&Mapping](const FJoystick& Joy)
+			{
+				return ToFGuid(Joy.GetProductGui()) == Mapping.Product;
+			});
+		}
+	}
+}
+
+bool FCombinedDevice::Merge(const FJoystickArray& Devices)
+{
+	// Objects of missing devices keep their last value
+	FState& Next = States[StateIndex ^ 1];
+	Next = States[StateIndex];
+
+	for (const FMapping& Mapping : AxisMappings)
+	{
+		if (Devices.IsValidIndex(Mapping.DeviceIndex))
+		{
+			Next.Axes[Mapping.Target] = FMath::RoundToInt(Devices[Mapping.DeviceIndex].GetCalibratedAxisValue(Mapping.Source));
+		}
+	}
+
+	for (const FMapping& Mapping : ButtonMappings)
+	{
+		if (Devices.IsValidIndex(Mapping.DeviceIndex))
+		{
+			const uint32 Bit = 1u << (Mapping.Target % 32);
+			uint32& Word = Next.Buttons[Mapping.Target / 32];
+			Word = Devices[Mapping.DeviceIndex].GetButtonValue(Mapping.Source) ? (Word | Bit) : (Word & ~Bit);
+		}
+	}
+
+	for (const FMapping& Mapping : PovMappings)
+	{
+		if (Devices.IsValidIndex(Mapping.DeviceIndex))
+		{
+			Next.Povs[Mapping.Target] = static_cast<uint32>(Devices[Mapping.DeviceIndex].GetPovValue(Mapping.Source));
+		}
+	}
+
+	StateIndex ^= 1;
+	return FMemory::Memcmp(&States[0], &States[1], sizeof(FState)) != 0;
+}
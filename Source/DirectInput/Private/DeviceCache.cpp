@@ -0,0 +1,241 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "DeviceCache.h"
+#include "Joystick.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogDeviceCache, Log, All);
+
+static constexpr uint32 DeviceCacheMagic = 0x43444944; // 'DIDC'
+static constexpr uint32 DeviceCacheVersion = 2;
+
+static FArchive& operator<<(FArchive& Ar, FDeviceObject& Object)
+{
+	uint8 Axis = static_cast<uint8>(Object.Axis);
+	Ar << Object.Type << Axis;
+	Object.Axis = static_cast<EDeviceAxis>(Axis);
+
+	return Ar << Object.Flags << Object.UsagePage << Object.Usage << Object.MaxForce << Object.ForceResolution << Object.RangeMin << Object.RangeMax << Object.Name;
+}
+
+static FArchive& operator<<(FArchive& Ar, FDeviceCacheKey& Key)
+{
+	return Ar << Key.Product << Key.FirmwareRevision << Key.HardwareRevision;
+}
+
+// Fewest bytes an entry (its key and object count) and an object (an empty name) take in the file
+static constexpr int64 MinEntrySize = sizeof(FGuid) + 3 * sizeof(uint32);
+static constexpr int64 MinObjectSize = 6 * sizeof(uint32) + 2 * sizeof(uint16) + sizeof(uint8) + sizeof(int32);
+
+static bool IsLoadedCountValid(FArchive& Ar, const int32 Num, const int64 MinSize)
+{
+	return !Ar.IsError() && Num >= 0 && Num * MinSize <= Ar.TotalSize() - Ar.Tell();
+}
+
+uint32 GetAxisIndices(const TArray<FDeviceObject>& Objects, const uint32 MaxAxes, TArray<int32>& OutIndices)
+{
+	static constexpr uint32 NumSliders = 2;
+	check(MaxAxes <= 32);
+
+	OutIndices.Init(INDEX_NONE, Objects.Num());
+	uint32 Taken = 0;
+	uint32 NumSlidersSeen = 0;
+
+	// Axes with a DIJOYSTATE member first, so the others can't take their index
+	for (int32 Index = 0; Index < Objects.Num(); Index++)
+	{
+		const FDeviceObject& Object = Objects[Index];
+		if (!(Object.Type & DIDFT_AXIS) || Object.Axis == EDeviceAxis::Unknown)
+		{
+			continue;
+		}
+
+		uint32 Axis = static_cast<uint32>(Object.Axis);
+		if (Object.Axis == EDeviceAxis::Slider)
+		{
+			if (NumSlidersSeen == NumSliders)
+			{
+				continue;
+			}
+			Axis += NumSlidersSeen++;
+		}
+
+		if (Axis < MaxAxes && !(Taken & (1u << Axis)))
+		{
+			OutIndices[Index] = Axis;
+			Taken |= 1u << Axis;
+		}
+	}
+
+	uint32 Free = 0;
+	for (int32 Index = 0; Index < Objects.Num(); Index++)
+	{
+		if (!(Objects[Index].Type & DIDFT_AXIS) || OutIndices[Index] != INDEX_NONE)
+		{
+			continue;
+		}
+
+		while (Free < MaxAxes && (Taken & (1u << Free)))
+		{
+			Free++;
+		}
+
+		if (Free < MaxAxes)
+		{
+			OutIndices[Index] = Free;
+			Taken |= 1u << Free;
+		}
+	}
+
+	return Taken != 0 ? FMath::FloorLog2(Taken) + 1 : 0;
+}
+
+FDeviceCacheKey::FDeviceCacheKey(const FGuid& InProduct, const uint32 InFirmwareRevision, const uint32 InHardwareRevision) :
+	Product(InProduct),
+	FirmwareRevision(InFirmwareRevision),
+	HardwareRevision(InHardwareRevision)
+{
+}
+
+bool FDeviceCacheKey::operator==(const FDeviceCacheKey& Other) const
+{
+	return Product == Other.Product && FirmwareRevision == Other.FirmwareRevision && HardwareRevision == Other.HardwareRevision;
+}
+
+uint32 GetTypeHash(const FDeviceCacheKey& Key)
+{
+	return HashCombine(GetTypeHash(Key.Product), HashCombine(Key.FirmwareRevision, Key.HardwareRevision));
+}
+
+bool FDeviceCache::Load(const FString& Filename)
+{
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *Filename, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Data);
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	Reader << Magic << Version;
+
+	if (Magic != DeviceCacheMagic || Version != DeviceCacheVersion)
+	{
+		UE_LOG(LogDeviceCache, Warning, TEXT("Ignoring %s, unknown format"), *Filename);
+		return false;
+	}
+
+	// Read the way TMap and TArray write themselves, but with every count checked against what is left of the file before
+	// anything is allocated for it, so a corrupt file can't make startup allocate all the memory there is
+	int32 NumEntries = 0;
+	Reader << NumEntries;
+	if (!IsLoadedCountValid(Reader, NumEntries, MinEntrySize))
+	{
+		Reader.SetError();
+	}
+	else
+	{
+		Entries.Empty(NumEntries);
+	}
+
+	for (int32 Index = 0; Index < NumEntries && !Reader.IsError(); Index++)
+	{
+		FDeviceCacheKey Key;
+		int32 NumObjects = 0;
+		Reader << Key << NumObjects;
+		if (!IsLoadedCountValid(Reader, NumObjects, MinObjectSize))
+		{
+			Reader.SetError();
+			break;
+		}
+
+		TArray<FDeviceObject>& Objects = Entries.Add(Key);
+		Objects.SetNum(NumObjects);
+		for (FDeviceObject& Object : Objects)
+		{
+			Reader << Object;
+		}
+	}
+
+	if (Reader.IsError())
+	{
+		UE_LOG(LogDeviceCache, Warning, TEXT("Ignoring %s, file is truncated"), *Filename);
+		Entries.Empty();
+		return false;
+	}
+
+	bDirty = false;
+	return true;
+}
+
+bool FDeviceCache::Save(const FString& Filename)
+{
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+
+	uint32 Magic = DeviceCacheMagic;
+	uint32 Version = DeviceCacheVersion;
+	Writer << Magic << Version << Entries;
+
+	if (!FFileHelper::SaveArrayToFile(Data, *Filename))
+	{
+		return false;
+	}
+
+	bDirty = false;
+	return true;
+}
+
+void FDeviceCache::Set(const FDeviceCacheKey& Key, const TArray<FDeviceObject>& Objects)
+{
+	Entries.Add(Key, Objects);
+	bDirty = true;
+}
+
+void FDeviceCache::GetMaxObjectCounts(uint32& OutNumAxes, uint32& OutNumButtons, uint32& OutNumPovs) const
+{
+	OutNumAxes = 0;
+	OutNumButtons = 0;
+	OutNumPovs = 0;
+
+	for (const TPair<FDeviceCacheKey, TArray<FDeviceObject>>& Entry : Entries)
+	{
+		TArray<int32> AxisIndices;
+		const uint32 NumAxes = GetAxisIndices(Entry.Value, FJoystick::MaxAxes, AxisIndices);
+		uint32 NumButtons = 0;
+		uint32 NumPovs = 0;
+
+		for (const FDeviceObject& Object : Entry.Value)
+		{
+			NumButtons += (Object.Type & DIDFT_BUTTON) ? 1 : 0;
+			NumPovs += (Object.Type & DIDFT_POV) ? 1 : 0;
+		}
+
+		OutNumAxes = FMath::Max(OutNumAxes, NumAxes);
+		OutNumButtons = FMath::Max(OutNumButtons, NumButtons);
+		OutNumPovs = FMath::Max(OutNumPovs, NumPovs);
+	}
+}
@@ -0,0 +1,180 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "DeviceFilter.h"
+#include "Joystick.h"
+#include "Algo/Find.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogDeviceFilter, Log, All);
+
+struct FDeviceTypeName
+{
+	const TCHAR* Name;
+	uint8 Type;
+};
+
+static const FDeviceTypeName DeviceTypeNames[] =
+{
+	{ TEXT("Device"), DI8DEVTYPE_DEVICE },
+	{ TEXT("Joystick"), DI8DEVTYPE_JOYSTICK },
+	{ TEXT("Gamepad"), DI8DEVTYPE_GAMEPAD },
+	{ TEXT("Driving"), DI8DEVTYPE_DRIVING },
+	{ TEXT("Flight"), DI8DEVTYPE_FLIGHT },
+	{ TEXT("FirstPerson"), DI8DEVTYPE_1STPERSON },
+	{ TEXT("Supplemental"), DI8DEVTYPE_SUPPLEMENTAL },
+	{ TEXT("Remote"), DI8DEVTYPE_REMOTE },
+	{ TEXT("DeviceControl"), DI8DEVTYPE_DEVICECTRL },
+};
+
+bool FDeviceRule::Matches(const FDeviceDescription& Device) const
+{
+	return (!Type.IsSet() || Type.GetValue() == Device.Type)
+		&& (!SubType.IsSet() || SubType.GetValue() == Device.SubType)
+		&& (!VendorId.IsSet() || VendorId.GetValue() == Device.VendorId)
+		&& (!ProductId.IsSet() || ProductId.GetValue() == Device.ProductId)
+		&& (!Product.IsSet() || Product.GetValue() == Device.Product);
+}
+
+// Hex with or without 0x, as vendor and product ids are written everywhere else, so 046D is never read as decimal
+static bool ParseHexNumber(const FString& Value, uint32& OutNumber)
+{
+	const FString Digits = Value.StartsWith(TEXT("0x"), ESearchCase::IgnoreCase) ? Value.Mid(2) : Value;
+	if (Digits.IsEmpty() || Digits.Len() > 8 || Digits.GetCharArray().ContainsByPredicate([](const TCHAR Char) { return Char != 0 && !FChar::IsHexDigit(Char); }))
+	{
+		return false;
+	}
+	OutNumber = FParse::HexNumber(*Digits);
+	return true;
+}
+
+// Decimal, or hex with 0x
+static bool ParseNumber(const FString& Value, uint32& OutNumber)
+{
+	if (Value.StartsWith(TEXT("0x"), ESearchCase::IgnoreCase))
+	{
+		return ParseHexNumber(Value, OutNumber);
+	}
+
+	if (!Value.IsNumeric())
+	{
+		return false;
+	}
+	OutNumber = FCString::Atoi(*Value);
+	return true;
+}
+
+// False if any field is unknown or malformed, a rule that silently matched more than meant would be worse
+static bool ParseRule(const FString& Entry, FDeviceRule& OutRule)
+{
+	TArray<FString> Fields;
+	Entry.ParseIntoArrayWS(Fields);
+
+	for (const FString& Field : Fields)
+	{
+		FString Key, Value;
+		if (!Field.Split(TEXT("="), &Key, &Value))
+		{
+			return false;
+		}
+
+		uint32 Number = 0;
+		if (Key.Equals(TEXT("Type"), ESearchCase::IgnoreCase))
+		{
+			const FDeviceTypeName* TypeName = Algo::FindByPredicate(DeviceTypeNames, [&Value](const FDeviceTypeName& Candidate) { return Value.Equals(Candidate.Name, ESearchCase::IgnoreCase); });
+			if (TypeName != nullptr)
+			{
+				OutRule.Type = TypeName->Type;
+			}
+			else if (ParseNumber(Value, Number))
+			{
+				OutRule.Type = static_cast<uint8>(Number);
+			}
+			else
+			{
+				return false;
+			}
+		}
+		else if (Key.Equals(TEXT("SubType"), ESearchCase::IgnoreCase) && ParseNumber(Value, Number))
+		{
+			OutRule.SubType = static_cast<uint8>(Number);
+		}
+		else if (Key.Equals(TEXT("Vid"), ESearchCase::IgnoreCase) && ParseHexNumber(Value, Number) && Number <= MAX_uint16)
+		{
+			OutRule.VendorId = static_cast<uint16>(Number);
+		}
+		else if (Key.Equals(TEXT("Pid"), ESearchCase::IgnoreCase) && ParseHexNumber(Value, Number) && Number <= MAX_uint16)
+		{
+			OutRule.ProductId = static_cast<uint16>(Number);
+		}
+		else if (Key.Equals(TEXT("Product"), ESearchCase::IgnoreCase))
+		{
+			FGuid Product;
+			if (!FGuid::Parse(Value, Product))
+			{
+				return false;
+			}
+			OutRule.Product = Product;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	return Fields.Num() > 0;
+}
+
+static void LoadRules(const TCHAR* Key, TArray<FDeviceRule>& OutRules)
+{
+	OutRules.Reset();
+
+	TArray<FString> Entries;
+	GConfig->GetArray(TEXT("DirectInput"), Key, Entries, GInputIni);
+
+	for (const FString& Entry : Entries)
+	{
+		FDeviceRule Rule;
+		if (!ParseRule(Entry, Rule))
+		{
+			UE_LOG(LogDeviceFilter, Warning, TEXT("Ignoring %s=%s, expected Type=<Name|Number>, SubType=<Number>, Vid=<Hex>, Pid=<Hex> or Product=<Guid>"), Key, *Entry);
+			continue;
+		}
+		OutRules.Add(Rule);
+	}
+}
+
+void FDeviceFilter::LoadConfig()
+{
+	LoadRules(TEXT("IncludeDevice"), Includes);
+	LoadRules(TEXT("ExcludeDevice"), Excludes);
+
+	if (Includes.Num() == 0)
+	{
+		Includes.AddDefaulted_GetRef().Type = static_cast<uint8>(DI8DEVTYPE_DRIVING);
+		Includes.AddDefaulted_GetRef().Type = static_cast<uint8>(DI8DEVTYPE_FLIGHT);
+	}
+}
+
+bool FDeviceFilter::IsIncluded(const FDeviceDescription& Device) const
+{
+	const auto Matches = [&Device](const FDeviceRule& Rule) { return Rule.Matches(Device); };
+	return Includes.ContainsByPredicate(Matches) && !Excludes.ContainsByPredicate(Matches);
+}
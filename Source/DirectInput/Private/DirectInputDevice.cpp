@@ -1,318 +1,838 @@
-﻿/* 
- * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
- * 
- * Permission is hereby granted, free of charge, to any person obtaining a copy of 
- * this software and associated documentation files (the "Software"), to deal in the 
- * Software without restriction, including without limitation the rights to use, copy, 
- * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
- * and to permit persons to whom the Software is furnished to do so, subject to the 
- * following conditions:
- *
- * The above copyright notice and this permission notice shall be included in all 
- * copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
- * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
- * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
- * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
- * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
- * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
-*/
-
-#include "DirectInputDevice.h"
-#include "Bindings.h"
-#include "Joystick.h"
-
-DEFINE_LOG_CATEGORY_STATIC(LogDirectInputDevice, Log, All);
-
-IDirectInput8* GInputObject = nullptr;
-TArray<FJoystick> GInputDevices;
-
-static BOOL CALLBACK StaticEnumerateDevice(LPCDIDEVICEINSTANCE deviceInstance, LPVOID pvRef)
-{
-	for (FJoystick& Joy : GInputDevices)
-	{
-		if (IsEqualGUID(deviceInstance->guidInstance, Joy.GetInstanceGuid()))
-			return DIENUM_CONTINUE;
-	}
-
-	// const auto Device = static_cast<FDirectInputDevice*>(pvRef);
-
-	LPDIRECTINPUTDEVICE8 InputDevice;
-	if (GInputObject->CreateDevice(deviceInstance->guidInstance, &InputDevice, nullptr) == DI_OK)
-	{
-		GInputDevices.Emplace(InputDevice);
-	}
-	return DIENUM_CONTINUE;
-}
-
-FDirectInputDevice::FDirectInputDevice(const TSharedRef<FGenericApplicationMessageHandler>& InMessageHandler) :
-	IDInputDevice(InMessageHandler),
-	TimeSinceLastCheck(0)
-{
-	AxisNames.AddDefaulted(8);
-	ButtonNames.AddDefaulted(128);
-	PovNames.AddDefaulted(4);
-
-	AxisNames[0] = FDirectInputKeyNames::Axis1;
-	AxisNames[1] = FDirectInputKeyNames::Axis2;
-	AxisNames[2] = FDirectInputKeyNames::Axis3;
-	AxisNames[3] = FDirectInputKeyNames::Axis4;
-	AxisNames[4] = FDirectInputKeyNames::Axis5;
-	AxisNames[5] = FDirectInputKeyNames::Axis6;
-	AxisNames[6] = FDirectInputKeyNames::Axis7;
-	AxisNames[7] = FDirectInputKeyNames::Axis8;
-
-	ButtonNames[0] = FDirectInputKeyNames::Button1;
-	ButtonNames[1] = FDirectInputKeyNames::Button2;
-	ButtonNames[2] = FDirectInputKeyNames::Button3;
-	ButtonNames[3] = FDirectInputKeyNames::Button4;
-	ButtonNames[4] = FDirectInputKeyNames::Button5;
-	ButtonNames[5] = FDirectInputKeyNames::Button6;
-	ButtonNames[6] = FDirectInputKeyNames::Button7;
-	ButtonNames[7] = FDirectInputKeyNames::Button8;
-	ButtonNames[8] = FDirectInputKeyNames::Button9;
-	ButtonNames[9] = FDirectInputKeyNames::Button10;
-	ButtonNames[10] = FDirectInputKeyNames::Button11;
-	ButtonNames[11] = FDirectInputKeyNames::Button12;
-	ButtonNames[12] = FDirectInputKeyNames::Button13;
-	ButtonNames[13] = FDirectInputKeyNames::Button14;
-	ButtonNames[14] = FDirectInputKeyNames::Button15;
-	ButtonNames[15] = FDirectInputKeyNames::Button16;
-	ButtonNames[16] = FDirectInputKeyNames::Button17;
-	ButtonNames[17] = FDirectInputKeyNames::Button18;
-	ButtonNames[18] = FDirectInputKeyNames::Button19;
-	ButtonNames[19] = FDirectInputKeyNames::Button20;
-	ButtonNames[20] = FDirectInputKeyNames::Button21;
-	ButtonNames[21] = FDirectInputKeyNames::Button22;
-	ButtonNames[22] = FDirectInputKeyNames::Button23;
-	ButtonNames[23] = FDirectInputKeyNames::Button24;
-	ButtonNames[24] = FDirectInputKeyNames::Button25;
-	ButtonNames[25] = FDirectInputKeyNames::Button26;
-	ButtonNames[26] = FDirectInputKeyNames::Button27;
-	ButtonNames[27] = FDirectInputKeyNames::Button28;
-	ButtonNames[28] = FDirectInputKeyNames::Button29;
-	ButtonNames[29] = FDirectInputKeyNames::Button30;
-	ButtonNames[30] = FDirectInputKeyNames::Button31;
-	ButtonNames[31] = FDirectInputKeyNames::Button32;
-	ButtonNames[32] = FDirectInputKeyNames::Button33;
-	ButtonNames[33] = FDirectInputKeyNames::Button34;
-	ButtonNames[34] = FDirectInputKeyNames::Button35;
-	ButtonNames[35] = FDirectInputKeyNames::Button36;
-	ButtonNames[36] = FDirectInputKeyNames::Button37;
-	ButtonNames[37] = FDirectInputKeyNames::Button38;
-	ButtonNames[38] = FDirectInputKeyNames::Button39;
-	ButtonNames[39] = FDirectInputKeyNames::Button40;
-	ButtonNames[40] = FDirectInputKeyNames::Button41;
-	ButtonNames[41] = FDirectInputKeyNames::Button42;
-	ButtonNames[42] = FDirectInputKeyNames::Button43;
-	ButtonNames[43] = FDirectInputKeyNames::Button44;
-	ButtonNames[44] = FDirectInputKeyNames::Button45;
-	ButtonNames[45] = FDirectInputKeyNames::Button46;
-	ButtonNames[46] = FDirectInputKeyNames::Button47;
-	ButtonNames[47] = FDirectInputKeyNames::Button48;
-	ButtonNames[48] = FDirectInputKeyNames::Button49;
-	ButtonNames[49] = FDirectInputKeyNames::Button50;
-	ButtonNames[50] = FDirectInputKeyNames::Button51;
-	ButtonNames[51] = FDirectInputKeyNames::Button52;
-	ButtonNames[52] = FDirectInputKeyNames::Button53;
-	ButtonNames[53] = FDirectInputKeyNames::Button54;
-	ButtonNames[54] = FDirectInputKeyNames::Button55;
-	ButtonNames[55] = FDirectInputKeyNames::Button56;
-	ButtonNames[56] = FDirectInputKeyNames::Button57;
-	ButtonNames[57] = FDirectInputKeyNames::Button58;
-	ButtonNames[58] = FDirectInputKeyNames::Button59;
-	ButtonNames[59] = FDirectInputKeyNames::Button60;
-	ButtonNames[60] = FDirectInputKeyNames::Button61;
-	ButtonNames[61] = FDirectInputKeyNames::Button62;
-	ButtonNames[62] = FDirectInputKeyNames::Button63;
-	ButtonNames[63] = FDirectInputKeyNames::Button64;
-	ButtonNames[64] = FDirectInputKeyNames::Button65;
-	ButtonNames[65] = FDirectInputKeyNames::Button66;
-	ButtonNames[66] = FDirectInputKeyNames::Button67;
-	ButtonNames[67] = FDirectInputKeyNames::Button68;
-	ButtonNames[68] = FDirectInputKeyNames::Button69;
-	ButtonNames[69] = FDirectInputKeyNames::Button70;
-	ButtonNames[70] = FDirectInputKeyNames::Button71;
-	ButtonNames[71] = FDirectInputKeyNames::Button72;
-	ButtonNames[72] = FDirectInputKeyNames::Button73;
-	ButtonNames[73] = FDirectInputKeyNames::Button74;
-	ButtonNames[74] = FDirectInputKeyNames::Button75;
-	ButtonNames[75] = FDirectInputKeyNames::Button76;
-	ButtonNames[76] = FDirectInputKeyNames::Button77;
-	ButtonNames[77] = FDirectInputKeyNames::Button78;
-	ButtonNames[78] = FDirectInputKeyNames::Button79;
-	ButtonNames[79] = FDirectInputKeyNames::Button80;
-	ButtonNames[80] = FDirectInputKeyNames::Button81;
-	ButtonNames[81] = FDirectInputKeyNames::Button82;
-	ButtonNames[82] = FDirectInputKeyNames::Button83;
-	ButtonNames[83] = FDirectInputKeyNames::Button84;
-	ButtonNames[84] = FDirectInputKeyNames::Button85;
-	ButtonNames[85] = FDirectInputKeyNames::Button86;
-	ButtonNames[86] = FDirectInputKeyNames::Button87;
-	ButtonNames[87] = FDirectInputKeyNames::Button88;
-	ButtonNames[88] = FDirectInputKeyNames::Button89;
-	ButtonNames[89] = FDirectInputKeyNames::Button90;
-	ButtonNames[90] = FDirectInputKeyNames::Button91;
-	ButtonNames[91] = FDirectInputKeyNames::Button92;
-	ButtonNames[92] = FDirectInputKeyNames::Button93;
-	ButtonNames[93] = FDirectInputKeyNames::Button94;
-	ButtonNames[94] = FDirectInputKeyNames::Button95;
-	ButtonNames[95] = FDirectInputKeyNames::Button96;
-	ButtonNames[96] = FDirectInputKeyNames::Button97;
-	ButtonNames[97] = FDirectInputKeyNames::Button98;
-	ButtonNames[98] = FDirectInputKeyNames::Button99;
-	ButtonNames[99] = FDirectInputKeyNames::Button100;
-	ButtonNames[100] = FDirectInputKeyNames::Button101;
-	ButtonNames[101] = FDirectInputKeyNames::Button102;
-	ButtonNames[102] = FDirectInputKeyNames::Button103;
-	ButtonNames[103] = FDirectInputKeyNames::Button104;
-	ButtonNames[104] = FDirectInputKeyNames::Button105;
-	ButtonNames[105] = FDirectInputKeyNames::Button106;
-	ButtonNames[106] = FDirectInputKeyNames::Button107;
-	ButtonNames[107] = FDirectInputKeyNames::Button108;
-	ButtonNames[108] = FDirectInputKeyNames::Button109;
-	ButtonNames[109] = FDirectInputKeyNames::Button110;
-	ButtonNames[110] = FDirectInputKeyNames::Button111;
-	ButtonNames[111] = FDirectInputKeyNames::Button112;
-	ButtonNames[112] = FDirectInputKeyNames::Button113;
-	ButtonNames[113] = FDirectInputKeyNames::Button114;
-	ButtonNames[114] = FDirectInputKeyNames::Button115;
-	ButtonNames[115] = FDirectInputKeyNames::Button116;
-	ButtonNames[116] = FDirectInputKeyNames::Button117;
-	ButtonNames[117] = FDirectInputKeyNames::Button118;
-	ButtonNames[118] = FDirectInputKeyNames::Button119;
-	ButtonNames[119] = FDirectInputKeyNames::Button120;
-	ButtonNames[120] = FDirectInputKeyNames::Button121;
-	ButtonNames[121] = FDirectInputKeyNames::Button122;
-	ButtonNames[122] = FDirectInputKeyNames::Button123;
-	ButtonNames[123] = FDirectInputKeyNames::Button124;
-	ButtonNames[124] = FDirectInputKeyNames::Button125;
-	ButtonNames[125] = FDirectInputKeyNames::Button126;
-	ButtonNames[126] = FDirectInputKeyNames::Button127;
-	ButtonNames[127] = FDirectInputKeyNames::Button128;
-
-	PovNames[0] = FDirectInputKeyNames::Pov1;
-	PovNames[1] = FDirectInputKeyNames::Pov2;
-	PovNames[2] = FDirectInputKeyNames::Pov3;
-	PovNames[3] = FDirectInputKeyNames::Pov4;
-	
-	if (DirectInput8Create(GetModuleHandle(nullptr), DIRECTINPUT_VERSION, IID_IDirectInput8, (void**)&GInputObject, nullptr) == DI_OK)
-	{
-		// Only enumerate devices meant for driving or flying that are currently attached
-		GInputObject->EnumDevices(DI8DEVTYPE_DRIVING | DI8DEVTYPE_FLIGHT, &StaticEnumerateDevice, this, DIEDFL_ATTACHEDONLY);
-	}
-}
-
-FDirectInputDevice::~FDirectInputDevice()
-{
-	GInputDevices.Empty();
-}
-
-void FDirectInputDevice::Tick(float DeltaTime)
-{
-	TimeSinceLastCheck += DeltaTime;
-	if (GInputObject != nullptr && TimeSinceLastCheck > 60)
-	{
-		TimeSinceLastCheck = 0;
-		GInputObject->EnumDevices(DI8DEVTYPE_DRIVING, &StaticEnumerateDevice, this, DIEDFL_ATTACHEDONLY);
-	}
-}
-
-void FDirectInputDevice::SendControllerEvents()
-{
-	// Don't run if in editor
-	if (GEngine->IsEditor())
-	{
-		return;
-	}
-
-	int32 ControllerId = 0;
-	for (FJoystick& Joy : GInputDevices)
-	{
-		FInputDeviceScope InputScope(this, DirectInputInterfaceName, ControllerId, Joy.GetInstanceName());
-		
-		Joy.Poll();
-
-		for (uint32 Axis = 0; Axis < Joy.GetNumAxes(); Axis++)
-		{
-			if (Joy.IsAxisChanged(Axis))
-			{
-				const int32 Value = Joy.GetAxisValue(Axis);
-				//UE_LOG(LogDirectInputDevice, Log, TEXT("ControllerId %d Axis %d : %d"), ControllerId, Axis, Value);
-				MessageHandler->OnControllerAnalog(AxisNames[Axis], ControllerId, Value);
-			}
-		}
-		
-		for (uint32 Button = 0; Button < Joy.GetNumButtons(); Button++)
-		{
-			if (Joy.IsButtonChanged(Button))
-			{
-				if (Joy.GetButtonValue(Button))
-				{
-					//UE_LOG(LogDirectInputDevice, Log, TEXT("ControllerId %d Button %d : pressed"), ControllerId, Button);
-					MessageHandler->OnControllerButtonPressed(ButtonNames[Button], ControllerId, false);
-				}
-				else
-				{
-					//UE_LOG(LogDirectInputDevice, Log, TEXT("ControllerId %d Button %d : released"), ControllerId, Button);
-					MessageHandler->OnControllerButtonReleased(ButtonNames[Button], ControllerId, false);
-				}
-			}
-		}
-
-		for (uint32 Pov = 0; Pov < Joy.GetNumPovs(); Pov++)
-		{
-			if (Joy.IsPovChanged(Pov))
-			{
-				const uint32 Value = Joy.GetPovValue(Pov);
-				//UE_LOG(LogDirectInputDevice, Log, TEXT("ControllerId %d POV %d : %d"), ControllerId, Pov, Value);
-				MessageHandler->OnControllerAnalog(PovNames[Pov], ControllerId, Value);
-			}
-		}
-
-		ControllerId++;
-	}
-}
-
-void FDirectInputDevice::SetMessageHandler(const TSharedRef<FGenericApplicationMessageHandler>& InMessageHandler)
-{
-	MessageHandler = InMessageHandler;
-}
-
-bool FDirectInputDevice::Exec(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar)
-{
-	return false;
-}
-
-void FDirectInputDevice::SetChannelValue(int32 ControllerId, FForceFeedbackChannelType ChannelType, float Value)
-{
-	switch (ChannelType)
-	{
-	case FForceFeedbackChannelType::LEFT_LARGE:
-		if (ControllerId < GInputDevices.Num())
-		{
-			GInputDevices[ControllerId].UpdateEffect(Value);
-		}
-		break;
-	case FForceFeedbackChannelType::LEFT_SMALL:
-		// NOP
-		break;
-	case FForceFeedbackChannelType::RIGHT_LARGE:
-		// NOP
-		break;
-	case FForceFeedbackChannelType::RIGHT_SMALL:
-		// NOP
-		break;
-	default:
-		break;
-	}
-}
-
-void FDirectInputDevice::SetChannelValues(int32 ControllerId, const FForceFeedbackValues& Values)
-{
-	if (ControllerId < GInputDevices.Num())
-	{
-		GInputDevices[ControllerId].UpdateEffect(Values.LeftLarge);
-	}
-}
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "DirectInputDevice.h"
+#include "Benchmark.h"
+#include "Bindings.h"
+#include "CombinedDevice.h"
+#include "DeviceFilter.h"
+#include "ForceEffect.h"
+#include "ForceFeedbackThread.h"
+#include "Joystick.h"
+#include "SoakTest.h"
+#include "TelemetryPublisher.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogDirectInputDevice, Log, All);
+
+DECLARE_CYCLE_STAT(TEXT("Poll"), STAT_DirectInput_Poll, STATGROUP_DirectInput);
+DECLARE_CYCLE_STAT(TEXT("Normalize"), STAT_DirectInput_Normalize, STATGROUP_DirectInput);
+DECLARE_CYCLE_STAT(TEXT("Dispatch"), STAT_DirectInput_Dispatch, STATGROUP_DirectInput);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Driver calls"), STAT_DirectInput_DriverCalls, STATGROUP_DirectInput);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Driver calls saved"), STAT_DirectInput_DriverCallsSaved, STATGROUP_DirectInput);
+
+IDirectInput8* GInputObject = nullptr;
+FJoystickArray GInputDevices;
+// Held while devices are added or swapped, so the force feedback thread never sees the array change under it
+FCriticalSection GInputDevicesLock;
+FAxisNormalizer GAxisNormalizer;
+
+static_assert(FJoystick::MaxAxes <= FDirectInputKeys::NumAxes, "Every axis needs a key");
+static_assert(FJoystick::MaxButtons <= FDirectInputKeys::NumButtons, "Every button needs a key");
+static_assert(FJoystick::MaxPovs <= FDirectInputKeys::NumPovs, "Every POV needs a key");
+static_assert(FJoystick::NumPovDirections == FDirectInputKeys::NumPovDirections, "Every POV direction needs a key");
+
+// X and Y for each POV direction clockwise from up, the last entry is centred
+static const float PovAxisTable[FJoystick::NumPovDirections + 1][2] =
+{
+	{  0.0f,  1.0f },
+	{  1.0f,  1.0f },
+	{  1.0f,  0.0f },
+	{  1.0f, -1.0f },
+	{  0.0f, -1.0f },
+	{ -1.0f, -1.0f },
+	{ -1.0f,  0.0f },
+	{ -1.0f,  1.0f },
+	{  0.0f,  0.0f },
+};
+
+static FDeviceDescription DescribeDevice(LPCDIDEVICEINSTANCE deviceInstance)
+{
+	// HID devices have the vendor ID in the low word of the product GUID and the product ID in the high word
+	FDeviceDescription Description;
+	Description.Type = static_cast<uint8>(GET_DIDEVICE_TYPE(deviceInstance->dwDevType));
+	Description.SubType = static_cast<uint8>(GET_DIDEVICE_SUBTYPE(deviceInstance->dwDevType));
+	Description.VendorId = LOWORD(deviceInstance->guidProduct.Data1);
+	Description.ProductId = HIWORD(deviceInstance->guidProduct.Data1);
+	Description.Product = ToFGuid(deviceInstance->guidProduct);
+	Description.Name = deviceInstance->tszInstanceName;
+	return Description;
+}
+
+static BOOL CALLBACK StaticEnumerateDevice(LPCDIDEVICEINSTANCE deviceInstance, LPVOID pvRef)
+{
+	for (FJoystick& Joy : GInputDevices)
+	{
+		if (IsEqualGUID(deviceInstance->guidInstance, Joy.GetInstanceGuid()))
+			return DIENUM_CONTINUE;
+	}
+
+	// Devices the rules leave out are never created, acquired or polled
+	const FDeviceDescription Description = DescribeDevice(deviceInstance);
+	if (!FDirectInputModule::Get().GetDeviceFilter().IsIncluded(Description))
+	{
+		UE_LOG(LogDirectInputDevice, Verbose, TEXT("Skipping %s (type 0x%02X/%d, VID 0x%04X, PID 0x%04X)"), *Description.Name, Description.Type, Description.SubType, Description.VendorId, Description.ProductId);
+		return DIENUM_CONTINUE;
+	}
+
+	const auto Device = static_cast<FDirectInputDevice*>(pvRef);
+
+	LPDIRECTINPUTDEVICE8 InputDevice;
+	if (GInputObject->CreateDevice(deviceInstance->guidInstance, &InputDevice, nullptr) == DI_OK)
+	{
+		FScopeLock Lock(&GInputDevicesLock);
+
+		FJoystick& Joy = GInputDevices.Emplace_GetRef(InputDevice, &FDirectInputModule::Get().GetDeviceCache());
+		if (Device->GetHistoryCapacity() > 0)
+		{
+			Joy.EnableHistory(Device->GetHistoryCapacity());
+		}
+		Joy.SetSnapshot(FDirectInputModule::Get().GetSnapshot(GInputDevices.Num() - 1));
+		Joy.SetTelemetry(Device->GetTelemetry(), GInputDevices.Num() - 1);
+		Joy.SetNormalizer(&GAxisNormalizer, Device->GetDeadZone());
+		Joy.GetSchedule().Interval = Device->GetScheduler().GetInterval(ToFGuid(Joy.GetProductGui()));
+
+		if (Device->IsPerDeviceKeys())
+		{
+			const uint32 Slot = FDirectInputKeys::GetDeviceSlot(ToFGuid(Joy.GetInstanceGuid()));
+			Joy.SetKeys(FDirectInputKeys::RegisterDeviceKeys(Slot, Joy.GetInstanceName(), Joy.GetNumAxes(), Joy.GetNumButtons(), Joy.GetNumPovs()));
+		}
+		else
+		{
+			FDirectInputKeys::RegisterKeys(Joy.GetNumAxes(), Joy.GetNumButtons(), Joy.GetNumPovs());
+		}
+		Joy.ApplyRemap(FDirectInputModule::Get().GetRemaps().Find(ToFGuid(Joy.GetProductGui())));
+		Joy.SetFilters(FDirectInputModule::Get().GetFilters().Find(ToFGuid(Joy.GetProductGui())));
+
+		if (const FCalibrationProfile* Profile = FDirectInputModule::Get().GetCalibration().Find(ToFGuid(Joy.GetProductGui())))
+		{
+			Joy.ApplyCalibration(*Profile);
+		}
+	}
+	return DIENUM_CONTINUE;
+}
+
+FDirectInputDevice::FDirectInputDevice(const TSharedRef<FGenericApplicationMessageHandler>& InMessageHandler) :
+	IDInputDevice(InMessageHandler),
+	TimeSinceLastCheck(0),
+	HistoryCapacity(0),
+	DeadZone(0.0f),
+	bPerDeviceKeys(false),
+	Combined(MakeUnique<FCombinedDevice>()),
+	CombinedControllerId(FDirectInputModule::MaxControllers),
+	ForceFeedbackRate(0),
+	bForceFeedbackSuspended(false)
+{
+	// Number of samples kept per device for time based queries, 0 disables the history
+	int32 ConfigHistoryCapacity = 0;
+	GConfig->GetInt(TEXT("DirectInput"), TEXT("HistoryCapacity"), ConfigHistoryCapacity, GInputIni);
+	HistoryCapacity = FMath::Max(ConfigHistoryCapacity, 0);
+
+	// Fraction of each side of the centre that reads as centred in the normalised axes
+	GConfig->GetFloat(TEXT("DirectInput"), TEXT("DeadZone"), DeadZone, GInputIni);
+
+	// Keys for each device slot, so bindings tell devices apart by key rather than by controller id
+	GConfig->GetBool(TEXT("DirectInput"), TEXT("PerDeviceKeys"), bPerDeviceKeys, GInputIni);
+
+	// Objects of several devices merged into one controller with its own keys, on an id past the physical devices by default
+	Combined->LoadConfig();
+	GConfig->GetInt(TEXT("DirectInput"), TEXT("CombinedControllerId"), CombinedControllerId, GInputIni);
+	FDirectInputKeys::RegisterCombinedKeys(Combined->GetNumAxes(), Combined->GetNumButtons(), Combined->GetNumPovs());
+
+	// Priority classes, idle backoff and throttling of the device reads
+	Scheduler.LoadConfig();
+
+	// Shared memory the state of each device is published to for external tools, off unless named
+	FString TelemetryName;
+	if (GConfig->GetString(TEXT("DirectInput"), TEXT("TelemetryName"), TelemetryName, GInputIni) && !TelemetryName.IsEmpty())
+	{
+		Telemetry = MakeUnique<FTelemetryPublisher>();
+		if (!Telemetry->Open(TelemetryName))
+		{
+			Telemetry.Reset();
+		}
+	}
+
+	if (DirectInput8Create(GetModuleHandle(nullptr), DIRECTINPUT_VERSION, IID_IDirectInput8, (void**)&GInputObject, nullptr) == DI_OK)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+
+		// Every attached game controller is enumerated, the device filter decides which are created
+		GInputObject->EnumDevices(DI8DEVCLASS_GAMECTRL, &StaticEnumerateDevice, this, DIEDFL_ATTACHEDONLY);
+
+		UE_LOG(LogDirectInputDevice, Display, TEXT("Initialized %d devices in %.1f ms"), GInputDevices.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+		FDirectInputModule::Get().SaveDeviceCache();
+		Combined->Bind(GInputDevices);
+	}
+
+	// Ticks per second of the force feedback thread, 0 updates the forces on the game thread as they are set
+	int32 ConfigForceFeedbackRate = 0;
+	GConfig->GetInt(TEXT("DirectInput"), TEXT("ForceFeedbackRate"), ConfigForceFeedbackRate, GInputIni);
+	ForceFeedbackRate = FMath::Max(ConfigForceFeedbackRate, 0);
+	if (ForceFeedbackRate > 0)
+	{
+		ForceFeedback = MakeUnique<FForceFeedbackThread>(ForceFeedbackRate, ForceFeedbackCallback);
+	}
+}
+
+FDirectInputDevice::~FDirectInputDevice()
+{
+	Soak.Reset();
+	ForceFeedback.Reset();
+	GInputDevices.Empty();
+	GAxisNormalizer.Reset();
+}
+
+void FDirectInputDevice::Tick(float DeltaTime)
+{
+	if (Soak.IsValid())
+	{
+		// Runs the soak frames due since the last tick in place of polling the connected devices
+		Soak->Tick();
+
+		// The connected devices are put back when the soak test is destroyed, found devices would join the simulated ones
+		if (Soak->IsDone())
+		{
+			const FSoakTestResult& Result = Soak->GetResult();
+			UE_LOG(LogDirectInputDevice, Display, TEXT("Soak %s: %llu frames, %llu edges, %llu lost, %llu duplicate, %llu disconnects, %llu failed reacquires, report %s"),
+				Result.IsPassed() ? TEXT("passed") : TEXT("FAILED"), Result.NumFrames, Result.NumEdges, Result.NumLostEdges, Result.NumDuplicateEdges,
+				Result.NumDisconnects, Result.NumAcquireFailures, Result.ReportPath.IsEmpty() ? TEXT("not saved") : *Result.ReportPath);
+			Soak.Reset();
+		}
+		return;
+	}
+
+	TimeSinceLastCheck += DeltaTime;
+	if (GInputObject != nullptr && TimeSinceLastCheck > 60)
+	{
+		TimeSinceLastCheck = 0;
+		GInputObject->EnumDevices(DI8DEVCLASS_GAMECTRL, &StaticEnumerateDevice, this, DIEDFL_ATTACHEDONLY);
+		FDirectInputModule::Get().SaveDeviceCache();
+		Combined->Bind(GInputDevices);
+	}
+}
+
+void FDirectInputDevice::SendControllerEvents()
+{
+	// Don't run if in editor, or while the soak test polls its simulated devices
+	if (GEngine->IsEditor() || Soak.IsValid())
+	{
+		return;
+	}
+
+	SendDeviceEvents();
+}
+
+void FDirectInputDevice::SendDeviceEvents()
+{
+	// Poll every device that is due first so their axes are normalised together in one pass
+	TArray<bool, TInlineAllocator<FDirectInputModule::MaxControllers>> Polled;
+	Polled.SetNumUninitialized(GInputDevices.Num());
+	{
+		SCOPE_CYCLE_COUNTER(STAT_DirectInput_Poll);
+		Scheduler.BeginFrame();
+
+		// Compared to calling Poll and GetDeviceState on every device every frame
+		uint32 NumCalls = 0;
+		uint32 NumSavedCalls = 0;
+
+		for (int32 ControllerId = 0; ControllerId < GInputDevices.Num(); ControllerId++)
+		{
+			FJoystick& Joy = GInputDevices[ControllerId];
+			const uint32 CallsPerRead = Joy.IsPolledDevice() ? 2 : 1;
+
+			if (Scheduler.IsDue(Joy.GetSchedule()))
+			{
+				Polled[ControllerId] = Joy.Poll();
+				NumCalls += CallsPerRead;
+				NumSavedCalls += 2 - CallsPerRead;
+			}
+			else
+			{
+				Polled[ControllerId] = false;
+				NumSavedCalls += 2;
+			}
+		}
+
+		Scheduler.RecordCalls(NumCalls, NumSavedCalls);
+		SET_DWORD_STAT(STAT_DirectInput_DriverCalls, NumCalls);
+		SET_DWORD_STAT(STAT_DirectInput_DriverCallsSaved, NumSavedCalls);
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_DirectInput_Normalize);
+		GAxisNormalizer.Convert();
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_DirectInput_Dispatch);
+
+	for (int32 ControllerId = 0; ControllerId < GInputDevices.Num(); ControllerId++)
+	{
+		FJoystick& Joy = GInputDevices[ControllerId];
+
+		// Streams are uploaded every frame whether the device was read or not
+		Joy.UpdateForceStream();
+
+		// A failed or skipped poll keeps the last state, and an idle device has nothing to diff
+		if (!Polled[ControllerId])
+		{
+			continue;
+		}
+
+		Joy.PublishState();
+
+		// Software conditions follow the position at the poll rate, added to the constant force
+		if (Joy.HasSoftwareConditions())
+		{
+			const float ConditionForce = Joy.SynthesizeConditions(FPlatformTime::Seconds());
+			if (ForceFeedback.IsValid())
+			{
+				ForceFeedback->SetConditionForce(ControllerId, ConditionForce);
+			}
+			else
+			{
+				Joy.SetConstantForce(Joy.GetConstantForce());
+			}
+		}
+
+		const bool bChanged = Joy.IsStateChanged();
+		Scheduler.RecordRead(Joy.GetSchedule(), bChanged);
+		if (!bChanged)
+		{
+			continue;
+		}
+
+		// Only devices with events to send go near their name
+		FInputDeviceScope InputScope(this, DirectInputInterfaceName, ControllerId, Joy.GetInstanceName());
+
+		// Keys, inversion and combined axes come from the device's compiled remap table
+		const FRemapTable& Remap = Joy.GetRemap();
+		uint32 ChangedCombinedAxes = 0;
+
+		for (uint32 Axis = 0; Axis < Joy.GetNumAxes(); Axis++)
+		{
+			if (Joy.IsAxisChanged(Axis))
+			{
+				const FRemapTable::FAxis& Entry = Remap.Axes[Axis];
+				if (Entry.Combine != INDEX_NONE)
+				{
+					ChangedCombinedAxes |= 1u << Entry.Combine;
+				}
+				else if (!Entry.Key.IsNone())
+				{
+					const float Value = Joy.GetCalibratedAxisValue(Axis);
+					//UE_LOG(LogDirectInputDevice, Log, TEXT("ControllerId %d Axis %d : %f"), ControllerId, Axis, Value);
+					MessageHandler->OnControllerAnalog(Entry.Key, ControllerId, Entry.Offset + Entry.Scale * Value);
+				}
+			}
+		}
+
+		for (uint32 Axis = 0; ChangedCombinedAxes != 0; Axis++, ChangedCombinedAxes >>= 1)
+		{
+			if (ChangedCombinedAxes & 1)
+			{
+				MessageHandler->OnControllerAnalog(Remap.Axes[Axis].Key, ControllerId, Joy.GetCombinedAxisValue(Axis));
+			}
+		}
+		
+		for (uint32 Button = 0; Button < Joy.GetNumButtons(); Button++)
+		{
+			const FRemapTable::FButton& Entry = Remap.Buttons[Button];
+			if (Joy.IsButtonChanged(Button) && !Entry.Key.IsNone())
+			{
+				if (Joy.GetButtonValue(Button) != static_cast<int32>(Entry.bInvert))
+				{
+					//UE_LOG(LogDirectInputDevice, Log, TEXT("ControllerId %d Button %d : pressed"), ControllerId, Button);
+					MessageHandler->OnControllerButtonPressed(Entry.Key, ControllerId, false);
+				}
+				else
+				{
+					//UE_LOG(LogDirectInputDevice, Log, TEXT("ControllerId %d Button %d : released"), ControllerId, Button);
+					MessageHandler->OnControllerButtonReleased(Entry.Key, ControllerId, false);
+				}
+			}
+		}
+
+		for (uint32 Pov = 0; Pov < Joy.GetNumPovs(); Pov++)
+		{
+			if (Joy.IsPovChanged(Pov))
+			{
+				const FDirectInputKeySet& Keys = Joy.GetKeys();
+				const uint32 Value = Joy.GetPovValue(Pov);
+				//UE_LOG(LogDirectInputDevice, Log, TEXT("ControllerId %d POV %d : %d"), ControllerId, Pov, Value);
+				MessageHandler->OnControllerAnalog(Keys.Povs[Pov], ControllerId, Value);
+
+				// Decode the hat once here and only send the directional keys that changed
+				const uint32 Direction = Joy.GetPovDirection(Pov);
+				const uint32 PreviousDirection = Joy.GetPreviousPovDirection(Pov);
+				if (Direction != PreviousDirection)
+				{
+					if (PovAxisTable[Direction][0] != PovAxisTable[PreviousDirection][0])
+					{
+						MessageHandler->OnControllerAnalog(Keys.PovX[Pov], ControllerId, PovAxisTable[Direction][0]);
+					}
+					if (PovAxisTable[Direction][1] != PovAxisTable[PreviousDirection][1])
+					{
+						MessageHandler->OnControllerAnalog(Keys.PovY[Pov], ControllerId, PovAxisTable[Direction][1]);
+					}
+					if (PreviousDirection != FJoystick::PovCentered)
+					{
+						MessageHandler->OnControllerButtonReleased(Keys.PovDirections[Pov * FJoystick::NumPovDirections + PreviousDirection], ControllerId, false);
+					}
+					if (Direction != FJoystick::PovCentered)
+					{
+						MessageHandler->OnControllerButtonPressed(Keys.PovDirections[Pov * FJoystick::NumPovDirections + Direction], ControllerId, false);
+					}
+				}
+			}
+		}
+	}
+
+	// Merge after every device has been polled so the combined state is from the same frame
+	if (Combined->IsEnabled() && Combined->Merge(GInputDevices))
+	{
+		SendCombinedEvents();
+	}
+}
+
+void FDirectInputDevice::SendCombinedEvents()
+{
+	FInputDeviceScope InputScope(this, DirectInputInterfaceName, CombinedControllerId, TEXT("Combined"));
+
+	for (uint32 Axis = 0; Axis < Combined->GetNumAxes(); Axis++)
+	{
+		if (Combined->IsAxisChanged(Axis))
+		{
+			MessageHandler->OnControllerAnalog(FDirectInputKeys::CombinedAxes[Axis], CombinedControllerId, Combined->GetAxisValue(Axis));
+		}
+	}
+
+	for (uint32 Button = 0; Button < Combined->GetNumButtons(); Button++)
+	{
+		if (Combined->IsButtonChanged(Button))
+		{
+			if (Combined->GetButtonValue(Button))
+			{
+				MessageHandler->OnControllerButtonPressed(FDirectInputKeys::CombinedButtons[Button], CombinedControllerId, false);
+			}
+			else
+			{
+				MessageHandler->OnControllerButtonReleased(FDirectInputKeys::CombinedButtons[Button], CombinedControllerId, false);
+			}
+		}
+	}
+
+	for (uint32 Pov = 0; Pov < Combined->GetNumPovs(); Pov++)
+	{
+		if (Combined->IsPovChanged(Pov))
+		{
+			MessageHandler->OnControllerAnalog(FDirectInputKeys::CombinedPovs[Pov], CombinedControllerId, Combined->GetPovValue(Pov));
+		}
+	}
+}
+
+void FDirectInputDevice::SetMessageHandler(const TSharedRef<FGenericApplicationMessageHandler>& InMessageHandler)
+{
+	MessageHandler = InMessageHandler;
+}
+
+bool FDirectInputDevice::Exec(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar)
+{
+	if (!FParse::Command(&Cmd, TEXT("DINPUT")))
+	{
+		return false;
+	}
+
+	if (FParse::Command(&Cmd, TEXT("SOAK")))
+	{
+		// DINPUT SOAK [Devices] [Minutes] [Seed] [Rate] or DINPUT SOAK STOP
+		if (FParse::Command(&Cmd, TEXT("STOP")))
+		{
+			if (Soak.IsValid())
+			{
+				Soak->Stop();
+			}
+			return true;
+		}
+
+		if (Soak.IsValid())
+		{
+			Ar.Log(TEXT("The soak test is already running, stop it with DINPUT SOAK STOP"));
+			return true;
+		}
+
+		FSoakTestSettings Settings;
+		FString Token;
+		if (FParse::Token(Cmd, Token, false))
+		{
+			Settings.NumDevices = FMath::Max(FCString::Atoi(*Token), 1);
+		}
+		if (FParse::Token(Cmd, Token, false))
+		{
+			Settings.Minutes = FMath::Max(FCString::Atod(*Token), 0.0);
+		}
+		if (FParse::Token(Cmd, Token, false))
+		{
+			Settings.Seed = FCString::Atoi(*Token);
+		}
+		if (FParse::Token(Cmd, Token, false))
+		{
+			Settings.Rate = FMath::Max(FCString::Atoi(*Token), 1);
+		}
+
+		// Reported by Tick when done
+		Soak = MakeUnique<FDirectInputSoakTest>(*this, Settings);
+		Ar.Logf(TEXT("Soak test started, %d devices at %d Hz for %.1f minutes"), Settings.NumDevices, Settings.Rate, Settings.Minutes);
+		return true;
+	}
+
+	// The other commands would see or replace the simulated devices
+	if (Soak.IsValid())
+	{
+		Ar.Log(TEXT("The soak test is running, stop it with DINPUT SOAK STOP"));
+		return true;
+	}
+
+	if (FParse::Command(&Cmd, TEXT("CALIBRATE")))
+	{
+		// DINPUT CALIBRATE START|STOP|INVERT|CLEAR <ControllerId> [Axis]
+		const bool bStart = FParse::Command(&Cmd, TEXT("START"));
+		const bool bStop = !bStart && FParse::Command(&Cmd, TEXT("STOP"));
+		const bool bInvert = !bStart && !bStop && FParse::Command(&Cmd, TEXT("INVERT"));
+		const bool bClear = !bStart && !bStop && !bInvert && FParse::Command(&Cmd, TEXT("CLEAR"));
+
+		const int32 ControllerId = FCString::Atoi(*FParse::Token(Cmd, false));
+		if (!GInputDevices.IsValidIndex(ControllerId) || !(bStart || bStop || bInvert || bClear))
+		{
+			Ar.Log(TEXT("Usage: DINPUT CALIBRATE START|STOP|INVERT|CLEAR <ControllerId> [Axis]"));
+			return true;
+		}
+
+		FJoystick& Joy = GInputDevices[ControllerId];
+		FCalibrationStore& Calibration = FDirectInputModule::Get().GetCalibration();
+		const FGuid Product = ToFGuid(Joy.GetProductGui());
+
+		if (bStart)
+		{
+			Joy.StartCalibration();
+			Ar.Logf(TEXT("Calibrating %s, move every axis through its full range"), *Joy.GetInstanceName());
+			return true;
+		}
+
+		if (bStop)
+		{
+			Calibration.Set(Product, Joy.StopCalibration());
+		}
+		else if (bInvert)
+		{
+			const uint32 Axis = FCString::Atoi(*FParse::Token(Cmd, false));
+			FCalibrationProfile Profile = Joy.GetCalibration();
+			if (Axis < Profile.NumAxes)
+			{
+				Profile.Axes[Axis].bInvert = !Profile.Axes[Axis].bInvert;
+				Joy.ApplyCalibration(Profile);
+				Calibration.Set(Product, Profile);
+			}
+		}
+		else
+		{
+			Calibration.Remove(Product);
+			Ar.Logf(TEXT("Calibration of %s is cleared from the next start"), *Joy.GetInstanceName());
+		}
+
+		Ar.Logf(TEXT("Saving %d calibration profiles: %s"), Calibration.Num(), FDirectInputModule::Get().SaveCalibration() ? TEXT("ok") : TEXT("failed"));
+		return true;
+	}
+
+	if (FParse::Command(&Cmd, TEXT("BENCH")))
+	{
+		// DINPUT BENCH [Case|ALL] [Frames] [SAVE]
+		FString Name = TEXT("ALL");
+		uint32 NumFrames = 10000;
+		bool bSave = false;
+
+		FString Token;
+		while (FParse::Token(Cmd, Token, false))
+		{
+			if (Token.Equals(TEXT("SAVE"), ESearchCase::IgnoreCase))
+			{
+				bSave = true;
+			}
+			else if (Token.IsNumeric())
+			{
+				NumFrames = FMath::Max(FCString::Atoi(*Token), 1);
+			}
+			else
+			{
+				Name = Token;
+			}
+		}
+
+		float Threshold = 0.1f;
+		GConfig->GetFloat(TEXT("DirectInput"), TEXT("BenchmarkThreshold"), Threshold, GInputIni);
+
+		TArray<FString> Names;
+		if (Name.Equals(TEXT("ALL"), ESearchCase::IgnoreCase))
+		{
+			Names = FDirectInputBenchmark::GetCaseNames();
+		}
+		else
+		{
+			Names.Add(Name);
+		}
+
+		int32 NumRegressions = 0;
+		for (const FString& CaseName : Names)
+		{
+			FBenchmarkResult Result;
+			if (!FDirectInputBenchmark::Run(*this, CaseName, NumFrames, Result))
+			{
+				Ar.Logf(TEXT("Unknown benchmark %s, one of: ALL %s"), *CaseName, *FString::Join(FDirectInputBenchmark::GetCaseNames(), TEXT(" ")));
+				continue;
+			}
+
+			double Baseline = 0.0;
+			const bool bWithinBaseline = FDirectInputBenchmark::CompareWithBaseline(Result, Threshold, Baseline);
+			const TCHAR* Verdict = Baseline <= 0.0 ? TEXT("no baseline") : bWithinBaseline ? TEXT("ok") : TEXT("REGRESSION");
+			NumRegressions += Baseline > 0.0 && !bWithinBaseline ? 1 : 0;
+
+			Ar.Logf(TEXT("%-14s %2d devices %10.1f ns/device/frame %12.0f events/s %5d bytes apart   baseline %10.1f  %s"),
+				*Result.Name, Result.NumDevices, Result.NanosecondsPerDeviceFrame, Result.EventsPerSecond, Result.DeviceStride, Baseline, Verdict);
+			if (Result.LegacyDispatchNanoseconds > 0.0)
+			{
+				Ar.Logf(TEXT("               dispatch of an idle device from cold caches %.1f ns, %.1f ns with the layout before the split (%.1fx)"),
+					Result.DispatchNanoseconds, Result.LegacyDispatchNanoseconds, Result.LegacyDispatchNanoseconds / FMath::Max(Result.DispatchNanoseconds, 0.1));
+			}
+			if (Result.UncachedStartupNanoseconds > 0.0)
+			{
+				Ar.Logf(TEXT("               creating %d devices %.1f ms with the device cache, %.1f ms without it (%.1fx)"),
+					Result.NumDevices, Result.NanosecondsPerDeviceFrame * Result.NumDevices * 1.0e-6, Result.UncachedStartupNanoseconds * Result.NumDevices * 1.0e-6,
+					Result.UncachedStartupNanoseconds / FMath::Max(Result.NanosecondsPerDeviceFrame, 0.1));
+			}
+
+			if (bSave)
+			{
+				FDirectInputBenchmark::SaveBaseline(Result);
+			}
+		}
+
+		Ar.Logf(TEXT("%d regressions beyond %.0f%%%s"), NumRegressions, Threshold * 100.0f, bSave ? TEXT(", baselines saved") : TEXT(""));
+		return true;
+	}
+
+	if (FParse::Command(&Cmd, TEXT("POLL")))
+	{
+		// DINPUT POLL [RESET]
+		Ar.Logf(TEXT("%.0f driver calls/s, %.0f saved/s%s"), Scheduler.GetCallsPerSecond(), Scheduler.GetSavedCallsPerSecond(), Scheduler.IsThrottled() ? TEXT(", throttled") : TEXT(""));
+		for (int32 ControllerId = 0; ControllerId < GInputDevices.Num(); ControllerId++)
+		{
+			FJoystick& Joy = GInputDevices[ControllerId];
+			const FPollSchedule& Schedule = Joy.GetSchedule();
+			Ar.Logf(TEXT("%d %s: every %d frames, backed off x%d, %s"), ControllerId, *Joy.GetInstanceName(), Schedule.Interval, Schedule.Backoff, Joy.IsPolledDevice() ? TEXT("polled") : TEXT("interrupt driven"));
+		}
+
+		if (FParse::Command(&Cmd, TEXT("RESET")))
+		{
+			Scheduler.ResetCounters();
+		}
+		return true;
+	}
+
+	if (FParse::Command(&Cmd, TEXT("FFB")))
+	{
+		// DINPUT FFB [TEST]
+		if (FParse::Command(&Cmd, TEXT("TEST")))
+		{
+			// The rate check is an automation test, so it is part of a test pass and the game keeps ticking while it runs
+			return GEngine->Exec(InWorld, TEXT("Automation RunTests Plugins.DirectInput.ForceFeedbackThread"), Ar);
+		}
+
+		if (!ForceFeedback.IsValid())
+		{
+			Ar.Log(TEXT("The force feedback thread is not running, set ForceFeedbackRate to start it"));
+			return true;
+		}
+
+		const FForceFeedbackStats Stats = ForceFeedback->GetStats();
+		Ar.Logf(TEXT("%.0f ticks/s of %d, %llu updates in the last second%s"), Stats.Rate, ForceFeedback->GetRate(), Stats.NumUpdates, ForceFeedbackCallback ? TEXT(", from the callback") : TEXT(""));
+		Ar.Logf(TEXT("Jitter mean %.1f us, p99 %.0f us, max %.1f us"), Stats.JitterMean, Stats.JitterP99, Stats.JitterMax);
+		Ar.Logf(TEXT("Latency p50 %.0f us, p99 %.0f us, max %.1f us"), Stats.LatencyP50, Stats.LatencyP99, Stats.LatencyMax);
+		return true;
+	}
+
+	return false;
+}
+
+void FDirectInputDevice::SetChannelValue(int32 ControllerId, FForceFeedbackChannelType ChannelType, float Value)
+{
+	switch (ChannelType)
+	{
+	case FForceFeedbackChannelType::LEFT_LARGE:
+		if (ForceFeedback.IsValid())
+		{
+			ForceFeedback->SetTarget(ControllerId, Value);
+		}
+		else if (ControllerId < GInputDevices.Num())
+		{
+			GInputDevices[ControllerId].SetConstantForce(Value);
+		}
+		break;
+	case FForceFeedbackChannelType::LEFT_SMALL:
+		// NOP
+		break;
+	case FForceFeedbackChannelType::RIGHT_LARGE:
+		// NOP
+		break;
+	case FForceFeedbackChannelType::RIGHT_SMALL:
+		// NOP
+		break;
+	default:
+		break;
+	}
+}
+
+void FDirectInputDevice::SetChannelValues(int32 ControllerId, const FForceFeedbackValues& Values)
+{
+	if (ForceFeedback.IsValid())
+	{
+		ForceFeedback->SetTarget(ControllerId, Values.LeftLarge);
+	}
+	else if (ControllerId < GInputDevices.Num())
+	{
+		GInputDevices[ControllerId].SetConstantForce(Values.LeftLarge);
+	}
+}
+
+void FDirectInputDevice::SetForceConditions(const int32 ControllerId, const FForceConditions& Conditions)
+{
+	if (ControllerId >= 0 && ControllerId < GInputDevices.Num())
+	{
+		FJoystick& Joy = GInputDevices[ControllerId];
+		Joy.SetConditions(Conditions);
+
+		// Clears what is left of the software conditions once the device plays them all or they are off
+		if (!Joy.HasSoftwareConditions())
+		{
+			if (ForceFeedback.IsValid())
+			{
+				ForceFeedback->SetConditionForce(ControllerId, 0.0f);
+			}
+			else
+			{
+				Joy.SetConstantForce(Joy.GetConstantForce());
+			}
+		}
+	}
+}
+
+FForceStream* FDirectInputDevice::EnableForceStream(const int32 ControllerId, const uint32 SampleRate)
+{
+	if (ControllerId >= 0 && ControllerId < GInputDevices.Num() && SampleRate > 0)
+	{
+		return GInputDevices[ControllerId].EnableForceStream(SampleRate);
+	}
+
+	return nullptr;
+}
+
+void FDirectInputDevice::PreloadForceEffect(const UForceEffect& Effect)
+{
+	for (FJoystick& Joy : GInputDevices)
+	{
+		Joy.LoadForceEffect(Effect.GetId(), Effect.GetEffects());
+	}
+}
+
+bool FDirectInputDevice::PlayForceEffect(const int32 ControllerId, const UForceEffect& Effect, const uint32 Iterations)
+{
+	if (ControllerId < 0 || ControllerId >= GInputDevices.Num())
+	{
+		return false;
+	}
+
+	FJoystick& Joy = GInputDevices[ControllerId];
+	if (!Joy.IsForceEffectLoaded(Effect.GetId()))
+	{
+		Joy.LoadForceEffect(Effect.GetId(), Effect.GetEffects());
+	}
+	return Joy.StartForceEffect(Effect.GetId(), Iterations);
+}
+
+bool FDirectInputDevice::StopForceEffect(const int32 ControllerId, const UForceEffect& Effect)
+{
+	if (ControllerId < 0 || ControllerId >= GInputDevices.Num())
+	{
+		return false;
+	}
+
+	return GInputDevices[ControllerId].StopForceEffect(Effect.GetId());
+}
+
+void FDirectInputDevice::UnloadForceEffect(const FGuid& Id)
+{
+	for (FJoystick& Joy : GInputDevices)
+	{
+		Joy.UnloadForceEffect(Id);
+	}
+}
+
+void FDirectInputDevice::SetForceFeedbackTarget(const int32 ControllerId, const float Magnitude)
+{
+	if (ForceFeedback.IsValid())
+	{
+		ForceFeedback->SetTarget(ControllerId, Magnitude);
+	}
+}
+
+void FDirectInputDevice::SetForceFeedbackCallback(FForceFeedbackCallback Callback)
+{
+	// The callback is fixed for the life of a thread, so it takes a new one
+	ForceFeedbackCallback = MoveTemp(Callback);
+	if (ForceFeedbackRate > 0 && !bForceFeedbackSuspended)
+	{
+		ForceFeedback.Reset();
+		ForceFeedback = MakeUnique<FForceFeedbackThread>(ForceFeedbackRate, ForceFeedbackCallback);
+	}
+}
+
+void FDirectInputDevice::SuspendForceFeedback()
+{
+	bForceFeedbackSuspended = true;
+	ForceFeedback.Reset();
+}
+
+void FDirectInputDevice::ResumeForceFeedback()
+{
+	bForceFeedbackSuspended = false;
+	if (ForceFeedbackRate > 0 && !ForceFeedback.IsValid())
+	{
+		ForceFeedback = MakeUnique<FForceFeedbackThread>(ForceFeedbackRate, ForceFeedbackCallback);
+	}
+}
+
+TSharedPtr<const FInputHistory, ESPMode::ThreadSafe> FDirectInputDevice::GetHistory(const int32 ControllerId) const
+{
+	if (ControllerId >= 0 && ControllerId < GInputDevices.Num())
+	{
+		return GInputDevices[ControllerId].GetHistory();
+	}
+
+	return nullptr;
+}
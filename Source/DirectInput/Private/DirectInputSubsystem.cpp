@@ -0,0 +1,152 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "DirectInputSubsystem.h"
+#include "ForceEffect.h"
+
+void UDirectInputSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FMemory::Memzero(States);
+	FMemory::Memzero(bConnected);
+	bInitialized = true;
+}
+
+void UDirectInputSubsystem::Deinitialize()
+{
+	bInitialized = false;
+
+	Super::Deinitialize();
+}
+
+void UDirectInputSubsystem::Tick(float DeltaTime)
+{
+	if (!FDirectInputModule::IsAvailable())
+	{
+		return;
+	}
+
+	// This frame's states go in the slot of the frame before last, the devices have been polled by now
+	Current ^= 1;
+
+	const FDirectInputModule& Module = FDirectInputModule::Get();
+	for (int32 ControllerId = 0; ControllerId < MaxControllers; ControllerId++)
+	{
+		bConnected[Current][ControllerId] = Module.GetState(ControllerId, States[Current][ControllerId]);
+	}
+}
+
+ETickableTickType UDirectInputSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UDirectInputSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDirectInputSubsystem, STATGROUP_DirectInput);
+}
+
+const FDirectInputState* UDirectInputSubsystem::GetCurrent(const int32 ControllerId) const
+{
+	return ControllerId >= 0 && ControllerId < MaxControllers && bConnected[Current][ControllerId] ? &States[Current][ControllerId] : nullptr;
+}
+
+const FDirectInputState* UDirectInputSubsystem::GetPrevious(const int32 ControllerId) const
+{
+	return ControllerId >= 0 && ControllerId < MaxControllers && bConnected[Current ^ 1][ControllerId] ? &States[Current ^ 1][ControllerId] : nullptr;
+}
+
+bool UDirectInputSubsystem::IsConnected(const int32 ControllerId) const
+{
+	return GetCurrent(ControllerId) != nullptr;
+}
+
+float UDirectInputSubsystem::GetAxis(const int32 ControllerId, const int32 Axis) const
+{
+	const FDirectInputState* State = GetCurrent(ControllerId);
+	return State != nullptr && Axis >= 0 && static_cast<uint32>(Axis) < State->NumAxes ? State->Axes[Axis] : 0.0f;
+}
+
+bool UDirectInputSubsystem::GetButton(const int32 ControllerId, const int32 Button) const
+{
+	const FDirectInputState* State = GetCurrent(ControllerId);
+	return State != nullptr && Button >= 0 && State->IsButtonPressed(Button);
+}
+
+int32 UDirectInputSubsystem::GetPov(const int32 ControllerId, const int32 Pov) const
+{
+	const FDirectInputState* State = GetCurrent(ControllerId);
+	if (State == nullptr || Pov < 0 || static_cast<uint32>(Pov) >= State->NumPovs)
+	{
+		return -1;
+	}
+
+	// Centred is reported with 0xFFFF in the low word
+	const uint32 Value = State->Povs[Pov];
+	return (Value & 0xFFFF) == 0xFFFF ? -1 : static_cast<int32>(Value);
+}
+
+bool UDirectInputSubsystem::WasPressedThisFrame(const int32 ControllerId, const int32 Button) const
+{
+	const FDirectInputState* Previous = GetPrevious(ControllerId);
+	return GetButton(ControllerId, Button) && (Previous == nullptr || !Previous->IsButtonPressed(Button));
+}
+
+bool UDirectInputSubsystem::WasReleasedThisFrame(const int32 ControllerId, const int32 Button) const
+{
+	const FDirectInputState* Previous = GetPrevious(ControllerId);
+	return IsConnected(ControllerId) && !GetButton(ControllerId, Button) && Previous != nullptr && Previous->IsButtonPressed(Button);
+}
+
+TArrayView<const float> UDirectInputSubsystem::GetAllAxes(const int32 ControllerId) const
+{
+	const FDirectInputState* State = GetCurrent(ControllerId);
+	return State != nullptr ? TArrayView<const float>(State->Axes, State->NumAxes) : TArrayView<const float>();
+}
+
+void UDirectInputSubsystem::K2_GetAllAxes(const int32 ControllerId, TArray<float>& OutAxes) const
+{
+	const TArrayView<const float> Axes = GetAllAxes(ControllerId);
+	OutAxes.Reset(Axes.Num());
+	OutAxes.Append(Axes.GetData(), Axes.Num());
+}
+
+bool UDirectInputSubsystem::PlayForceEffect(const int32 ControllerId, UForceEffect* Effect, const int32 Iterations)
+{
+	const TSharedPtr<IDInputDevice>& Device = FDirectInputModule::Get().GetDirectInputDevice();
+	return Effect != nullptr && Device.IsValid() && Device->PlayForceEffect(ControllerId, *Effect, FMath::Max(Iterations, 0));
+}
+
+bool UDirectInputSubsystem::StopForceEffect(const int32 ControllerId, UForceEffect* Effect)
+{
+	const TSharedPtr<IDInputDevice>& Device = FDirectInputModule::Get().GetDirectInputDevice();
+	return Effect != nullptr && Device.IsValid() && Device->StopForceEffect(ControllerId, *Effect);
+}
+
+void UDirectInputSubsystem::PreloadForceEffect(UForceEffect* Effect)
+{
+	const TSharedPtr<IDInputDevice>& Device = FDirectInputModule::Get().GetDirectInputDevice();
+	if (Effect != nullptr && Device.IsValid())
+	{
+		Device->PreloadForceEffect(*Effect);
+	}
+}
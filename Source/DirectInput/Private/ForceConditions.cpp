@@ -0,0 +1,77 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "ForceConditions.h"
+
+void FConditionSynthesizer::SetConditions(const FForceConditions& InConditions, const uint32 InHardwareMask)
+{
+	Conditions = InConditions;
+	HardwareMask = InHardwareMask;
+
+	const auto IsSoftware = [this](const EForceCondition Condition, const float Coefficient)
+	{
+		return Coefficient != 0.0f && (HardwareMask & (1u << static_cast<uint32>(Condition))) == 0;
+	};
+
+	bActive = IsSoftware(EForceCondition::Spring, Conditions.Spring)
+		|| IsSoftware(EForceCondition::Damper, Conditions.Damper)
+		|| IsSoftware(EForceCondition::Friction, Conditions.Friction)
+		|| IsSoftware(EForceCondition::Inertia, Conditions.Inertia);
+
+	if (!bActive)
+	{
+		Force = 0.0f;
+	}
+}
+
+float FConditionSynthesizer::Update(const float Position, const double Time)
+{
+	if (!bActive)
+	{
+		return 0.0f;
+	}
+
+	const float DeltaTime = static_cast<float>(Time - LastTime);
+	if (bHasSample && DeltaTime > 0.0f)
+	{
+		const float NewVelocity = (Position - LastPosition) / DeltaTime;
+		const float NewAcceleration = (NewVelocity - Velocity) / DeltaTime;
+		Velocity += Smoothing * (NewVelocity - Velocity);
+		Acceleration += Smoothing * (NewAcceleration - Acceleration);
+	}
+	bHasSample = true;
+	LastPosition = Position;
+	LastTime = Time;
+
+	const auto Software = [this](const EForceCondition Condition)
+	{
+		return (HardwareMask & (1u << static_cast<uint32>(Condition))) == 0 ? 1.0f : 0.0f;
+	};
+
+	const float Fraction =
+		- Software(EForceCondition::Spring) * Conditions.Spring * (Position - Conditions.Center)
+		- Software(EForceCondition::Damper) * Conditions.Damper * Velocity
+		- Software(EForceCondition::Friction) * Conditions.Friction * FMath::Clamp(Velocity / FrictionSpeed, -1.0f, 1.0f)
+		- Software(EForceCondition::Inertia) * Conditions.Inertia * Acceleration;
+
+	Force = FMath::Clamp(Fraction, -Conditions.Saturation, Conditions.Saturation) * FullForce;
+	return Force;
+}
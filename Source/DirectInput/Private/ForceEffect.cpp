@@ -0,0 +1,169 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "ForceEffect.h"
+#include "DirectInput.h"
+
+// Bumped whenever the layout of FForceEffectData changes
+static constexpr uint8 ForceEffectFormat = 1;
+
+// Most elements a loaded array may have, far more than the longest custom force
+static constexpr uint32 MaxPackedElements = 1 << 20;
+
+// Counts and most parameters are small, packing them keeps an effect to a few dozen bytes
+static void SerializePacked(FArchive& Ar, uint32& Value)
+{
+	Ar.SerializeIntPacked(Value);
+}
+
+// A loaded count is only trusted if the elements fit in what is left of the archive, when it knows its size
+static bool IsLoadedCountValid(FArchive& Ar, const uint32 Num, const uint32 MinElementSize)
+{
+	const int64 Remaining = Ar.TotalSize() - Ar.Tell();
+	return !Ar.IsError() && Num <= MaxPackedElements && (Ar.TotalSize() < 0 || static_cast<int64>(Num) * MinElementSize <= Remaining);
+}
+
+template <typename ElementType>
+static void SerializePacked(FArchive& Ar, TArray<ElementType>& Array)
+{
+	uint32 Num = Array.Num();
+	Ar.SerializeIntPacked(Num);
+	if (Ar.IsLoading())
+	{
+		if (!IsLoadedCountValid(Ar, Num, sizeof(ElementType)))
+		{
+			Ar.SetError();
+			Array.Reset();
+			return;
+		}
+		Array.SetNumUninitialized(Num);
+	}
+	Ar.Serialize(Array.GetData(), Num * sizeof(ElementType));
+}
+
+FArchive& operator<<(FArchive& Ar, FForceEffectData& Data)
+{
+	Ar << Data.Type;
+	Ar << Data.Name;
+
+	SerializePacked(Ar, Data.Flags);
+	SerializePacked(Ar, Data.Duration);
+	SerializePacked(Ar, Data.SamplePeriod);
+	SerializePacked(Ar, Data.Gain);
+	SerializePacked(Ar, Data.TriggerButton);
+	SerializePacked(Ar, Data.TriggerRepeatInterval);
+	SerializePacked(Ar, Data.StartDelay);
+
+	SerializePacked(Ar, Data.Axes);
+	SerializePacked(Ar, Data.Direction);
+
+	Ar << Data.bEnvelope;
+	if (Data.bEnvelope)
+	{
+		SerializePacked(Ar, Data.AttackLevel);
+		SerializePacked(Ar, Data.AttackTime);
+		SerializePacked(Ar, Data.FadeLevel);
+		SerializePacked(Ar, Data.FadeTime);
+	}
+
+	SerializePacked(Ar, Data.Parameters);
+	SerializePacked(Ar, Data.Samples);
+	return Ar;
+}
+
+void UForceEffect::Serialize(FArchive& Ar)
+{
+	Super::Serialize(Ar);
+
+	uint8 Format = ForceEffectFormat;
+	Ar << Format;
+	if (Ar.IsLoading() && Format != ForceEffectFormat)
+	{
+		Ar.SetError();
+		return;
+	}
+
+	uint32 Num = Effects.Num();
+	Ar.SerializeIntPacked(Num);
+	if (Ar.IsLoading())
+	{
+		// An effect takes at least a GUID, a corrupt count is caught before allocating for it
+		if (!IsLoadedCountValid(Ar, Num, sizeof(FGuid)))
+		{
+			Ar.SetError();
+			Effects.Reset();
+			NumEffects = 0;
+			return;
+		}
+		Effects.SetNum(Num);
+	}
+	for (FForceEffectData& Effect : Effects)
+	{
+		Ar << Effect;
+		if (Ar.IsError())
+		{
+			Effects.Reset();
+			NumEffects = 0;
+			return;
+		}
+	}
+}
+
+void UForceEffect::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	if (!HasAnyFlags(RF_ClassDefaultObject | RF_NeedLoad))
+	{
+		Id = FGuid::NewGuid();
+	}
+}
+
+void UForceEffect::BeginDestroy()
+{
+	Unload();
+
+	Super::BeginDestroy();
+}
+
+void UForceEffect::SetEffects(TArray<FForceEffectData>&& InEffects)
+{
+	// The effects of the old id would otherwise stay on the devices with nothing left to play them
+	Unload();
+
+	Effects = MoveTemp(InEffects);
+	NumEffects = Effects.Num();
+	Id = FGuid::NewGuid();
+}
+
+void UForceEffect::Unload() const
+{
+	if (!Id.IsValid() || !FDirectInputModule::IsAvailable())
+	{
+		return;
+	}
+
+	const TSharedPtr<IDInputDevice>& Device = FDirectInputModule::Get().GetDirectInputDevice();
+	if (Device.IsValid())
+	{
+		Device->UnloadForceEffect(Id);
+	}
+}
@@ -0,0 +1,230 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "ForceEffectFile.h"
+#include "Joystick.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogForceEffectFile, Log, All);
+
+// Effects have at most the axes of DIJOYSTATE in a file
+static constexpr uint32 MaxFileAxes = 8;
+
+static_assert(sizeof(LONG) == sizeof(int32), "Custom force samples are copied as they are");
+
+// Effect files are read and written through a device, any device, the system keyboard is always there
+class FEffectFileDevice
+{
+public:
+	FEffectFileDevice() :
+		Input(nullptr),
+		Device(nullptr)
+	{
+		if (SUCCEEDED(DirectInput8Create(GetModuleHandle(nullptr), DIRECTINPUT_VERSION, IID_IDirectInput8, (void**)&Input, nullptr)))
+		{
+			if (FAILED(Input->CreateDevice(GUID_SysKeyboard, &Device, nullptr)))
+			{
+				Device = nullptr;
+			}
+		}
+	}
+
+	~FEffectFileDevice()
+	{
+		if (Device != nullptr)
+		{
+			Device->Release();
+		}
+		if (Input != nullptr)
+		{
+			Input->Release();
+		}
+	}
+
+	LPDIRECTINPUTDEVICE8 Get() const { return Device; }
+
+private:
+	IDirectInput8* Input;
+	LPDIRECTINPUTDEVICE8 Device;
+};
+
+static BOOL CALLBACK StaticEnumerateFileEffect(LPCDIFILEEFFECT FileEffect, LPVOID pvRef)
+{
+	TArray<FForceEffectData>& Effects = *static_cast<TArray<FForceEffectData>*>(pvRef);
+	const DIEFFECT& Effect = *FileEffect->lpDiEffect;
+
+	FForceEffectData& Data = Effects.AddDefaulted_GetRef();
+	Data.Type = ToFGuid(FileEffect->GuidEffect);
+	Data.Name = ANSI_TO_TCHAR(FileEffect->szFriendlyName);
+	Data.Flags = Effect.dwFlags & (DIEFF_CARTESIAN | DIEFF_POLAR | DIEFF_SPHERICAL);
+	Data.Duration = Effect.dwDuration;
+	Data.SamplePeriod = Effect.dwSamplePeriod;
+	Data.Gain = Effect.dwGain;
+	Data.TriggerButton = Effect.dwTriggerButton;
+	Data.TriggerRepeatInterval = Effect.dwTriggerRepeatInterval;
+	Data.StartDelay = Effect.dwStartDelay;
+
+	for (DWORD Axis = 0; Axis < Effect.cAxes; Axis++)
+	{
+		// Offsets into DIJOYSTATE, the axes come first one LONG each
+		const bool bOffset = (Effect.dwFlags & DIEFF_OBJECTOFFSETS) != 0 && Effect.rgdwAxes[Axis] < MaxFileAxes * sizeof(LONG);
+		Data.Axes.Add(static_cast<uint8>(bOffset ? Effect.rgdwAxes[Axis] / sizeof(LONG) : FMath::Min<DWORD>(Axis, MaxFileAxes - 1)));
+		Data.Direction.Add(Effect.rglDirection != nullptr ? Effect.rglDirection[Axis] : 0);
+	}
+
+	if (Effect.lpEnvelope != nullptr)
+	{
+		Data.bEnvelope = true;
+		Data.AttackLevel = Effect.lpEnvelope->dwAttackLevel;
+		Data.AttackTime = Effect.lpEnvelope->dwAttackTime;
+		Data.FadeLevel = Effect.lpEnvelope->dwFadeLevel;
+		Data.FadeTime = Effect.lpEnvelope->dwFadeTime;
+	}
+
+	if (FileEffect->GuidEffect == GUID_CustomForce && Effect.cbTypeSpecificParams >= sizeof(DICUSTOMFORCE))
+	{
+		// The samples are behind a pointer, they are kept apart and the pointer cleared
+		DICUSTOMFORCE CustomForce = *static_cast<const DICUSTOMFORCE*>(Effect.lpvTypeSpecificParams);
+		Data.Samples.Append(reinterpret_cast<const int32*>(CustomForce.rglForceData), CustomForce.cSamples);
+		CustomForce.rglForceData = nullptr;
+		Data.Parameters.Append(reinterpret_cast<const uint8*>(&CustomForce), sizeof(DICUSTOMFORCE));
+	}
+	else if (Effect.lpvTypeSpecificParams != nullptr)
+	{
+		Data.Parameters.Append(static_cast<const uint8*>(Effect.lpvTypeSpecificParams), Effect.cbTypeSpecificParams);
+	}
+
+	return DIENUM_CONTINUE;
+}
+
+bool FForceEffectFile::Read(const FString& Filename, TArray<FForceEffectData>& OutEffects)
+{
+	const FEffectFileDevice Device;
+	if (Device.Get() == nullptr)
+	{
+		UE_LOG(LogForceEffectFile, Error, TEXT("No device to read %s with"), *Filename);
+		return false;
+	}
+
+	OutEffects.Reset();
+	if (FAILED(Device.Get()->EnumEffectsInFile(*Filename, &StaticEnumerateFileEffect, &OutEffects, DIFEF_INCLUDENONSTANDARD)))
+	{
+		UE_LOG(LogForceEffectFile, Error, TEXT("Failed to read effects from %s"), *Filename);
+		return false;
+	}
+
+	UE_LOG(LogForceEffectFile, Display, TEXT("Read %d effects from %s"), OutEffects.Num(), *Filename);
+	return true;
+}
+
+bool FForceEffectFile::Write(const FString& Filename, const TArray<FForceEffectData>& Effects)
+{
+	const FEffectFileDevice Device;
+	if (Device.Get() == nullptr)
+	{
+		UE_LOG(LogForceEffectFile, Error, TEXT("No device to write %s with"), *Filename);
+		return false;
+	}
+
+	TArray<TUniquePtr<FForceEffectConfig>> Configs;
+	TArray<DIFILEEFFECT> FileEffects;
+	for (const FForceEffectData& Data : Effects)
+	{
+		const FForceEffectConfig& Config = *Configs.Add_GetRef(MakeUnique<FForceEffectConfig>(Data, (1u << MaxFileAxes) - 1));
+
+		DIFILEEFFECT& FileEffect = FileEffects.AddZeroed_GetRef();
+		FileEffect.dwSize = sizeof(DIFILEEFFECT);
+		FileEffect.GuidEffect = Config.GetType();
+		FileEffect.lpDiEffect = Config.GetEffect();
+		FCStringAnsi::Strncpy(FileEffect.szFriendlyName, TCHAR_TO_ANSI(*Data.Name), MAX_PATH);
+	}
+
+	if (FAILED(Device.Get()->WriteEffectToFile(*Filename, FileEffects.Num(), FileEffects.GetData(), DIFEF_INCLUDENONSTANDARD)))
+	{
+		UE_LOG(LogForceEffectFile, Error, TEXT("Failed to write effects to %s"), *Filename);
+		return false;
+	}
+
+	return true;
+}
+
+FForceEffectConfig::FForceEffectConfig(const FForceEffectData& Data, const uint32 AxisMask) :
+	Type(ToGuid(Data.Type))
+{
+	for (int32 Index = 0; Index < Data.Axes.Num(); Index++)
+	{
+		if (Data.Axes[Index] < 32 && (AxisMask & (1u << Data.Axes[Index])) != 0)
+		{
+			Axes.Add(Data.Axes[Index] * sizeof(LONG));
+			Direction.Add(Data.Direction.IsValidIndex(Index) ? Data.Direction[Index] : 0);
+		}
+		else
+		{
+			NumSkippedAxes++;
+		}
+	}
+
+	// A device without any of the axes of the effect plays it on the lowest axis it has
+	if (Axes.Num() == 0 && AxisMask != 0)
+	{
+		Axes.Add(FMath::CountTrailingZeros(AxisMask) * sizeof(LONG));
+		Direction.Add(0);
+	}
+
+	ZeroMemory(&Effect, sizeof(DIEFFECT));
+	Effect.dwSize = sizeof(DIEFFECT);
+	// Polar and spherical directions need more than one axis
+	Effect.dwFlags = DIEFF_OBJECTOFFSETS | (Axes.Num() > 1 && Data.Flags != 0 ? Data.Flags : DIEFF_CARTESIAN);
+	Effect.dwDuration = Data.Duration;
+	Effect.dwSamplePeriod = Data.SamplePeriod;
+	Effect.dwGain = Data.Gain;
+	Effect.dwTriggerButton = Data.TriggerButton;
+	Effect.dwTriggerRepeatInterval = Data.TriggerRepeatInterval;
+	Effect.dwStartDelay = Data.StartDelay;
+	Effect.cAxes = Axes.Num();
+	Effect.rgdwAxes = Axes.GetData();
+	Effect.rglDirection = Direction.GetData();
+
+	if (Data.bEnvelope)
+	{
+		Envelope.dwSize = sizeof(DIENVELOPE);
+		Envelope.dwAttackLevel = Data.AttackLevel;
+		Envelope.dwAttackTime = Data.AttackTime;
+		Envelope.dwFadeLevel = Data.FadeLevel;
+		Envelope.dwFadeTime = Data.FadeTime;
+		Effect.lpEnvelope = &Envelope;
+	}
+
+	if (Type == GUID_CustomForce && Data.Parameters.Num() >= static_cast<int32>(sizeof(DICUSTOMFORCE)))
+	{
+		FMemory::Memcpy(&CustomForce, Data.Parameters.GetData(), sizeof(DICUSTOMFORCE));
+		Samples.Append(reinterpret_cast<const LONG*>(Data.Samples.GetData()), Data.Samples.Num());
+		CustomForce.cSamples = Samples.Num();
+		CustomForce.rglForceData = Samples.GetData();
+		Effect.cbTypeSpecificParams = sizeof(DICUSTOMFORCE);
+		Effect.lpvTypeSpecificParams = &CustomForce;
+	}
+	else if (Data.Parameters.Num() > 0)
+	{
+		Parameters.Append(Data.Parameters);
+		Effect.cbTypeSpecificParams = Parameters.Num();
+		Effect.lpvTypeSpecificParams = Parameters.GetData();
+	}
+}
@@ -0,0 +1,240 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "ForceFeedbackThread.h"
+#include "HAL/RunnableThread.h"
+#include "Joystick.h"
+
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include "Windows/WindowsHWrapper.h"
+#include <mmsystem.h>
+#include "Windows/HideWindowsPlatformTypes.h"
+
+// Windows 10 1803 SDK and later
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+extern FJoystickArray GInputDevices;
+extern FCriticalSection GInputDevicesLock;
+
+FForceFeedbackThread::FForceFeedbackThread(const uint32 InRate, FForceFeedbackCallback InCallback) :
+	Rate(FMath::Max<uint32>(InRate, 1)),
+	Callback(MoveTemp(InCallback)),
+	NumTicks(0),
+	NumUpdates(0),
+	bStopping(false),
+	Thread(nullptr)
+{
+	for (int32 ControllerId = 0; ControllerId < MaxControllers; ControllerId++)
+	{
+		Sent[ControllerId] = 0.0f;
+		SentCycles[ControllerId] = 0;
+	}
+
+	Thread = FRunnableThread::Create(this, TEXT("DirectInputForceFeedback"), 0, TPri_Highest);
+}
+
+FForceFeedbackThread::~FForceFeedbackThread()
+{
+	if (Thread != nullptr)
+	{
+		Thread->Kill(true);
+		delete Thread;
+	}
+}
+
+void FForceFeedbackThread::Stop()
+{
+	bStopping = true;
+}
+
+void FForceFeedbackThread::SetTarget(const int32 ControllerId, const float Magnitude)
+{
+	if (ControllerId >= 0 && ControllerId < MaxControllers)
+	{
+		Targets[ControllerId].Magnitude.store(Magnitude, std::memory_order_relaxed);
+		Targets[ControllerId].Cycles.store(FPlatformTime::Cycles64(), std::memory_order_release);
+	}
+}
+
+void FForceFeedbackThread::SetConditionForce(const int32 ControllerId, const float Magnitude)
+{
+	if (ControllerId >= 0 && ControllerId < MaxControllers)
+	{
+		Targets[ControllerId].Condition.store(Magnitude, std::memory_order_relaxed);
+	}
+}
+
+FForceFeedbackStats FForceFeedbackThread::GetStats() const
+{
+	FScopeLock Lock(&StatsLock);
+	return Stats;
+}
+
+// Blocks for about Seconds on the timer, or in whole milliseconds without one, less than a millisecond only yields
+static void WaitFor(HANDLE Timer, const double Seconds)
+{
+	if (Timer != nullptr)
+	{
+		// Negative due times are relative, in 100 ns units
+		LARGE_INTEGER DueTime;
+		DueTime.QuadPart = -static_cast<LONGLONG>(Seconds * 1.0e7);
+		if (SetWaitableTimer(Timer, &DueTime, 0, nullptr, nullptr, FALSE))
+		{
+			WaitForSingleObject(Timer, INFINITE);
+			return;
+		}
+	}
+
+	::Sleep(static_cast<DWORD>(Seconds * 1000.0));
+}
+
+uint32 FForceFeedbackThread::Run()
+{
+	const double Period = 1.0 / Rate;
+	double LastTick = FPlatformTime::Seconds();
+	double NextTick = LastTick + Period;
+	double StatsStart = LastTick;
+
+	// High resolution waitable timers wake within a fraction of a millisecond, without them the system timer is raised
+	// to a millisecond while the thread runs and sleeps end up to a millisecond late
+	HANDLE Timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	if (Timer == nullptr)
+	{
+		timeBeginPeriod(1);
+	}
+	const double SpinTime = Timer != nullptr ? 0.0003 : 0.001;
+
+	while (!bStopping)
+	{
+		// Block until just before the tick and only yield through the rest, so the thread doesn't keep a core busy
+		double Now = FPlatformTime::Seconds();
+		while (Now < NextTick && !bStopping)
+		{
+			const double Remaining = NextTick - Now - SpinTime;
+			if (Remaining > 0.0)
+			{
+				WaitFor(Timer, Remaining);
+			}
+			else
+			{
+				FPlatformProcess::SleepNoStats(0.0f);
+			}
+			Now = FPlatformTime::Seconds();
+		}
+
+		Jitter.Add(FMath::Abs(Now - LastTick - Period) * 1.0e6);
+		LastTick = Now;
+
+		// A tick that is late by more than a period starts the schedule over instead of catching up
+		NextTick = FMath::Max(NextTick + Period, Now);
+
+		Tick(Now);
+
+		if (Now - StatsStart >= 1.0)
+		{
+			PublishStats(Now - StatsStart);
+			StatsStart = Now;
+		}
+	}
+
+	if (Timer != nullptr)
+	{
+		CloseHandle(Timer);
+	}
+	else
+	{
+		timeEndPeriod(1);
+	}
+
+	return 0;
+}
+
+void FForceFeedbackThread::Tick(const double Now)
+{
+	NumTicks++;
+
+	// Devices are only added or swapped under the lock, a tick that would wait on it is skipped
+	if (!GInputDevicesLock.TryLock())
+	{
+		return;
+	}
+
+	const int32 NumControllers = FMath::Min(GInputDevices.Num(), MaxControllers);
+	for (int32 ControllerId = 0; ControllerId < NumControllers; ControllerId++)
+	{
+		float Magnitude;
+		uint64 Cycles;
+		if (Callback)
+		{
+			Magnitude = Callback(ControllerId, Now);
+			Cycles = 0;
+		}
+		else
+		{
+			Cycles = Targets[ControllerId].Cycles.load(std::memory_order_acquire);
+			Magnitude = Targets[ControllerId].Magnitude.load(std::memory_order_relaxed);
+		}
+		Magnitude += Targets[ControllerId].Condition.load(std::memory_order_relaxed);
+
+		if (Magnitude == Sent[ControllerId] && Cycles == SentCycles[ControllerId])
+		{
+			continue;
+		}
+
+		if (GInputDevices[ControllerId].UpdateEffect(FMath::RoundToInt(Magnitude)))
+		{
+			NumUpdates++;
+			if (Cycles != SentCycles[ControllerId])
+			{
+				Latency.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - Cycles) * 1000.0);
+			}
+		}
+
+		Sent[ControllerId] = Magnitude;
+		SentCycles[ControllerId] = Cycles;
+	}
+
+	GInputDevicesLock.Unlock();
+}
+
+void FForceFeedbackThread::PublishStats(const double Elapsed)
+{
+	FForceFeedbackStats NewStats;
+	NewStats.Rate = NumTicks / Elapsed;
+	NewStats.NumTicks = NumTicks;
+	NewStats.NumUpdates = NumUpdates;
+	NewStats.JitterMean = Jitter.GetMean();
+	NewStats.JitterP99 = Jitter.GetPercentile(0.99);
+	NewStats.JitterMax = Jitter.GetMax();
+	NewStats.LatencyP50 = Latency.GetPercentile(0.5);
+	NewStats.LatencyP99 = Latency.GetPercentile(0.99);
+	NewStats.LatencyMax = Latency.GetMax();
+
+	Jitter.Reset();
+	Latency.Reset();
+	NumTicks = 0;
+	NumUpdates = 0;
+
+	FScopeLock Lock(&StatsLock);
+	Stats = NewStats;
+}
@@ -0,0 +1,111 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "ForceStream.h"
+
+FForceStream::FForceStream(const uint32 InSampleRate, const float BufferSeconds) :
+	SampleRate(FMath::Max<uint32>(InSampleRate, 1)),
+	Head(0),
+	Tail(0),
+	Current(0)
+{
+	// A power of two so the indices wrap with a mask
+	const uint32 Capacity = FMath::RoundUpToPowerOfTwo(FMath::Max(static_cast<uint32>(SampleRate * BufferSeconds), 2u));
+	Ring.SetNumZeroed(Capacity);
+	Mask = Capacity - 1;
+
+	for (TArray<int32>& Block : Blocks)
+	{
+		Block.Reserve(GetMaxBlockSize());
+		Block.Add(0);
+	}
+}
+
+int32 FForceStream::Push(const float* Samples, const int32 Num)
+{
+	const uint32 Write = Head.load(std::memory_order_relaxed);
+	const uint32 Read = Tail.load(std::memory_order_acquire);
+	const int32 Free = static_cast<int32>(Ring.Num() - (Write - Read));
+	const int32 Count = FMath::Min(Num, Free);
+
+	for (int32 Index = 0; Index < Count; Index++)
+	{
+		Ring[(Write + Index) & Mask] = Samples[Index];
+	}
+
+	Head.store(Write + Count, std::memory_order_release);
+	return Count;
+}
+
+bool FForceStream::Fill()
+{
+	const uint32 Read = Tail.load(std::memory_order_relaxed);
+	const uint32 Write = Head.load(std::memory_order_acquire);
+	const uint32 Available = FMath::Min(Write - Read, GetMaxBlockSize());
+
+	// The generator fell behind, the device stops at the end of the last block rather than loop it
+	if (Available == 0)
+	{
+		return false;
+	}
+
+	TArray<int32>& Block = Blocks[Current ^ 1];
+	Block.Reset();
+	for (uint32 Index = 0; Index < Available; Index++)
+	{
+		Block.Add(FMath::RoundToInt(FMath::Clamp(Ring[(Read + Index) & Mask], -1.0f, 1.0f) * 10000.0f));
+	}
+	Tail.store(Read + Available, std::memory_order_release);
+
+	Current ^= 1;
+	return true;
+}
+
+void FForceStream::GetPeriodic(uint32& OutMagnitude, int32& OutOffset, uint32& OutPeriod) const
+{
+	const TArray<int32>& Block = Blocks[Current];
+
+	int64 Sum = 0;
+	for (const int32 Sample : Block)
+	{
+		Sum += Sample;
+	}
+	const int32 Mean = static_cast<int32>(Sum / Block.Num());
+
+	uint32 Peak = 0;
+	uint32 Crossings = 0;
+	for (int32 Index = 0; Index < Block.Num(); Index++)
+	{
+		Peak = FMath::Max<uint32>(Peak, FMath::Abs(Block[Index] - Mean));
+		if (Index > 0 && (Block[Index - 1] < Mean) != (Block[Index] < Mean))
+		{
+			Crossings++;
+		}
+	}
+
+	// Two crossings per period, a block without any is taken as half a period
+	const double Duration = static_cast<double>(Block.Num()) / SampleRate;
+	const double Period = Crossings > 0 ? 2.0 * Duration / Crossings : 2.0 * Duration;
+
+	OutMagnitude = FMath::Min<uint32>(Peak, 10000);
+	OutOffset = Mean;
+	OutPeriod = FMath::Max<uint32>(static_cast<uint32>(Period * 1.0e6), GetSamplePeriod());
+}
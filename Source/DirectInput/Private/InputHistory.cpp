@@ -0,0 +1,161 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "InputHistory.h"
+
+FInputHistory::FInputHistory(const uint32 InCapacity) :
+	Capacity(FMath::RoundUpToPowerOfTwo(FMath::Max(InCapacity, 2u))),
+	Slots(MakeUnique<FSlot[]>(Capacity)),
+	Head(0)
+{
+}
+
+void FInputHistory::Push(const FInputSample& Sample)
+{
+	const uint64 Index = Head.load(std::memory_order_relaxed);
+	FSlot& Slot = Slots[Index & (Capacity - 1)];
+
+	// An odd sequence tells readers the slot is being written
+	const uint32 Sequence = Slot.Sequence.load(std::memory_order_relaxed);
+	Slot.Sequence.store(Sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	Slot.Index = Index;
+	Slot.Sample = Sample;
+
+	Slot.Sequence.store(Sequence + 2, std::memory_order_release);
+	Head.store(Index + 1, std::memory_order_release);
+}
+
+bool FInputHistory::ReadSlot(const uint64 Index, FInputSample& OutSample) const
+{
+	const FSlot& Slot = Slots[Index & (Capacity - 1)];
+
+	for (uint32 Attempt = 0; Attempt < MaxReadAttempts; Attempt++)
+	{
+		const uint32 Sequence = Slot.Sequence.load(std::memory_order_acquire);
+		if (Sequence & 1)
+		{
+			continue;
+		}
+
+		const uint64 SlotIndex = Slot.Index;
+		FMemory::Memcpy(&OutSample, &Slot.Sample, sizeof(FInputSample));
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (Slot.Sequence.load(std::memory_order_relaxed) == Sequence)
+		{
+			// The writer may have wrapped around and replaced the sample we were after
+			return SlotIndex == Index;
+		}
+	}
+
+	// Rewritten on every attempt, the query ends at the samples read so far
+	return false;
+}
+
+bool FInputHistory::FindSamples(const double Time, FInputSample& OutBefore, FInputSample& OutAfter, bool& bOutHasAfter) const
+{
+	const uint64 End = Head.load(std::memory_order_acquire);
+	const uint64 Begin = End > Capacity ? End - Capacity : 0;
+
+	bool bFound = false;
+	bOutHasAfter = false;
+
+	// Walk from the newest sample since queries are almost always close to now
+	for (uint64 Index = End; Index > Begin; Index--)
+	{
+		FInputSample Sample;
+		if (!ReadSlot(Index - 1, Sample))
+		{
+			break;
+		}
+
+		OutBefore = Sample;
+		bFound = true;
+
+		if (Sample.Time <= Time)
+		{
+			return true;
+		}
+
+		OutAfter = Sample;
+		bOutHasAfter = true;
+	}
+
+	// Time is older than anything retained, OutBefore holds the oldest sample
+	bOutHasAfter = false;
+	return bFound;
+}
+
+bool FInputHistory::GetAxisAt(const uint32 Axis, const double Time, float& OutValue) const
+{
+	FInputSample Before;
+	FInputSample After;
+	bool bHasAfter;
+
+	if (Axis >= UE_ARRAY_COUNT(Before.Axes) || !FindSamples(Time, Before, After, bHasAfter))
+	{
+		return false;
+	}
+
+	if (bHasAfter && After.Time > Before.Time)
+	{
+		const double Alpha = (Time - Before.Time) / (After.Time - Before.Time);
+		OutValue = FMath::Lerp(static_cast<float>(Before.Axes[Axis]), static_cast<float>(After.Axes[Axis]), static_cast<float>(Alpha));
+	}
+	else
+	{
+		OutValue = static_cast<float>(Before.Axes[Axis]);
+	}
+
+	return true;
+}
+
+bool FInputHistory::GetButtonAt(const uint32 Button, const double Time, bool& OutPressed) const
+{
+	FInputSample Before;
+	FInputSample After;
+	bool bHasAfter;
+
+	if (Button >= UE_ARRAY_COUNT(Before.Buttons) * 32 || !FindSamples(Time, Before, After, bHasAfter))
+	{
+		return false;
+	}
+
+	OutPressed = Before.IsButtonPressed(Button);
+	return true;
+}
+
+bool FInputHistory::GetPovAt(const uint32 Pov, const double Time, uint32& OutValue) const
+{
+	FInputSample Before;
+	FInputSample After;
+	bool bHasAfter;
+
+	if (Pov >= UE_ARRAY_COUNT(Before.Povs) || !FindSamples(Time, Before, After, bHasAfter))
+	{
+		return false;
+	}
+
+	OutValue = Before.Povs[Pov];
+	return true;
+}
@@ -0,0 +1,152 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "InputPacket.h"
+
+static void SerializeValue(FArchive& Ar, uint32& Value, const uint32 NumBits)
+{
+	// Bit readers only clear the bytes they write to
+	if (Ar.IsLoading())
+	{
+		Value = 0;
+	}
+
+	Ar.SerializeBits(&Value, NumBits);
+}
+
+FInputPacketFormat::FInputPacketFormat(const uint32 InNumAxes, const uint32 InAxisBits, const uint32 InNumButtons) :
+	NumAxes(FMath::Min(InNumAxes, MaxAxes)),
+	NumButtons(FMath::Min(InNumButtons, MaxButtons))
+{
+	for (uint32 Axis = 0; Axis < MaxAxes; Axis++)
+	{
+		AxisBits[Axis] = FMath::Clamp(InAxisBits, 1u, MaxAxisBits);
+	}
+}
+
+void FInputPacketFormat::SetAxisBits(const uint32 Axis, const uint32 Bits)
+{
+	if (Axis < MaxAxes)
+	{
+		AxisBits[Axis] = FMath::Clamp(Bits, 1u, MaxAxisBits);
+	}
+}
+
+FInputPacket::FInputPacket()
+{
+	FMemory::Memzero(Axes);
+	FMemory::Memzero(Buttons);
+}
+
+bool FInputPacket::operator==(const FInputPacket& Other) const
+{
+	return FMemory::Memcmp(Axes, Other.Axes, sizeof(Axes)) == 0 && FMemory::Memcmp(Buttons, Other.Buttons, sizeof(Buttons)) == 0;
+}
+
+FInputPacketCodec::FInputPacketCodec(const FInputPacketFormat& InFormat) :
+	Format(InFormat)
+{
+}
+
+void FInputPacketCodec::Quantize(const FDirectInputState& State, FInputPacket& OutPacket) const
+{
+	for (uint32 Axis = 0; Axis < Format.NumAxes; Axis++)
+	{
+		const uint32 MaxValue = (1u << Format.AxisBits[Axis]) - 1;
+		const float Alpha = Axis < State.NumAxes ? (FMath::Clamp(State.Axes[Axis], -1.0f, 1.0f) + 1.0f) * 0.5f : 0.5f;
+		OutPacket.Axes[Axis] = static_cast<uint32>(FMath::RoundToInt(Alpha * MaxValue));
+	}
+
+	for (uint32 Word = 0; Word < UE_ARRAY_COUNT(OutPacket.Buttons); Word++)
+	{
+		const uint32 Offset = Word * 32;
+		const uint32 Count = Format.NumButtons > Offset ? FMath::Min(Format.NumButtons - Offset, 32u) : 0;
+		const uint32 Mask = Count == 32 ? ~0u : (1u << Count) - 1;
+		OutPacket.Buttons[Word] = State.Buttons[Word] & Mask;
+	}
+}
+
+void FInputPacketCodec::Dequantize(const FInputPacket& Packet, FDirectInputState& OutState) const
+{
+	FMemory::Memzero(OutState);
+	OutState.NumAxes = Format.NumAxes;
+	OutState.NumButtons = Format.NumButtons;
+
+	for (uint32 Axis = 0; Axis < Format.NumAxes; Axis++)
+	{
+		const uint32 MaxValue = (1u << Format.AxisBits[Axis]) - 1;
+		OutState.Axes[Axis] = static_cast<float>(Packet.Axes[Axis]) / MaxValue * 2.0f - 1.0f;
+	}
+
+	FMemory::Memcpy(OutState.Buttons, Packet.Buttons, sizeof(Packet.Buttons));
+}
+
+void FInputPacketCodec::Serialize(FArchive& Ar, FInputPacket& Packet, const FInputPacket& Baseline) const
+{
+	for (uint32 Axis = 0; Axis < Format.NumAxes; Axis++)
+	{
+		uint8 bChanged = Packet.Axes[Axis] != Baseline.Axes[Axis];
+		Ar.SerializeBits(&bChanged, 1);
+
+		if (bChanged)
+		{
+			SerializeValue(Ar, Packet.Axes[Axis], Format.AxisBits[Axis]);
+		}
+		else if (Ar.IsLoading())
+		{
+			Packet.Axes[Axis] = Baseline.Axes[Axis];
+		}
+	}
+
+	for (uint32 Word = 0; Word * 32 < Format.NumButtons; Word++)
+	{
+		const uint32 Count = FMath::Min(Format.NumButtons - Word * 32, 32u);
+
+		uint8 bChanged = Packet.Buttons[Word] != Baseline.Buttons[Word];
+		Ar.SerializeBits(&bChanged, 1);
+
+		if (bChanged)
+		{
+			SerializeValue(Ar, Packet.Buttons[Word], Count);
+		}
+		else if (Ar.IsLoading())
+		{
+			Packet.Buttons[Word] = Baseline.Buttons[Word];
+		}
+	}
+}
+
+uint32 FInputPacketCodec::GetSerializedBits(const FInputPacket& Packet, const FInputPacket& Baseline) const
+{
+	uint32 Bits = 0;
+
+	for (uint32 Axis = 0; Axis < Format.NumAxes; Axis++)
+	{
+		Bits += 1 + (Packet.Axes[Axis] != Baseline.Axes[Axis] ? Format.AxisBits[Axis] : 0);
+	}
+
+	for (uint32 Word = 0; Word * 32 < Format.NumButtons; Word++)
+	{
+		Bits += 1 + (Packet.Buttons[Word] != Baseline.Buttons[Word] ? FMath::Min(Format.NumButtons - Word * 32, 32u) : 0);
+	}
+
+	return Bits;
+}
@@ -1,600 +1,1526 @@
-﻿/* 
- * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
- * 
- * Permission is hereby granted, free of charge, to any person obtaining a copy of 
- * this software and associated documentation files (the "Software"), to deal in the 
- * Software without restriction, including without limitation the rights to use, copy, 
- * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
- * and to permit persons to whom the Software is furnished to do so, subject to the 
- * following conditions:
- *
- * The above copyright notice and this permission notice shall be included in all 
- * copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
- * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
- * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
- * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
- * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
- * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
-*/
-
-#include "Joystick.h"
-
-DEFINE_LOG_CATEGORY_STATIC(LogJoystick, Log, All);
-
-static FString GuidToString(const GUID Guid)
-{
-	WCHAR* WcharGuid = nullptr;
-	switch (StringFromCLSID(Guid, &WcharGuid))
-	{
-	case E_OUTOFMEMORY:
-		return TEXT("");
-	default:
-		break;
-	}
-
-	FString StringGuid = WcharGuid;
-	CoTaskMemFree(WcharGuid);
-	return StringGuid;
-}
-
-static HWND GetWindowHandle()
-{
-	HWND hWnd = nullptr;
-
-	const FWindowsApplication* WindowsApplication = static_cast<FWindowsApplication*>(FSlateApplication::Get().GetPlatformApplication().Get());
-	check(WindowsApplication);
-
-	const TSharedPtr<SWindow> ParentWindow = FSlateApplication::Get().GetActiveTopLevelWindow();
-	if (ParentWindow.IsValid()  && (ParentWindow->GetNativeWindow().IsValid()))
-	{
-		hWnd = static_cast<HWND>(ParentWindow->GetNativeWindow()->GetOSWindowHandle());
-	}
-
-	return hWnd;
-}
-
-static BOOL CALLBACK StaticEnumerateAxes(LPCDIDEVICEOBJECTINSTANCE objectInstance, LPVOID pvRef)
-{
-	const auto Instance = static_cast<FJoystick*>(pvRef);
-	return Instance->EnumerateAxes(objectInstance);
-}
-
-BOOL FJoystick::EnumerateAxes(LPCDIDEVICEOBJECTINSTANCE ObjectInstance)
-{
-	UE_LOG(LogJoystick, Display, TEXT("%s 0x%02X, 0x%02X '%s' : %d N / %d, actuator %d"),
-		*GuidToString(ObjectInstance->guidType),
-		ObjectInstance->wUsagePage,
-		ObjectInstance->wUsage,
-		ObjectInstance->tszName,
-		ObjectInstance->dwFFMaxForce,
-		ObjectInstance->dwFFForceResolution,
-		ObjectInstance->dwFlags & DIDOI_FFACTUATOR
-		);
-	
-	if (ObjectInstance->wUsagePage == 0x01)
-	{
-		switch (ObjectInstance->wUsage)
-		{
-		case 0x30: // X
-			AxisInstances[0] = ObjectInstance;
-			break;
-		case 0x31: // Y
-			AxisInstances[1] = ObjectInstance;
-			break;
-		case 0x32: // Z
-			AxisInstances[2] = ObjectInstance;
-			break;
-		case 0x33: // Rx
-			AxisInstances[3] = ObjectInstance;
-			break;
-		case 0x34: // Ry
-			AxisInstances[4] = ObjectInstance;
-			break;
-		case 0x35: // Rz
-			AxisInstances[5] = ObjectInstance;
-			break;
-		case 0x36: // Slider
-			AxisInstances[6] = ObjectInstance;
-			break;
-		case 0x37: // Dial
-			AxisInstances[7] = ObjectInstance;
-			break;
-		default:
-			UE_LOG(LogJoystick, Warning, TEXT("Unknown axis 0x%02X"), ObjectInstance->wUsage);
-			break;
-		}
-	}
-	else
-	{
-		UE_LOG(LogJoystick, Warning, TEXT("Unsupported HID page 0x%02X, usage 0x%02X"), ObjectInstance->wUsagePage, ObjectInstance->wUsage);		
-	}
-
-	return DIENUM_CONTINUE;
-}
-
-FJoystick::FJoystick(LPDIRECTINPUTDEVICE8 device) :
-	Device(device),
-	Available(false)
-{
-	ZeroMemory(&Instance, sizeof(DIDEVICEINSTANCE));
-	ZeroMemory(&Capabilities, sizeof(DIDEVCAPS));
-	ZeroMemory(&CurrentState, sizeof(DIJOYSTATE2));
-	ZeroMemory(&PreviousState, sizeof(DIJOYSTATE2));
-
-	Instance.dwSize = sizeof(DIDEVICEINSTANCE);
-	Capabilities.dwSize = sizeof(DIDEVCAPS);
-
-	if (TryAcquireDevice())
-	{
-		GetDeviceInfo();
-		GetCapabilities();
-		GetObjects();
-		CreateEffect(0);
-	}
-
-	UE_LOG(LogJoystick, Display, TEXT("%s %s has %d axes, %d buttons and %d POVs"), *GetInstanceName(), *GetInstanceGuidAsString(), GetNumAxes(), GetNumButtons(), GetNumPovs());
-}
-
-void FJoystick::Release() const
-{
-	Device->Unacquire();
-	Effect->Release();
-	Device->Release();
-}
-
-GUID FJoystick::GetProductGui() const
-{
-	return Instance.guidProduct;
-}
-
-FString FJoystick::GetProductGuidAsString() const
-{
-	return GuidToString(Instance.guidProduct);
-}
-
-FString FJoystick::GetProductName() const
-{
-	return FString(Instance.tszProductName);
-}
-
-GUID FJoystick::GetInstanceGuid() const
-{
-	return Instance.guidInstance;
-}
-
-FString FJoystick::GetInstanceGuidAsString() const
-{
-	return GuidToString(Instance.guidInstance);
-}
-
-FString FJoystick::GetInstanceName() const
-{
-	return FString(Instance.tszInstanceName);
-}
-
-GUID FJoystick::GetForceDriverGuid() const
-{
-	return Instance.guidFFDriver;
-}
-
-FString FJoystick::GetForceDriverGuidAsString() const
-{
-	return GuidToString(Instance.guidFFDriver);
-}
-
-bool FJoystick::TryAcquireDevice()
-{
-	Device->Unacquire();
-
-	switch (Device->SetCooperativeLevel(GetWindowHandle(), DISCL_BACKGROUND | DISCL_EXCLUSIVE))
-	{
-	case DIERR_INVALIDPARAM:
-		UE_LOG(LogJoystick, Error, TEXT("SetCooperativeLevel: Invalid parameter"));
-		break;
-	case DIERR_NOTINITIALIZED:
-		UE_LOG(LogJoystick, Error, TEXT("SetCooperativeLevel: Not initialized"));
-		break;
-	case E_HANDLE:
-		UE_LOG(LogJoystick, Error, TEXT("SetCooperativeLevel: Handle"));
-		break;
-	default:
-		break;
-	}
-
-	switch (Device->SetDataFormat(&c_dfDIJoystick2))
-	{
-	case DIERR_ACQUIRED:
-		UE_LOG(LogJoystick, Error, TEXT("SetDataFormat: Acquired"));
-		break;
-	case DIERR_INVALIDPARAM:
-		UE_LOG(LogJoystick, Error, TEXT("SetDataFormat: Invalid parameter"));
-		break;
-	case DIERR_NOTINITIALIZED:
-		UE_LOG(LogJoystick, Error, TEXT("SetDataFormat: Not initialized"));
-		break;
-	default:
-		break;
-	}
-
-	switch (Device->Acquire())
-	{
-	case DIERR_INVALIDPARAM:
-		UE_LOG(LogJoystick, Error, TEXT("Acquire: Invalid parameter"));
-		Available = false;
-		return false;
-	case DIERR_NOTINITIALIZED:
-		UE_LOG(LogJoystick, Error, TEXT("Acquire: Not initialized"));
-		Available = false;
-		return false;
-	case DIERR_OTHERAPPHASPRIO:
-		UE_LOG(LogJoystick, Error, TEXT("Acquire: Other application has priority"));
-		Available = false;
-		return false;
-	default:
-		Available = true;
-		return true;
-	}
-}
-
-bool FJoystick::GetDeviceInfo()
-{
-	switch (Device->GetDeviceInfo(&Instance))
-	{
-	case DIERR_INVALIDPARAM:
-		UE_LOG(LogJoystick, Error, TEXT("GetDeviceInfo: Invalid parameter"));
-		return false;
-	case DIERR_NOTINITIALIZED:
-		UE_LOG(LogJoystick, Error, TEXT("GetDeviceInfo: Not initialized"));
-		return false;
-	case E_POINTER:
-		UE_LOG(LogJoystick, Error, TEXT("GetDeviceInfo: Pointer"));
-		return false;
-	default:
-		return true;
-	}
-}
-
-bool FJoystick::GetCapabilities()
-{
-	switch (Device->GetCapabilities(&Capabilities))
-	{
-	case DIERR_INVALIDPARAM:
-		UE_LOG(LogJoystick, Error, TEXT("GetCapabilities: Invalid parameter"));
-		return false;
-	case DIERR_NOTINITIALIZED:
-		UE_LOG(LogJoystick, Error, TEXT("GetCapabilities: Not initialized"));
-		return false;
-	case E_POINTER:
-		UE_LOG(LogJoystick, Error, TEXT("GetCapabilities: Pointer"));
-		return false;
-	default:
-		return true;
-	}
-}
-
-void FJoystick::GetObjects()
-{
-	Device->EnumObjects(&StaticEnumerateAxes, this, DIDFT_AXIS); // DIDFT_AXIS | DIDFT_FFACTUATOR
-}
-
-bool FJoystick::Poll()
-{
-	switch (Device->Poll())
-	{
-	case DIERR_INPUTLOST:
-		UE_LOG(LogJoystick, Error, TEXT("Poll: Input lost"));
-		TryAcquireDevice();
-		return false;
-	case DIERR_NOTINITIALIZED:
-		UE_LOG(LogJoystick, Error, TEXT("Poll: Not initialized"));
-		TryAcquireDevice();
-		return false;
-	case DIERR_NOTACQUIRED:
-		UE_LOG(LogJoystick, Error, TEXT("Poll: Not acquired"));
-		TryAcquireDevice();
-		return false;
-	case DIERR_OTHERAPPHASPRIO:
-		UE_LOG(LogJoystick, Error, TEXT("Poll: Other application has priority"));
-		return false;
-	default:
-		break;
-	}
-
-	CopyMemory(&PreviousState, &CurrentState, sizeof(DIJOYSTATE2));
-	ZeroMemory(&CurrentState, sizeof(DIJOYSTATE2));
-
-	switch (Device->GetDeviceState(sizeof(DIJOYSTATE2), &CurrentState))
-	{
-	case DIERR_INPUTLOST:
-		UE_LOG(LogJoystick, Error, TEXT("GetDeviceState: Input lost"));
-		TryAcquireDevice();
-		return false;
-	case DIERR_INVALIDPARAM:
-		UE_LOG(LogJoystick, Error, TEXT("GetDeviceState: Invalid parameter"));
-		TryAcquireDevice();
-		return false;
-	case DIERR_NOTINITIALIZED:
-		UE_LOG(LogJoystick, Error, TEXT("GetDeviceState: Not initialized"));
-		TryAcquireDevice();
-		return false;
-	case DIERR_NOTACQUIRED:
-		UE_LOG(LogJoystick, Error, TEXT("GetDeviceState: Not acquired"));
-		TryAcquireDevice();
-		return false;
-	case E_PENDING:
-		UE_LOG(LogJoystick, Error, TEXT("GetDeviceState: Pending"));
-		return false;
-	default:
-		break;
-	}
-
-	return true;
-}
-
-int32 FJoystick::GetAxisValue(const uint32 Axis) const
-{
-	int32 Value;
-
-	switch (Axis)
-	{
-	case 0:
-		Value = CurrentState.lX;
-		break;
-	case 1:
-		Value = CurrentState.lY;
-		break;
-	case 2:
-		Value = CurrentState.lZ;
-		break;
-	case 3:
-		Value = CurrentState.lRx;
-		break;
-	case 4:
-		Value = CurrentState.lRy;
-		break;
-	case 5:
-		Value = CurrentState.lRz;
-		break;
-	case 6:
-		Value = CurrentState.rglSlider[0];
-		break;
-	case 7:
-		Value = CurrentState.rglSlider[1];
-		break;
-	default:
-		Value = 0;
-		break;
-	}
-
-	return Value;
-}
-
-int32 FJoystick::GetButtonValue(const uint32 Button) const
-{
-	if (Button < GetNumButtons())
-		return (CurrentState.rgbButtons[Button] & 0x80) ? 1 : 0;
-
-	return 0;
-}
-
-int32 FJoystick::GetPovValue(const uint32 Pov) const
-{
-	if (Pov < GetNumPovs())
-		return static_cast<int>(CurrentState.rgdwPOV[Pov]);
-
-	return 0;
-}
-
-bool FJoystick::IsAxisChanged(const uint32 Axis) const
-{
-	switch (Axis)
-	{
-	case 0:
-		return CurrentState.lX != PreviousState.lX;
-	case 1:
-		return CurrentState.lY != PreviousState.lY;
-	case 2:
-		return CurrentState.lZ != PreviousState.lZ;
-	case 3:
-		return CurrentState.lRx != PreviousState.lRx;
-	case 4:
-		return CurrentState.lRy != PreviousState.lRy;
-	case 5:
-		return CurrentState.lRz != PreviousState.lRz;
-	case 6:
-		return CurrentState.rglSlider[0] != PreviousState.rglSlider[0];
-	case 7:
-		return CurrentState.rglSlider[1] != PreviousState.rglSlider[1];
-	default:
-		return false;
-	}
-}
-
-bool FJoystick::IsButtonChanged(const uint32 Button) const
-{
-	if (Button < GetNumButtons())
-		return CurrentState.rgbButtons[Button] != PreviousState.rgbButtons[Button];
-
-	return false;
-}
-
-bool FJoystick::IsPovChanged(const uint32 Pov) const
-{
-	if (Pov < GetNumPovs())
-		return CurrentState.rgdwPOV[Pov] != PreviousState.rgdwPOV[Pov];
-
-	return false;
-}
-
-FString FJoystick::GetAxisName(const uint32 Axis) const
-{
-	if (Axis > 7 || AxisInstances[Axis] == nullptr)
-		return "";
-
-	return AxisInstances[Axis]->tszName;
-}
-
-uint32 FJoystick::GetAxisMaxForce(const uint32 Axis) const
-{
-	if (Axis > 7 || AxisInstances[Axis] == nullptr)
-		return 0;
-
-	return AxisInstances[Axis]->dwFFMaxForce;
-}
-
-uint32 FJoystick::GetAxisForceResolution(const uint32 Axis) const
-{
-	if (Axis > 7 || AxisInstances[Axis] == nullptr)
-		return 0;
-
-	return AxisInstances[Axis]->dwFFForceResolution;
-}
-
-bool FJoystick::IsForceActuator(uint32 Axis) const
-{
-	if (Axis > 7 || AxisInstances[Axis] == nullptr)
-		return false;
-
-	return AxisInstances[Axis]->dwFlags & DIDOI_FFACTUATOR;
-}
-
-bool FJoystick::CreateEffect(uint32 Axis)
-{
-	DWORD dwAxis;
-	switch (Axis)
-	{
-	case 0:
-		dwAxis = DIJOFS_X;
-		break;
-	case 1:
-		dwAxis = DIJOFS_Y;
-		break;
-	case 2:
-		dwAxis = DIJOFS_Z;
-		break;
-	case 3:
-		dwAxis = DIJOFS_RX;
-		break;
-	case 4:
-		dwAxis = DIJOFS_RY;
-		break;
-	case 5:
-		dwAxis = DIJOFS_RZ;
-		break;
-	case 6:
-		dwAxis = DIJOFS_SLIDER(0);
-		break;
-	case 7:
-		dwAxis = DIJOFS_SLIDER(1);
-		break;
-	default:
-		UE_LOG(LogJoystick, Warning, TEXT("Force feedback axis %d does not exist on %s"), Axis, *GetInstanceName());
-		return false;
-	}
-
-	DICONSTANTFORCE diConstantForce;
-	diConstantForce.lMagnitude = 0;
-
-	LONG direction = 0;
-
-	ZeroMemory(&EffectConfig, sizeof(DIEFFECT));
-	EffectConfig.dwSize = sizeof(DIEFFECT); 
-	EffectConfig.dwFlags = DIEFF_CARTESIAN | DIEFF_OBJECTOFFSETS;
-	EffectConfig.dwDuration = INFINITE;
-	EffectConfig.dwSamplePeriod = 0;
-	EffectConfig.dwGain = DI_FFNOMINALMAX;
-	EffectConfig.dwTriggerButton = DIEB_NOTRIGGER;
-	EffectConfig.dwTriggerRepeatInterval = 0;
-	EffectConfig.cAxes = 1;
-	EffectConfig.rgdwAxes = &dwAxis;
-	EffectConfig.rglDirection = &direction;
-	EffectConfig.lpEnvelope = nullptr;
-	EffectConfig.cbTypeSpecificParams = sizeof(DICONSTANTFORCE);
-	EffectConfig.lpvTypeSpecificParams = &diConstantForce;  
-
-	switch (Device->CreateEffect(GUID_ConstantForce, &EffectConfig, &Effect, nullptr))
-	{
-	case DIERR_DEVICEFULL:
-		UE_LOG(LogJoystick, Error, TEXT("CreateEffect: Device full : %s"), *GetInstanceGuidAsString());
-		return false;
-	case DIERR_DEVICENOTREG:
-		UE_LOG(LogJoystick, Error, TEXT("CreateEffect: Device not registered : %s"), *GetInstanceGuidAsString());
-		return false;
-	case DIERR_INVALIDPARAM:
-		UE_LOG(LogJoystick, Error, TEXT("CreateEffect: Invalid parameter"));
-		return false;
-	case DIERR_NOTINITIALIZED:
-		UE_LOG(LogJoystick, Error, TEXT("CreateEffect: Not initialized"));
-		return false;
-	default:
-		break;
-	}
-
-	switch (Effect->Start(INFINITE, 0))
-	{
-	case DIERR_INCOMPLETEEFFECT:
-		UE_LOG(LogJoystick, Error, TEXT("Start: Incomplete effect"));
-		return false;
-	case DIERR_INVALIDPARAM:
-		UE_LOG(LogJoystick, Error, TEXT("Start: Invalid parameter"));
-		return false;
-	case DIERR_NOTEXCLUSIVEACQUIRED:
-		UE_LOG(LogJoystick, Error, TEXT("Start: Not exclusive acquired"));
-		return false;
-	case DIERR_NOTINITIALIZED:
-		UE_LOG(LogJoystick, Error, TEXT("Start: Not initialized"));
-		return false;
-	case DIERR_UNSUPPORTED:
-		UE_LOG(LogJoystick, Error, TEXT("Start: Unsupported"));
-		return false;
-	default:
-		return true;
-	}
-}
-
-bool FJoystick::UpdateEffect(const int Magnitude)
-{
-	DICONSTANTFORCE diConstantForce;
-	diConstantForce.lMagnitude = Magnitude;
-
-	EffectConfig.cbTypeSpecificParams = sizeof(DICONSTANTFORCE);
-	EffectConfig.lpvTypeSpecificParams = &diConstantForce;
-
-	switch (Effect->SetParameters(&EffectConfig, DIEP_TYPESPECIFICPARAMS | DIEP_START))
-	{
-	case DIERR_NOTINITIALIZED:
-		UE_LOG(LogJoystick, Error, TEXT("SetParameters: Not initialized"));
-		return false;
-	case DIERR_INCOMPLETEEFFECT:
-		UE_LOG(LogJoystick, Error, TEXT("SetParameters: Incomplete effect"));
-		return false;
-	case DIERR_INPUTLOST:
-		UE_LOG(LogJoystick, Error, TEXT("SetParameters: Input lost"));
-		return false;
-	case DIERR_INVALIDPARAM:
-		UE_LOG(LogJoystick, Error, TEXT("SetParameters: Invalid parameter"));
-		return false;
-	case DIERR_EFFECTPLAYING:
-		UE_LOG(LogJoystick, Error, TEXT("SetParameters: Effect playing"));
-		return false;
-	default:
-		return true;
-	}
-}
-
-bool FJoystick::StopEffect() const
-{
-	switch (Effect->Stop())
-	{
-	case DIERR_NOTEXCLUSIVEACQUIRED:
-		UE_LOG(LogJoystick, Error, TEXT("Stop: Not exclusive acquired"));
-		return false;
-	case DIERR_NOTINITIALIZED:
-		UE_LOG(LogJoystick, Error, TEXT("Stop: Not initialized"));
-		return false;
-	default:
-		return true;
-	}
-}
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "Joystick.h"
+#include "DirectInput.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogJoystick, Log, All);
+
+DECLARE_CYCLE_STAT(TEXT("Update Effect"), STAT_DirectInput_UpdateEffect, STATGROUP_DirectInput);
+
+static FString GuidToString(const GUID Guid)
+{
+	WCHAR* WcharGuid = nullptr;
+	switch (StringFromCLSID(Guid, &WcharGuid))
+	{
+	case E_OUTOFMEMORY:
+		return TEXT("");
+	default:
+		break;
+	}
+
+	FString StringGuid = WcharGuid;
+	CoTaskMemFree(WcharGuid);
+	return StringGuid;
+}
+
+static HWND GetWindowHandle()
+{
+	HWND hWnd = nullptr;
+
+	const FWindowsApplication* WindowsApplication = static_cast<FWindowsApplication*>(FSlateApplication::Get().GetPlatformApplication().Get());
+	check(WindowsApplication);
+
+	const TSharedPtr<SWindow> ParentWindow = FSlateApplication::Get().GetActiveTopLevelWindow();
+	if (ParentWindow.IsValid()  && (ParentWindow->GetNativeWindow().IsValid()))
+	{
+		hWnd = static_cast<HWND>(ParentWindow->GetNativeWindow()->GetOSWindowHandle());
+	}
+
+	return hWnd;
+}
+
+static uint32 DecodePov(const DWORD Value)
+{
+	// Centred is reported with 0xFFFF in the low word, anything else is hundredths of degrees clockwise from up
+	if (LOWORD(Value) == 0xFFFF)
+		return FJoystick::PovCentered;
+
+	return ((Value + 2250) / 4500) % FJoystick::NumPovDirections;
+}
+
+static EDeviceAxis GetDeviceAxis(const GUID& Type)
+{
+	static const GUID* const AxisGuids[] = { &GUID_XAxis, &GUID_YAxis, &GUID_ZAxis, &GUID_RxAxis, &GUID_RyAxis, &GUID_RzAxis, &GUID_Slider };
+	static_assert(UE_ARRAY_COUNT(AxisGuids) == static_cast<uint32>(EDeviceAxis::Unknown), "Every axis needs a GUID");
+
+	for (uint32 Axis = 0; Axis < UE_ARRAY_COUNT(AxisGuids); Axis++)
+	{
+		if (Type == *AxisGuids[Axis])
+		{
+			return static_cast<EDeviceAxis>(Axis);
+		}
+	}
+	return EDeviceAxis::Unknown;
+}
+
+static BOOL CALLBACK StaticEnumerateObjects(LPCDIDEVICEOBJECTINSTANCE objectInstance, LPVOID pvRef)
+{
+	const auto Instance = static_cast<FJoystick*>(pvRef);
+	return Instance->EnumerateObjects(objectInstance);
+}
+
+BOOL FJoystick::EnumerateObjects(LPCDIDEVICEOBJECTINSTANCE ObjectInstance)
+{
+	UE_LOG(LogJoystick, Display, TEXT("%s 0x%02X, 0x%02X '%s' : %d N / %d, actuator %d"),
+		*GuidToString(ObjectInstance->guidType),
+		ObjectInstance->wUsagePage,
+		ObjectInstance->wUsage,
+		ObjectInstance->tszName,
+		ObjectInstance->dwFFMaxForce,
+		ObjectInstance->dwFFForceResolution,
+		ObjectInstance->dwFlags & DIDOI_FFACTUATOR
+		);
+
+	// The instance is only valid during the callback, so copy what we need
+	FDeviceObject& Object = Info->Objects.AddDefaulted_GetRef();
+	Object.Type = ObjectInstance->dwType;
+	Object.Flags = ObjectInstance->dwFlags;
+	Object.UsagePage = ObjectInstance->wUsagePage;
+	Object.Usage = ObjectInstance->wUsage;
+	Object.MaxForce = ObjectInstance->dwFFMaxForce;
+	Object.ForceResolution = ObjectInstance->dwFFForceResolution;
+	Object.Name = ObjectInstance->tszName;
+
+	if (ObjectInstance->dwType & DIDFT_AXIS)
+	{
+		Object.Axis = GetDeviceAxis(ObjectInstance->guidType);
+
+		// The range is needed to normalise the axis, drivers default to 0..65535
+		DIPROPRANGE Range;
+		Range.diph.dwSize = sizeof(DIPROPRANGE);
+		Range.diph.dwHeaderSize = sizeof(DIPROPHEADER);
+		Range.diph.dwObj = ObjectInstance->dwType;
+		Range.diph.dwHow = DIPH_BYID;
+		if (SUCCEEDED(Device->GetProperty(DIPROP_RANGE, &Range.diph)) && Range.lMax > Range.lMin)
+		{
+			Object.RangeMin = Range.lMin;
+			Object.RangeMax = Range.lMax;
+		}
+	}
+
+	return DIENUM_CONTINUE;
+}
+
+FJoystick::FJoystick(LPDIRECTINPUTDEVICE8 device, FDeviceCache* Cache) :
+	Device(device),
+	Info(MakeUnique<FInfo>()),
+	Normalizer(nullptr),
+	Snapshot(nullptr),
+	Telemetry(nullptr),
+	NumAxes(0),
+	NumButtons(0),
+	NumPovs(0),
+	PovOffset(0),
+	ButtonOffset(0),
+	DataSize(0),
+	StateIndex(0),
+	NormalizerLane(0),
+	Available(false),
+	bPolledDevice(false),
+	bInputLost(false),
+	bCalibrating(false),
+	bSoftwareConditions(false)
+{
+	FMemory::Memzero(StateSlots);
+
+	ZeroMemory(&Info->Instance, sizeof(DIDEVICEINSTANCE));
+	ZeroMemory(&Info->Capabilities, sizeof(DIDEVCAPS));
+	ZeroMemory(Info->AxisCalibrations, sizeof(Info->AxisCalibrations));
+	ZeroMemory(Info->ObservedMin, sizeof(Info->ObservedMin));
+	ZeroMemory(Info->ObservedMax, sizeof(Info->ObservedMax));
+	ZeroMemory(Info->RestPosition, sizeof(Info->RestPosition));
+	ZeroMemory(Info->FilteredAxes, sizeof(Info->FilteredAxes));
+	ZeroMemory(Info->ConditionEffects, sizeof(Info->ConditionEffects));
+	ZeroMemory(&Info->HistoryState, sizeof(FInputSample));
+	Info->Effect = nullptr;
+	Info->ConstantForce = 0;
+	Info->HardwareConditions = 0;
+	ZeroMemory(Info->StreamEffects, sizeof(Info->StreamEffects));
+	Info->bStreamPeriodic = false;
+	Info->StreamEnd = 0.0;
+	Info->LastStreamUpdate = 0.0;
+	Info->EffectClock = 0;
+	Info->LastFilterTime = 0.0;
+	Info->DeadZone = 0.0f;
+	Info->TelemetrySlot = 0;
+	Info->Keys = &FDirectInputKeys::Shared;
+
+	Info->Instance.dwSize = sizeof(DIDEVICEINSTANCE);
+	Info->Capabilities.dwSize = sizeof(DIDEVCAPS);
+
+	// The data format has to be known before the device can be acquired
+	GetDeviceInfo();
+	GetCapabilities();
+
+	// Known devices take their objects from the cache instead of enumerating them
+	const FDeviceCacheKey CacheKey(ToFGuid(Info->Instance.guidProduct), Info->Capabilities.dwFirmwareRevision, Info->Capabilities.dwHardwareRevision);
+	const TArray<FDeviceObject>* CachedObjects = Cache != nullptr ? Cache->Find(CacheKey) : nullptr;
+	if (CachedObjects != nullptr)
+	{
+		Info->Objects = *CachedObjects;
+	}
+	else
+	{
+		GetObjects();
+
+		if (Cache != nullptr)
+		{
+			Cache->Set(CacheKey, Info->Objects);
+		}
+	}
+
+	BuildDataFormat();
+	ApplyRemap(nullptr);
+
+	if (TryAcquireDevice())
+	{
+		CreateEffect(0);
+	}
+
+	GetConditionSupport();
+
+	UE_LOG(LogJoystick, Display, TEXT("%s %s (product %s) has %d axes, %d buttons and %d POVs"), *GetInstanceName(), *GetInstanceGuidAsString(), *GetProductGuidAsString(), GetNumAxes(), GetNumButtons(), GetNumPovs());
+}
+
+void FJoystick::Release() const
+{
+	FScopeLock Lock(&Info->DeviceLock);
+
+	Device->Unacquire();
+	if (Info->Effect != nullptr)
+	{
+		Info->Effect->Release();
+	}
+	for (LPDIRECTINPUTEFFECT ConditionEffect : Info->ConditionEffects)
+	{
+		if (ConditionEffect != nullptr)
+		{
+			ConditionEffect->Release();
+		}
+	}
+	for (LPDIRECTINPUTEFFECT StreamEffect : Info->StreamEffects)
+	{
+		if (StreamEffect != nullptr)
+		{
+			StreamEffect->Release();
+		}
+	}
+	for (const TPair<FGuid, FInfo::FCachedEffect>& Entry : Info->EffectCache)
+	{
+		for (LPDIRECTINPUTEFFECT CachedEffect : Entry.Value.Handles)
+		{
+			CachedEffect->Release();
+		}
+	}
+	Device->Release();
+}
+
+GUID FJoystick::GetProductGui() const
+{
+	return Info->Instance.guidProduct;
+}
+
+FString FJoystick::GetProductGuidAsString() const
+{
+	return GuidToString(Info->Instance.guidProduct);
+}
+
+FString FJoystick::GetProductName() const
+{
+	return FString(Info->Instance.tszProductName);
+}
+
+GUID FJoystick::GetInstanceGuid() const
+{
+	return Info->Instance.guidInstance;
+}
+
+FString FJoystick::GetInstanceGuidAsString() const
+{
+	return GuidToString(Info->Instance.guidInstance);
+}
+
+const FString& FJoystick::GetInstanceName() const
+{
+	return Info->InstanceName;
+}
+
+GUID FJoystick::GetForceDriverGuid() const
+{
+	return Info->Instance.guidFFDriver;
+}
+
+FString FJoystick::GetForceDriverGuidAsString() const
+{
+	return GuidToString(Info->Instance.guidFFDriver);
+}
+
+bool FJoystick::TryAcquireDevice()
+{
+	FScopeLock Lock(&Info->DeviceLock);
+
+	Device->Unacquire();
+
+	switch (Device->SetCooperativeLevel(GetWindowHandle(), DISCL_BACKGROUND | DISCL_EXCLUSIVE))
+	{
+	case DIERR_INVALIDPARAM:
+		UE_LOG(LogJoystick, Error, TEXT("SetCooperativeLevel: Invalid parameter"));
+		break;
+	case DIERR_NOTINITIALIZED:
+		UE_LOG(LogJoystick, Error, TEXT("SetCooperativeLevel: Not initialized"));
+		break;
+	case E_HANDLE:
+		UE_LOG(LogJoystick, Error, TEXT("SetCooperativeLevel: Handle"));
+		break;
+	default:
+		break;
+	}
+
+	DIDATAFORMAT DataFormat;
+	DataFormat.dwSize = sizeof(DIDATAFORMAT);
+	DataFormat.dwObjSize = sizeof(DIOBJECTDATAFORMAT);
+	DataFormat.dwFlags = DIDF_ABSAXIS;
+	DataFormat.dwDataSize = DataSize;
+	DataFormat.dwNumObjs = Info->ObjectFormats.Num();
+	DataFormat.rgodf = Info->ObjectFormats.GetData();
+
+	switch (Device->SetDataFormat(&DataFormat))
+	{
+	case DIERR_ACQUIRED:
+		UE_LOG(LogJoystick, Error, TEXT("SetDataFormat: Acquired"));
+		break;
+	case DIERR_INVALIDPARAM:
+		UE_LOG(LogJoystick, Error, TEXT("SetDataFormat: Invalid parameter"));
+		break;
+	case DIERR_NOTINITIALIZED:
+		UE_LOG(LogJoystick, Error, TEXT("SetDataFormat: Not initialized"));
+		break;
+	default:
+		break;
+	}
+
+	// Buffered events give the history the time of every change instead of only the time of each poll
+	if (History.IsValid())
+	{
+		DIPROPDWORD BufferSize;
+		BufferSize.diph.dwSize = sizeof(DIPROPDWORD);
+		BufferSize.diph.dwHeaderSize = sizeof(DIPROPHEADER);
+		BufferSize.diph.dwObj = 0;
+		BufferSize.diph.dwHow = DIPH_DEVICE;
+		BufferSize.dwData = HistoryBufferSize;
+		Device->SetProperty(DIPROP_BUFFERSIZE, &BufferSize.diph);
+	}
+
+	const HRESULT Result = Device->Acquire();
+	switch (Result)
+	{
+	case DIERR_INVALIDPARAM:
+		UE_CLOG(!bInputLost, LogJoystick, Error, TEXT("Acquire: Invalid parameter"));
+		Available = false;
+		return false;
+	case DIERR_NOTINITIALIZED:
+		UE_CLOG(!bInputLost, LogJoystick, Error, TEXT("Acquire: Not initialized"));
+		Available = false;
+		return false;
+	case DIERR_OTHERAPPHASPRIO:
+		UE_CLOG(!bInputLost, LogJoystick, Error, TEXT("Acquire: Other application has priority"));
+		Available = false;
+		return false;
+	default:
+		// Anything else that fails, such as an unplugged device, is not acquired either
+		Available = SUCCEEDED(Result);
+		return Available;
+	}
+}
+
+bool FJoystick::GetDeviceInfo()
+{
+	switch (Device->GetDeviceInfo(&Info->Instance))
+	{
+	case DIERR_INVALIDPARAM:
+		UE_LOG(LogJoystick, Error, TEXT("GetDeviceInfo: Invalid parameter"));
+		return false;
+	case DIERR_NOTINITIALIZED:
+		UE_LOG(LogJoystick, Error, TEXT("GetDeviceInfo: Not initialized"));
+		return false;
+	case E_POINTER:
+		UE_LOG(LogJoystick, Error, TEXT("GetDeviceInfo: Pointer"));
+		return false;
+	default:
+		Info->InstanceName = Info->Instance.tszInstanceName;
+		return true;
+	}
+}
+
+bool FJoystick::GetCapabilities()
+{
+	switch (Device->GetCapabilities(&Info->Capabilities))
+	{
+	case DIERR_INVALIDPARAM:
+		UE_LOG(LogJoystick, Error, TEXT("GetCapabilities: Invalid parameter"));
+		return false;
+	case DIERR_NOTINITIALIZED:
+		UE_LOG(LogJoystick, Error, TEXT("GetCapabilities: Not initialized"));
+		return false;
+	case E_POINTER:
+		UE_LOG(LogJoystick, Error, TEXT("GetCapabilities: Pointer"));
+		return false;
+	default:
+		bPolledDevice = (Info->Capabilities.dwFlags & DIDC_POLLEDDEVICE) != 0;
+		return true;
+	}
+}
+
+void FJoystick::GetObjects()
+{
+	Device->EnumObjects(&StaticEnumerateObjects, this, DIDFT_AXIS | DIDFT_POV | DIDFT_BUTTON);
+}
+
+void FJoystick::BuildDataFormat()
+{
+	// Lay the state out as axes (LONG), POVs (DWORD) and buttons (BYTE) so each type is contiguous
+	const TArray<FDeviceObject> Enumerated = MoveTemp(Info->Objects);
+	Info->Objects.Reset(Enumerated.Num());
+
+	AddAxes(Enumerated);
+
+	PovOffset = DataSize;
+	AddObjects(Enumerated, DIDFT_POV, MaxPovs, sizeof(DWORD), NumPovs);
+
+	ButtonOffset = DataSize;
+	AddObjects(Enumerated, DIDFT_BUTTON, MaxButtons, sizeof(BYTE), NumButtons);
+
+	// DirectInput requires the data size to be a multiple of a DWORD
+	DataSize = Align(DataSize, sizeof(DWORD));
+
+	check(DataSize <= MaxDataSize);
+
+	for (uint32 Axis = 0; Axis < NumAxes; Axis++)
+	{
+		FAxisCalibration& Calibration = Info->AxisCalibrations[Axis];
+		Calibration.Min = Info->Objects[Axis].RangeMin;
+		Calibration.Center = Info->Objects[Axis].RangeMin + (Info->Objects[Axis].RangeMax - Info->Objects[Axis].RangeMin) / 2;
+		Calibration.Max = Info->Objects[Axis].RangeMax;
+		Calibration.bInvert = false;
+	}
+}
+
+void FJoystick::AddAxes(const TArray<FDeviceObject>& Enumerated)
+{
+	TArray<int32> Indices;
+	NumAxes = GetAxisIndices(Enumerated, MaxAxes, Indices);
+
+	// Axes keep their DIJOYSTATE index, so an index the device has no axis for stays in the layout. It isn't part of
+	// the data format and reads as centred.
+	FDeviceObject Missing;
+	Missing.RangeMin = -1;
+	Missing.RangeMax = 1;
+	Info->Objects.Init(Missing, NumAxes);
+
+	for (int32 Index = 0; Index < Enumerated.Num(); Index++)
+	{
+		const FDeviceObject& Object = Enumerated[Index];
+		if (!(Object.Type & DIDFT_AXIS))
+		{
+			continue;
+		}
+
+		if (Indices[Index] == INDEX_NONE)
+		{
+			UE_LOG(LogJoystick, Warning, TEXT("Ignoring '%s' on %s, only %d objects of its type are supported"), *Object.Name, *GetInstanceName(), MaxAxes);
+			continue;
+		}
+
+		Info->Objects[Indices[Index]] = Object;
+
+		DIOBJECTDATAFORMAT& ObjectFormat = Info->ObjectFormats.AddZeroed_GetRef();
+		ObjectFormat.dwOfs = Indices[Index] * sizeof(LONG);
+		ObjectFormat.dwType = Object.Type;
+	}
+
+	DataSize = NumAxes * sizeof(LONG);
+}
+
+void FJoystick::AddObjects(const TArray<FDeviceObject>& Enumerated, const DWORD TypeMask, const uint32 MaxCount, const uint32 Size, uint32& OutCount)
+{
+	for (const FDeviceObject& Object : Enumerated)
+	{
+		if (!(Object.Type & TypeMask))
+		{
+			continue;
+		}
+
+		if (OutCount >= MaxCount)
+		{
+			UE_LOG(LogJoystick, Warning, TEXT("Ignoring '%s' on %s, only %d objects of its type are supported"), *Object.Name, *GetInstanceName(), MaxCount);
+			continue;
+		}
+
+		Info->Objects.Add(Object);
+
+		DIOBJECTDATAFORMAT& ObjectFormat = Info->ObjectFormats.AddZeroed_GetRef();
+		ObjectFormat.dwOfs = DataSize;
+		ObjectFormat.dwType = Object.Type;
+
+		DataSize += Size;
+		OutCount++;
+	}
+}
+
+bool FJoystick::ReadState(const uint32 NextIndex)
+{
+	switch (IsPolledDevice() ? Device->Poll() : DI_NOEFFECT)
+	{
+	case DIERR_INPUTLOST:
+		UE_CLOG(!bInputLost, LogJoystick, Error, TEXT("Poll: Input lost"));
+		TryAcquireDevice();
+		return false;
+	case DIERR_NOTINITIALIZED:
+		UE_CLOG(!bInputLost, LogJoystick, Error, TEXT("Poll: Not initialized"));
+		TryAcquireDevice();
+		return false;
+	case DIERR_NOTACQUIRED:
+		UE_CLOG(!bInputLost, LogJoystick, Error, TEXT("Poll: Not acquired"));
+		TryAcquireDevice();
+		return false;
+	case DIERR_OTHERAPPHASPRIO:
+		UE_CLOG(!bInputLost, LogJoystick, Error, TEXT("Poll: Other application has priority"));
+		return false;
+	default:
+		break;
+	}
+
+	switch (Device->GetDeviceState(DataSize, StateSlots[NextIndex]))
+	{
+	case DIERR_INPUTLOST:
+		UE_CLOG(!bInputLost, LogJoystick, Error, TEXT("GetDeviceState: Input lost"));
+		TryAcquireDevice();
+		return false;
+	case DIERR_INVALIDPARAM:
+		UE_CLOG(!bInputLost, LogJoystick, Error, TEXT("GetDeviceState: Invalid parameter"));
+		TryAcquireDevice();
+		return false;
+	case DIERR_NOTINITIALIZED:
+		UE_CLOG(!bInputLost, LogJoystick, Error, TEXT("GetDeviceState: Not initialized"));
+		TryAcquireDevice();
+		return false;
+	case DIERR_NOTACQUIRED:
+		UE_CLOG(!bInputLost, LogJoystick, Error, TEXT("GetDeviceState: Not acquired"));
+		TryAcquireDevice();
+		return false;
+	case E_PENDING:
+		UE_CLOG(!bInputLost, LogJoystick, Error, TEXT("GetDeviceState: Pending"));
+		return false;
+	default:
+		break;
+	}
+
+	return true;
+}
+
+bool FJoystick::Poll()
+{
+	// The force feedback thread may be updating an effect of the device
+	FScopeLock Lock(&Info->DeviceLock);
+
+	// Read into the previous slot and only make it current once the read succeeded
+	const uint32 NextIndex = StateIndex ^ 1;
+
+	// An unplugged device fails every poll, only the first failure and the recovery are logged
+	if (!ReadState(NextIndex))
+	{
+		bInputLost = true;
+		return false;
+	}
+
+	if (bInputLost)
+	{
+		UE_LOG(LogJoystick, Display, TEXT("%s %s recovered"), *GetInstanceName(), *GetInstanceGuidAsString());
+		bInputLost = false;
+	}
+
+	StateIndex = NextIndex;
+
+	if (Filter.IsValid())
+	{
+		FilterAxes();
+	}
+
+	if (bCalibrating)
+	{
+		RecordExtents();
+	}
+
+	// Devices that can't buffer, or whose buffer overflowed, only have the time of the poll
+	if (History.IsValid() && !RecordEvents())
+	{
+		RecordSample();
+	}
+
+	// Normalised and published once every device has been polled
+	if (Normalizer != nullptr)
+	{
+		float* Input = Normalizer->GetInput(NormalizerLane);
+		for (uint32 Axis = 0; Axis < NumAxes; Axis++)
+		{
+			Input[Axis] = GetFilteredAxisValue(Axis);
+		}
+	}
+
+	return true;
+}
+
+void FJoystick::EnableHistory(const uint32 Capacity)
+{
+	FScopeLock Lock(&Info->DeviceLock);
+
+	History = MakeShared<FInputHistory, ESPMode::ThreadSafe>(Capacity);
+	FillSample(GetCurrentState(), Info->HistoryState);
+
+	// The buffer size can only be set while the device isn't acquired
+	TryAcquireDevice();
+}
+
+void FJoystick::FillSample(const uint8* State, FInputSample& OutSample) const
+{
+	ZeroMemory(&OutSample, sizeof(FInputSample));
+	CopyMemory(OutSample.Axes, State, NumAxes * sizeof(LONG));
+	CopyMemory(OutSample.Povs, State + PovOffset, NumPovs * sizeof(DWORD));
+	for (uint32 Button = 0; Button < NumButtons; Button++)
+	{
+		if (State[ButtonOffset + Button] & 0x80)
+		{
+			OutSample.Buttons[Button / 32] |= 1u << (Button % 32);
+		}
+	}
+}
+
+void FJoystick::RecordSample()
+{
+	FillSample(GetCurrentState(), Info->HistoryState);
+	Info->HistoryState.Time = FPlatformTime::Seconds();
+	History->Push(Info->HistoryState);
+}
+
+bool FJoystick::RecordEvents()
+{
+	DIDEVICEOBJECTDATA Events[HistoryBufferSize];
+	DWORD NumEvents = HistoryBufferSize;
+	if (Device->GetDeviceData(sizeof(DIDEVICEOBJECTDATA), Events, &NumEvents, 0) != DI_OK)
+	{
+		// Not buffered, or events were lost and replaying the rest would leave the history wrong
+		return false;
+	}
+
+	// Event times are GetTickCount milliseconds, moved onto the clock of the samples
+	const double Now = FPlatformTime::Seconds();
+	const DWORD NowTicks = GetTickCount();
+
+	// Replayed on top of the state after the previous event, a sample for each group of simultaneous events
+	FInputSample& Sample = Info->HistoryState;
+	for (DWORD Index = 0; Index < NumEvents; Index++)
+	{
+		const DIDEVICEOBJECTDATA& Event = Events[Index];
+		if (Event.dwOfs < PovOffset)
+		{
+			Sample.Axes[Event.dwOfs / sizeof(LONG)] = static_cast<LONG>(Event.dwData);
+		}
+		else if (Event.dwOfs < ButtonOffset)
+		{
+			Sample.Povs[(Event.dwOfs - PovOffset) / sizeof(DWORD)] = Event.dwData;
+		}
+		else
+		{
+			const uint32 Button = Event.dwOfs - ButtonOffset;
+			if (Event.dwData & 0x80)
+			{
+				Sample.Buttons[Button / 32] |= 1u << (Button % 32);
+			}
+			else
+			{
+				Sample.Buttons[Button / 32] &= ~(1u << (Button % 32));
+			}
+		}
+
+		if (Index + 1 == NumEvents || Events[Index + 1].dwSequence != Event.dwSequence)
+		{
+			Sample.Time = Now - static_cast<DWORD>(NowTicks - Event.dwTimeStamp) / 1000.0;
+			History->Push(Sample);
+		}
+	}
+
+	return true;
+}
+
+void FJoystick::ApplyCalibration(const FCalibrationProfile& Profile)
+{
+	for (uint32 Axis = 0; Axis < FMath::Min(NumAxes, Profile.NumAxes); Axis++)
+	{
+		Info->AxisCalibrations[Axis] = Profile.Axes[Axis];
+	}
+
+	UpdateNormalizer();
+}
+
+void FJoystick::SetNormalizer(FAxisNormalizer* InNormalizer, const float InDeadZone)
+{
+	Normalizer = InNormalizer;
+	NormalizerLane = Normalizer != nullptr ? Normalizer->AddDevice() : 0;
+	Info->DeadZone = InDeadZone;
+	UpdateNormalizer();
+}
+
+void FJoystick::UpdateNormalizer()
+{
+	if (Normalizer != nullptr)
+	{
+		for (uint32 Axis = 0; Axis < NumAxes; Axis++)
+		{
+			Normalizer->SetAxis(NormalizerLane + Axis, Info->AxisCalibrations[Axis], Info->DeadZone);
+		}
+	}
+}
+
+void FJoystick::ApplyRemap(const FRemapProfile* Profile)
+{
+	static_assert(FRemapTable::MaxAxes == MaxAxes && FRemapTable::MaxButtons == MaxButtons, "Remap table must cover every object");
+	Info->Remap.Compile(Profile, *Info->Keys, Info->Objects.GetData(), NumAxes, NumButtons);
+}
+
+void FJoystick::SetFilters(const FAxisFilterProfile* Profile)
+{
+	static_assert(FAxisFilterBank::NumAxes == MaxAxes, "Filters must cover every axis");
+
+	if (Profile != nullptr)
+	{
+		Filter = MakeUnique<FAxisFilterBank>(*Profile);
+		Info->LastFilterTime = 0.0;
+	}
+	else
+	{
+		Filter.Reset();
+	}
+}
+
+void FJoystick::FilterAxes()
+{
+	const double Now = FPlatformTime::Seconds();
+	const float DeltaTime = Info->LastFilterTime > 0.0 ? static_cast<float>(Now - Info->LastFilterTime) : 0.0f;
+	Info->LastFilterTime = Now;
+
+	float Raw[MaxAxes];
+	const LONG* Axes = reinterpret_cast<const LONG*>(GetCurrentState());
+	for (uint32 Axis = 0; Axis < MaxAxes; Axis++)
+	{
+		Raw[Axis] = Axis < NumAxes ? static_cast<float>(Axes[Axis]) : 0.0f;
+	}
+
+	Filter->Apply(Raw, Info->FilteredAxes[StateIndex], DeltaTime);
+}
+
+float FJoystick::GetCombinedAxisValue(const uint32 Axis) const
+{
+	float Value = Info->Remap.CombineCenter[Axis];
+	for (uint32 Source = Axis; Source < NumAxes; Source++)
+	{
+		const FRemapTable::FAxis& Entry = Info->Remap.Axes[Source];
+		if (Entry.Combine == static_cast<int32>(Axis))
+		{
+			Value += Entry.Offset + Entry.Scale * GetCalibratedAxisValue(Source);
+		}
+	}
+	return Value;
+}
+
+FCalibrationProfile FJoystick::GetCalibration() const
+{
+	FCalibrationProfile Profile;
+	ZeroMemory(&Profile, sizeof(FCalibrationProfile));
+	Profile.NumAxes = NumAxes;
+	CopyMemory(Profile.Axes, Info->AxisCalibrations, NumAxes * sizeof(FAxisCalibration));
+	return Profile;
+}
+
+void FJoystick::StartCalibration()
+{
+	for (uint32 Axis = 0; Axis < NumAxes; Axis++)
+	{
+		Info->ObservedMin[Axis] = MAX_int32;
+		Info->ObservedMax[Axis] = MIN_int32;
+		Info->RestPosition[Axis] = GetAxisValue(Axis);
+	}
+
+	bCalibrating = true;
+}
+
+FCalibrationProfile FJoystick::StopCalibration()
+{
+	bCalibrating = false;
+
+	// Axes that never moved keep their previous calibration
+	for (uint32 Axis = 0; Axis < NumAxes; Axis++)
+	{
+		if (Info->ObservedMax[Axis] > Info->ObservedMin[Axis])
+		{
+			FAxisCalibration& Calibration = Info->AxisCalibrations[Axis];
+			Calibration.Min = Info->ObservedMin[Axis];
+			Calibration.Center = FMath::Clamp(Info->RestPosition[Axis], Info->ObservedMin[Axis], Info->ObservedMax[Axis]);
+			Calibration.Max = Info->ObservedMax[Axis];
+		}
+	}
+
+	UpdateNormalizer();
+	return GetCalibration();
+}
+
+void FJoystick::RecordExtents()
+{
+	for (uint32 Axis = 0; Axis < NumAxes; Axis++)
+	{
+		const int32 Value = GetAxisValue(Axis);
+		Info->ObservedMin[Axis] = FMath::Min(Info->ObservedMin[Axis], Value);
+		Info->ObservedMax[Axis] = FMath::Max(Info->ObservedMax[Axis], Value);
+	}
+}
+
+void FJoystick::SetTelemetry(FTelemetryPublisher* InTelemetry, const uint32 InSlot)
+{
+	Telemetry = InTelemetry;
+	Info->TelemetrySlot = InSlot;
+
+	if (Telemetry != nullptr)
+	{
+		Telemetry->SetDevice(Info->TelemetrySlot, ToFGuid(GetProductGui()), ToFGuid(GetInstanceGuid()), GetInstanceName());
+	}
+}
+
+void FJoystick::PublishState()
+{
+	if (Snapshot == nullptr && Telemetry == nullptr)
+	{
+		return;
+	}
+
+	FDirectInputState State;
+	ZeroMemory(&State, sizeof(FDirectInputState));
+	State.Time = FPlatformTime::Seconds();
+	State.NumAxes = NumAxes;
+	State.NumButtons = NumButtons;
+	State.NumPovs = NumPovs;
+
+	const uint8* CurrentState = GetCurrentState();
+	for (uint32 Axis = 0; Axis < NumAxes; Axis++)
+	{
+		State.Axes[Axis] = GetNormalizedAxisValue(Axis);
+	}
+	CopyMemory(State.Povs, CurrentState + PovOffset, NumPovs * sizeof(DWORD));
+	for (uint32 Button = 0; Button < NumButtons; Button++)
+	{
+		if (CurrentState[ButtonOffset + Button] & 0x80)
+		{
+			State.Buttons[Button / 32] |= 1u << (Button % 32);
+		}
+	}
+
+	if (Snapshot != nullptr)
+	{
+		Snapshot->Publish(State);
+	}
+
+	if (Telemetry != nullptr)
+	{
+		Telemetry->Publish(Info->TelemetrySlot, State);
+	}
+}
+
+int32 FJoystick::GetAxisValue(const uint32 Axis) const
+{
+	if (Axis < GetNumAxes())
+		return reinterpret_cast<const LONG*>(GetCurrentState())[Axis];
+
+	return 0;
+}
+
+float FJoystick::GetFilteredAxisValue(const uint32 Axis) const
+{
+	if (Axis < GetNumAxes())
+		return Filter.IsValid() ? Info->FilteredAxes[StateIndex][Axis] : static_cast<float>(GetAxisValue(Axis));
+
+	return 0.0f;
+}
+
+float FJoystick::GetNormalizedAxisValue(const uint32 Axis) const
+{
+	if (Axis < GetNumAxes())
+	{
+		if (Normalizer != nullptr)
+		{
+			return Normalizer->GetOutput(NormalizerLane)[Axis];
+		}
+
+		return Info->AxisCalibrations[Axis].Normalize(FMath::RoundToInt(GetFilteredAxisValue(Axis)));
+	}
+
+	return 0.0f;
+}
+
+float FJoystick::GetCalibratedAxisValue(const uint32 Axis) const
+{
+	if (Axis < GetNumAxes())
+	{
+		const FDeviceObject& Object = Info->Objects[Axis];
+		const float HalfRange = (static_cast<float>(Object.RangeMax) - static_cast<float>(Object.RangeMin)) * 0.5f;
+		return Object.RangeMin + HalfRange + GetNormalizedAxisValue(Axis) * HalfRange;
+	}
+
+	return 0.0f;
+}
+
+int32 FJoystick::GetButtonValue(const uint32 Button) const
+{
+	if (Button < GetNumButtons())
+		return (GetCurrentState()[ButtonOffset + Button] & 0x80) ? 1 : 0;
+
+	return 0;
+}
+
+int32 FJoystick::GetPovValue(const uint32 Pov) const
+{
+	if (Pov < GetNumPovs())
+		return static_cast<int>(reinterpret_cast<const DWORD*>(GetCurrentState() + PovOffset)[Pov]);
+
+	return 0;
+}
+
+uint32 FJoystick::GetPovDirection(const uint32 Pov) const
+{
+	if (Pov < GetNumPovs())
+		return DecodePov(reinterpret_cast<const DWORD*>(GetCurrentState() + PovOffset)[Pov]);
+
+	return PovCentered;
+}
+
+uint32 FJoystick::GetPreviousPovDirection(const uint32 Pov) const
+{
+	if (Pov < GetNumPovs())
+		return DecodePov(reinterpret_cast<const DWORD*>(GetPreviousState() + PovOffset)[Pov]);
+
+	return PovCentered;
+}
+
+bool FJoystick::IsStateChanged() const
+{
+	// Filtered axes keep moving towards the input after it stops changing
+	if (Filter.IsValid() && FMemory::Memcmp(Info->FilteredAxes[0], Info->FilteredAxes[1], NumAxes * sizeof(float)) != 0)
+		return true;
+
+	return FMemory::Memcmp(GetCurrentState(), GetPreviousState(), DataSize) != 0;
+}
+
+bool FJoystick::IsAxisChanged(const uint32 Axis) const
+{
+	if (Axis < GetNumAxes() && Filter.IsValid())
+		return Info->FilteredAxes[0][Axis] != Info->FilteredAxes[1][Axis];
+
+	if (Axis < GetNumAxes())
+		return reinterpret_cast<const LONG*>(GetCurrentState())[Axis] != reinterpret_cast<const LONG*>(GetPreviousState())[Axis];
+
+	return false;
+}
+
+bool FJoystick::IsButtonChanged(const uint32 Button) const
+{
+	if (Button < GetNumButtons())
+		return GetCurrentState()[ButtonOffset + Button] != GetPreviousState()[ButtonOffset + Button];
+
+	return false;
+}
+
+bool FJoystick::IsPovChanged(const uint32 Pov) const
+{
+	if (Pov < GetNumPovs())
+		return reinterpret_cast<const DWORD*>(GetCurrentState() + PovOffset)[Pov] != reinterpret_cast<const DWORD*>(GetPreviousState() + PovOffset)[Pov];
+
+	return false;
+}
+
+FString FJoystick::GetAxisName(const uint32 Axis) const
+{
+	if (Axis >= GetNumAxes())
+		return "";
+
+	return Info->Objects[Axis].Name;
+}
+
+uint32 FJoystick::GetAxisMaxForce(const uint32 Axis) const
+{
+	if (Axis >= GetNumAxes())
+		return 0;
+
+	return Info->Objects[Axis].MaxForce;
+}
+
+uint32 FJoystick::GetAxisForceResolution(const uint32 Axis) const
+{
+	if (Axis >= GetNumAxes())
+		return 0;
+
+	return Info->Objects[Axis].ForceResolution;
+}
+
+bool FJoystick::IsForceActuator(uint32 Axis) const
+{
+	if (Axis >= GetNumAxes())
+		return false;
+
+	return (Info->Objects[Axis].Flags & DIDOI_FFACTUATOR) != 0;
+}
+
+bool FJoystick::CreateEffect(uint32 Axis)
+{
+	if (Axis >= GetNumAxes() || Info->Objects[Axis].Type == 0)
+	{
+		UE_LOG(LogJoystick, Warning, TEXT("Force feedback axis %d does not exist on %s"), Axis, *GetInstanceName());
+		return false;
+	}
+
+	// Axes are at the start of the data format, so the object offset follows from the index
+	DWORD dwAxis = Axis * sizeof(LONG);
+
+	DICONSTANTFORCE diConstantForce;
+	diConstantForce.lMagnitude = 0;
+
+	LONG direction = 0;
+
+	ZeroMemory(&Info->EffectConfig, sizeof(DIEFFECT));
+	Info->EffectConfig.dwSize = sizeof(DIEFFECT); 
+	Info->EffectConfig.dwFlags = DIEFF_CARTESIAN | DIEFF_OBJECTOFFSETS;
+	Info->EffectConfig.dwDuration = INFINITE;
+	Info->EffectConfig.dwSamplePeriod = 0;
+	Info->EffectConfig.dwGain = DI_FFNOMINALMAX;
+	Info->EffectConfig.dwTriggerButton = DIEB_NOTRIGGER;
+	Info->EffectConfig.dwTriggerRepeatInterval = 0;
+	Info->EffectConfig.cAxes = 1;
+	Info->EffectConfig.rgdwAxes = &dwAxis;
+	Info->EffectConfig.rglDirection = &direction;
+	Info->EffectConfig.lpEnvelope = nullptr;
+	Info->EffectConfig.cbTypeSpecificParams = sizeof(DICONSTANTFORCE);
+	Info->EffectConfig.lpvTypeSpecificParams = &diConstantForce;  
+
+	switch (Device->CreateEffect(GUID_ConstantForce, &Info->EffectConfig, &Info->Effect, nullptr))
+	{
+	case DIERR_DEVICEFULL:
+		UE_LOG(LogJoystick, Error, TEXT("CreateEffect: Device full : %s"), *GetInstanceGuidAsString());
+		return false;
+	case DIERR_DEVICENOTREG:
+		UE_LOG(LogJoystick, Error, TEXT("CreateEffect: Device not registered : %s"), *GetInstanceGuidAsString());
+		return false;
+	case DIERR_INVALIDPARAM:
+		UE_LOG(LogJoystick, Error, TEXT("CreateEffect: Invalid parameter"));
+		return false;
+	case DIERR_NOTINITIALIZED:
+		UE_LOG(LogJoystick, Error, TEXT("CreateEffect: Not initialized"));
+		return false;
+	default:
+		break;
+	}
+
+	switch (Info->Effect->Start(INFINITE, 0))
+	{
+	case DIERR_INCOMPLETEEFFECT:
+		UE_LOG(LogJoystick, Error, TEXT("Start: Incomplete effect"));
+		return false;
+	case DIERR_INVALIDPARAM:
+		UE_LOG(LogJoystick, Error, TEXT("Start: Invalid parameter"));
+		return false;
+	case DIERR_NOTEXCLUSIVEACQUIRED:
+		UE_LOG(LogJoystick, Error, TEXT("Start: Not exclusive acquired"));
+		return false;
+	case DIERR_NOTINITIALIZED:
+		UE_LOG(LogJoystick, Error, TEXT("Start: Not initialized"));
+		return false;
+	case DIERR_UNSUPPORTED:
+		UE_LOG(LogJoystick, Error, TEXT("Start: Unsupported"));
+		return false;
+	default:
+		return true;
+	}
+}
+
+bool FJoystick::UpdateEffect(const int Magnitude)
+{
+	FScopeLock Lock(&Info->DeviceLock);
+
+	SCOPE_CYCLE_COUNTER(STAT_DirectInput_UpdateEffect);
+
+	if (Info->Effect == nullptr)
+	{
+		return false;
+	}
+
+	// Also called from the force feedback thread at a high rate, an unplugged device only logs through Poll
+	DICONSTANTFORCE diConstantForce;
+	diConstantForce.lMagnitude = Magnitude;
+
+	Info->EffectConfig.cbTypeSpecificParams = sizeof(DICONSTANTFORCE);
+	Info->EffectConfig.lpvTypeSpecificParams = &diConstantForce;
+
+	switch (Info->Effect->SetParameters(&Info->EffectConfig, DIEP_TYPESPECIFICPARAMS | DIEP_START))
+	{
+	case DIERR_NOTINITIALIZED:
+		UE_CLOG(!bInputLost, LogJoystick, Error, TEXT("SetParameters: Not initialized"));
+		return false;
+	case DIERR_INCOMPLETEEFFECT:
+		UE_CLOG(!bInputLost, LogJoystick, Error, TEXT("SetParameters: Incomplete effect"));
+		return false;
+	case DIERR_INPUTLOST:
+		UE_CLOG(!bInputLost, LogJoystick, Error, TEXT("SetParameters: Input lost"));
+		return false;
+	case DIERR_INVALIDPARAM:
+		UE_CLOG(!bInputLost, LogJoystick, Error, TEXT("SetParameters: Invalid parameter"));
+		return false;
+	case DIERR_EFFECTPLAYING:
+		UE_CLOG(!bInputLost, LogJoystick, Error, TEXT("SetParameters: Effect playing"));
+		return false;
+	default:
+		return true;
+	}
+}
+
+bool FJoystick::StopEffect() const
+{
+	switch (Info->Effect->Stop())
+	{
+	case DIERR_NOTEXCLUSIVEACQUIRED:
+		UE_LOG(LogJoystick, Error, TEXT("Stop: Not exclusive acquired"));
+		return false;
+	case DIERR_NOTINITIALIZED:
+		UE_LOG(LogJoystick, Error, TEXT("Stop: Not initialized"));
+		return false;
+	default:
+		return true;
+	}
+}
+
+static const GUID* const ConditionGuids[] = { &GUID_Spring, &GUID_Damper, &GUID_Friction, &GUID_Inertia };
+static_assert(UE_ARRAY_COUNT(ConditionGuids) == static_cast<uint32>(EForceCondition::Count), "Every condition needs an effect");
+
+void FJoystick::GetConditionSupport()
+{
+	Info->HardwareConditions = 0;
+	if ((Info->Capabilities.dwFlags & DIDC_FORCEFEEDBACK) == 0)
+	{
+		return;
+	}
+
+	for (uint32 Condition = 0; Condition < UE_ARRAY_COUNT(ConditionGuids); Condition++)
+	{
+		DIEFFECTINFO EffectInfo;
+		EffectInfo.dwSize = sizeof(DIEFFECTINFO);
+		if (Device->GetEffectInfo(&EffectInfo, *ConditionGuids[Condition]) == DI_OK && DIEFT_GETTYPE(EffectInfo.dwEffType) == DIEFT_CONDITION)
+		{
+			Info->HardwareConditions |= 1u << Condition;
+		}
+	}
+}
+
+void FJoystick::SetConditions(const FForceConditions& InConditions)
+{
+	FScopeLock Lock(&Info->DeviceLock);
+
+	Info->ConditionSettings = InConditions;
+
+	const float Coefficients[] = { Info->ConditionSettings.Spring, Info->ConditionSettings.Damper, Info->ConditionSettings.Friction, Info->ConditionSettings.Inertia };
+	for (uint32 Condition = 0; Condition < UE_ARRAY_COUNT(Coefficients); Condition++)
+	{
+		// A condition the device claims but then fails to play falls back to software
+		if ((Info->HardwareConditions & (1u << Condition)) && !UpdateConditionEffect(static_cast<EForceCondition>(Condition), Coefficients[Condition]))
+		{
+			UE_LOG(LogJoystick, Warning, TEXT("%s can't play condition %d, synthesising it instead"), *GetInstanceName(), Condition);
+			Info->HardwareConditions &= ~(1u << Condition);
+		}
+	}
+
+	Info->Conditions.SetConditions(Info->ConditionSettings, Info->HardwareConditions);
+	bSoftwareConditions = Info->Conditions.IsActive();
+}
+
+bool FJoystick::UpdateConditionEffect(const EForceCondition Condition, const float Coefficient)
+{
+	LPDIRECTINPUTEFFECT& ConditionEffect = Info->ConditionEffects[static_cast<uint32>(Condition)];
+	if (ConditionEffect == nullptr && Coefficient == 0.0f)
+	{
+		return true;
+	}
+
+	// Coefficients and offsets are in -10000..10000 of full force and full deflection, like the settings in -1..1
+	DICONDITION Parameters;
+	Parameters.lOffset = Condition == EForceCondition::Spring ? FMath::RoundToInt(FMath::Clamp(Info->ConditionSettings.Center, -1.0f, 1.0f) * DI_FFNOMINALMAX) : 0;
+	Parameters.lPositiveCoefficient = FMath::RoundToInt(FMath::Clamp(Coefficient, -1.0f, 1.0f) * DI_FFNOMINALMAX);
+	Parameters.lNegativeCoefficient = Parameters.lPositiveCoefficient;
+	Parameters.dwPositiveSaturation = FMath::RoundToInt(FMath::Clamp(Info->ConditionSettings.Saturation, 0.0f, 1.0f) * DI_FFNOMINALMAX);
+	Parameters.dwNegativeSaturation = Parameters.dwPositiveSaturation;
+	Parameters.lDeadBand = 0;
+
+	DWORD dwAxis = 0;
+	LONG direction = 0;
+
+	DIEFFECT Config;
+	ZeroMemory(&Config, sizeof(DIEFFECT));
+	Config.dwSize = sizeof(DIEFFECT);
+	Config.dwFlags = DIEFF_CARTESIAN | DIEFF_OBJECTOFFSETS;
+	Config.dwDuration = INFINITE;
+	Config.dwGain = DI_FFNOMINALMAX;
+	Config.dwTriggerButton = DIEB_NOTRIGGER;
+	Config.cAxes = 1;
+	Config.rgdwAxes = &dwAxis;
+	Config.rglDirection = &direction;
+	Config.cbTypeSpecificParams = sizeof(DICONDITION);
+	Config.lpvTypeSpecificParams = &Parameters;
+
+	if (ConditionEffect == nullptr)
+	{
+		if (FAILED(Device->CreateEffect(*ConditionGuids[static_cast<uint32>(Condition)], &Config, &ConditionEffect, nullptr)))
+		{
+			ConditionEffect = nullptr;
+			return false;
+		}
+		return SUCCEEDED(ConditionEffect->Start(INFINITE, 0));
+	}
+
+	return SUCCEEDED(ConditionEffect->SetParameters(&Config, DIEP_TYPESPECIFICPARAMS | DIEP_START));
+}
+
+static void ReleaseStreamEffects(LPDIRECTINPUTEFFECT (&StreamEffects)[2])
+{
+	for (LPDIRECTINPUTEFFECT& StreamEffect : StreamEffects)
+	{
+		if (StreamEffect != nullptr)
+		{
+			StreamEffect->Release();
+			StreamEffect = nullptr;
+		}
+	}
+}
+
+FForceStream* FJoystick::EnableForceStream(const uint32 SampleRate)
+{
+	FScopeLock Lock(&Info->DeviceLock);
+
+	if (Stream.IsValid())
+	{
+		return Stream->GetSampleRate() == SampleRate ? Stream.Get() : nullptr;
+	}
+
+	if ((Info->Capabilities.dwFlags & DIDC_FORCEFEEDBACK) == 0 || NumAxes == 0)
+	{
+		return nullptr;
+	}
+
+	TUniquePtr<FForceStream> NewStream = MakeUnique<FForceStream>(SampleRate, 0.5f);
+
+	DWORD dwAxis = 0;
+	LONG direction = 0;
+	LONG Silence = 0;
+
+	DICUSTOMFORCE CustomForce;
+	CustomForce.cChannels = 1;
+	CustomForce.dwSamplePeriod = NewStream->GetSamplePeriod();
+	CustomForce.cSamples = 1;
+	CustomForce.rglForceData = &Silence;
+
+	DIEFFECT Config;
+	ZeroMemory(&Config, sizeof(DIEFFECT));
+	Config.dwSize = sizeof(DIEFFECT);
+	Config.dwFlags = DIEFF_CARTESIAN | DIEFF_OBJECTOFFSETS;
+	Config.dwDuration = INFINITE;
+	Config.dwSamplePeriod = NewStream->GetSamplePeriod();
+	Config.dwGain = DI_FFNOMINALMAX;
+	Config.dwTriggerButton = DIEB_NOTRIGGER;
+	Config.cAxes = 1;
+	Config.rgdwAxes = &dwAxis;
+	Config.rglDirection = &direction;
+	Config.cbTypeSpecificParams = sizeof(DICUSTOMFORCE);
+	Config.lpvTypeSpecificParams = &CustomForce;
+
+	// Both effects are created up front so a device that can only take one isn't found out mid-stream
+	Info->bStreamPeriodic = FAILED(Device->CreateEffect(GUID_CustomForce, &Config, &Info->StreamEffects[0], nullptr)) || FAILED(Device->CreateEffect(GUID_CustomForce, &Config, &Info->StreamEffects[1], nullptr));
+	if (Info->bStreamPeriodic)
+	{
+		ReleaseStreamEffects(Info->StreamEffects);
+
+		// Custom forces are optional and many drivers reject them, a sine is the nearest thing they all play
+		DIPERIODIC Periodic;
+		ZeroMemory(&Periodic, sizeof(DIPERIODIC));
+		Periodic.dwPeriod = NewStream->GetSamplePeriod() * 2;
+
+		Config.dwSamplePeriod = 0;
+		Config.cbTypeSpecificParams = sizeof(DIPERIODIC);
+		Config.lpvTypeSpecificParams = &Periodic;
+
+		if (FAILED(Device->CreateEffect(GUID_Sine, &Config, &Info->StreamEffects[0], nullptr)) || FAILED(Device->CreateEffect(GUID_Sine, &Config, &Info->StreamEffects[1], nullptr)))
+		{
+			UE_LOG(LogJoystick, Warning, TEXT("%s can't play a custom force or a sine, not streaming"), *GetInstanceName());
+			ReleaseStreamEffects(Info->StreamEffects);
+			return nullptr;
+		}
+
+		UE_LOG(LogJoystick, Display, TEXT("%s doesn't support custom forces, streaming as a sine"), *GetInstanceName());
+	}
+
+	// Nothing plays until the first block is queued
+	Info->StreamEnd = 0.0;
+	Info->LastStreamUpdate = 0.0;
+	Stream = MoveTemp(NewStream);
+	return Stream.Get();
+}
+
+bool FJoystick::UpdateForceStream()
+{
+	FScopeLock Lock(&Info->DeviceLock);
+
+	if (!Stream.IsValid())
+	{
+		return false;
+	}
+
+	// One block is queued ahead on the device. DIEP_START restarts an effect, so uploading every frame would cut the
+	// playing block short, and a block longer than the frame would loop. The next block goes up once the queued one
+	// ends within two update intervals, and waits on the device for it to end.
+	const double Now = FPlatformTime::Seconds();
+	const double Interval = Info->LastStreamUpdate > 0.0 ? Now - Info->LastStreamUpdate : 0.0;
+	Info->LastStreamUpdate = Now;
+	if (Info->StreamEnd - Now > 2.0 * Interval || !Stream->Fill())
+	{
+		return false;
+	}
+
+	// A stream that ran dry starts again now
+	const double StartDelay = FMath::Max(Info->StreamEnd - Now, 0.0);
+	Info->StreamEnd = Now + StartDelay + Stream->GetBlockDuration() / 1.0e6;
+
+	DIEFFECT Config;
+	ZeroMemory(&Config, sizeof(DIEFFECT));
+	Config.dwSize = sizeof(DIEFFECT);
+	Config.dwFlags = DIEFF_CARTESIAN | DIEFF_OBJECTOFFSETS;
+	Config.dwDuration = Stream->GetBlockDuration();
+	Config.dwStartDelay = static_cast<DWORD>(StartDelay * 1.0e6);
+
+	const DWORD Flags = DIEP_TYPESPECIFICPARAMS | DIEP_DURATION | DIEP_STARTDELAY | DIEP_START;
+	LPDIRECTINPUTEFFECT StreamEffect = Info->StreamEffects[Stream->GetBlockIndex()];
+
+	if (Info->bStreamPeriodic)
+	{
+		DIPERIODIC Periodic;
+		Stream->GetPeriodic(Periodic.dwMagnitude, Periodic.lOffset, Periodic.dwPeriod);
+		Periodic.dwPhase = 0;
+
+		Config.cbTypeSpecificParams = sizeof(DIPERIODIC);
+		Config.lpvTypeSpecificParams = &Periodic;
+		return SUCCEEDED(StreamEffect->SetParameters(&Config, Flags));
+	}
+
+	// Drivers may read the samples after SetParameters returns, the next Fill writes the other block
+	static_assert(sizeof(LONG) == sizeof(int32), "Force samples are uploaded in place");
+	DICUSTOMFORCE CustomForce;
+	CustomForce.cChannels = 1;
+	CustomForce.dwSamplePeriod = Stream->GetSamplePeriod();
+	CustomForce.cSamples = Stream->GetBlockSize();
+	CustomForce.rglForceData = reinterpret_cast<LONG*>(const_cast<int32*>(Stream->GetBlock()));
+
+	Config.cbTypeSpecificParams = sizeof(DICUSTOMFORCE);
+	Config.lpvTypeSpecificParams = &CustomForce;
+	return SUCCEEDED(StreamEffect->SetParameters(&Config, Flags));
+}
+
+bool FJoystick::LoadForceEffect(const FGuid& Id, const TArray<FForceEffectData>& Effects)
+{
+	FScopeLock Lock(&Info->DeviceLock);
+
+	if (Info->EffectCache.Contains(Id))
+	{
+		return true;
+	}
+
+	// Created into a list of their own, evicting removes other entries while they are
+	TArray<LPDIRECTINPUTEFFECT> Handles;
+	if ((Info->Capabilities.dwFlags & DIDC_FORCEFEEDBACK) != 0)
+	{
+		// The axes the device has, only the actuators if it marks any as such
+		uint32 AxisMask = 0;
+		uint32 ActuatorMask = 0;
+		for (uint32 Axis = 0; Axis < NumAxes; Axis++)
+		{
+			if (Info->Objects[Axis].Type != 0)
+			{
+				AxisMask |= 1u << Axis;
+				ActuatorMask |= IsForceActuator(Axis) ? 1u << Axis : 0;
+			}
+		}
+		if (ActuatorMask != 0)
+		{
+			AxisMask = ActuatorMask;
+		}
+
+		for (const FForceEffectData& Data : Effects)
+		{
+			const FForceEffectConfig Config(Data, AxisMask);
+			if (Config.GetNumSkippedAxes() > 0)
+			{
+				UE_LOG(LogJoystick, Warning, TEXT("%s has no force feedback axis for %d of the axes of effect %s, playing it without them"), *GetInstanceName(), Config.GetNumSkippedAxes(), *Data.Name);
+			}
+
+			// Downloaded now so starting it doesn't have to
+			LPDIRECTINPUTEFFECT Handle = nullptr;
+			HRESULT Result = Device->CreateEffect(Config.GetType(), Config.GetEffect(), &Handle, nullptr);
+			while (Result == DIERR_DEVICEFULL && EvictForceEffect(Id))
+			{
+				Result = Device->CreateEffect(Config.GetType(), Config.GetEffect(), &Handle, nullptr);
+			}
+
+			if (FAILED(Result))
+			{
+				UE_LOG(LogJoystick, Warning, TEXT("%s can't play effect %s%s"), *GetInstanceName(), *Data.Name, Result == DIERR_DEVICEFULL ? TEXT(", the device is full") : TEXT(""));
+				continue;
+			}
+
+			Handles.Add(Handle);
+		}
+	}
+
+	FInfo::FCachedEffect& Entry = Info->EffectCache.Add(Id);
+	Entry.Handles = MoveTemp(Handles);
+	Entry.LastUsed = ++Info->EffectClock;
+	return Entry.Handles.Num() > 0;
+}
+
+void FJoystick::UnloadForceEffect(const FGuid& Id)
+{
+	FScopeLock Lock(&Info->DeviceLock);
+
+	FInfo::FCachedEffect Entry;
+	if (Info->EffectCache.RemoveAndCopyValue(Id, Entry))
+	{
+		for (LPDIRECTINPUTEFFECT Handle : Entry.Handles)
+		{
+			// Releasing an effect unloads it from the device, stopping it first if it plays
+			Handle->Release();
+		}
+	}
+}
+
+bool FJoystick::EvictForceEffect(const FGuid& Keep)
+{
+	const FGuid* Oldest = nullptr;
+	uint64 OldestUsed = MAX_uint64;
+	for (const TPair<FGuid, FInfo::FCachedEffect>& Entry : Info->EffectCache)
+	{
+		if (Entry.Key == Keep || Entry.Value.Handles.Num() == 0 || Entry.Value.LastUsed >= OldestUsed)
+		{
+			continue;
+		}
+
+		// A playing effect is heard, it stays even if it was started long ago
+		bool bPlaying = false;
+		for (LPDIRECTINPUTEFFECT Handle : Entry.Value.Handles)
+		{
+			DWORD Status = 0;
+			bPlaying |= SUCCEEDED(Handle->GetEffectStatus(&Status)) && (Status & DIEGES_PLAYING) != 0;
+		}
+
+		if (!bPlaying)
+		{
+			Oldest = &Entry.Key;
+			OldestUsed = Entry.Value.LastUsed;
+		}
+	}
+
+	if (Oldest == nullptr)
+	{
+		return false;
+	}
+
+	UE_LOG(LogJoystick, Log, TEXT("%s is full, unloading effect %s"), *GetInstanceName(), *Oldest->ToString());
+	UnloadForceEffect(FGuid(*Oldest));
+	return true;
+}
+
+bool FJoystick::StartForceEffect(const FGuid& Id, const uint32 Iterations) const
+{
+	FScopeLock Lock(&Info->DeviceLock);
+
+	FInfo::FCachedEffect* Entry = Info->EffectCache.Find(Id);
+	if (Entry == nullptr)
+	{
+		return false;
+	}
+
+	Entry->LastUsed = ++Info->EffectClock;
+
+	bool bStarted = Entry->Handles.Num() > 0;
+	for (LPDIRECTINPUTEFFECT Handle : Entry->Handles)
+	{
+		bStarted &= SUCCEEDED(Handle->Start(Iterations > 0 ? Iterations : INFINITE, 0));
+	}
+	return bStarted;
+}
+
+bool FJoystick::StopForceEffect(const FGuid& Id) const
+{
+	FScopeLock Lock(&Info->DeviceLock);
+
+	const FInfo::FCachedEffect* Entry = Info->EffectCache.Find(Id);
+	if (Entry == nullptr)
+	{
+		return false;
+	}
+
+	for (LPDIRECTINPUTEFFECT Handle : Entry->Handles)
+	{
+		Handle->Stop();
+	}
+	return true;
+}
+
+float FJoystick::SynthesizeConditions(const double Time)
+{
+	// Conditions act on the force feedback axis, the first one
+	return NumAxes > 0 ? Info->Conditions.Update(GetNormalizedAxisValue(0), Time) : 0.0f;
+}
+
+bool FJoystick::SetConstantForce(const int Magnitude)
+{
+	FScopeLock Lock(&Info->DeviceLock);
+
+	Info->ConstantForce = Magnitude;
+	return UpdateEffect(Info->ConstantForce + FMath::RoundToInt(Info->Conditions.GetForce()));
+}
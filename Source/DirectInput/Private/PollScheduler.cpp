@@ -0,0 +1,165 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "PollScheduler.h"
+#include "Engine/Engine.h"
+#include "Engine/GameViewportClient.h"
+#include "Engine/World.h"
+#include "HAL/PlatformApplicationMisc.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogPollScheduler, Log, All);
+
+void FPollScheduler::LoadConfig()
+{
+	Intervals.Reset();
+
+	TArray<FString> Entries;
+	GConfig->GetArray(TEXT("DirectInput"), TEXT("PollPriority"), Entries, GInputIni);
+
+	for (const FString& Entry : Entries)
+	{
+		FString GuidField, PriorityField;
+		FGuid Product;
+		if (!Entry.Split(TEXT(","), &GuidField, &PriorityField) || !FGuid::Parse(GuidField.TrimStartAndEnd(), Product))
+		{
+			UE_LOG(LogPollScheduler, Warning, TEXT("Ignoring PollPriority=%s, expected <ProductGuid>,<Full|Half|Low|Frames>"), *Entry);
+			continue;
+		}
+
+		const FString Priority = PriorityField.TrimStartAndEnd();
+		uint32 Interval = 0;
+		if (Priority == TEXT("Full"))
+		{
+			Interval = 1;
+		}
+		else if (Priority == TEXT("Half"))
+		{
+			Interval = 2;
+		}
+		else if (Priority == TEXT("Low"))
+		{
+			Interval = 4;
+		}
+		else if (Priority.IsNumeric())
+		{
+			Interval = FMath::Max(FCString::Atoi(*Priority), 1);
+		}
+		else
+		{
+			UE_LOG(LogPollScheduler, Warning, TEXT("Ignoring unknown priority '%s' in PollPriority=%s"), *Priority, *Entry);
+			continue;
+		}
+
+		Intervals.Add(Product, Interval);
+	}
+
+	int32 ConfigValue = 0;
+	if (GConfig->GetInt(TEXT("DirectInput"), TEXT("PollIdleSamples"), ConfigValue, GInputIni))
+	{
+		IdleSamples = FMath::Max(ConfigValue, 0);
+	}
+	if (GConfig->GetInt(TEXT("DirectInput"), TEXT("PollMaxBackoff"), ConfigValue, GInputIni))
+	{
+		MaxBackoff = FMath::Max(ConfigValue, 1);
+	}
+	if (GConfig->GetInt(TEXT("DirectInput"), TEXT("PollThrottledInterval"), ConfigValue, GInputIni))
+	{
+		ThrottledInterval = FMath::Max(ConfigValue, 1);
+	}
+
+	ResetCounters();
+}
+
+uint32 FPollScheduler::GetInterval(const FGuid& Product) const
+{
+	const uint32* Interval = Intervals.Find(Product);
+	return Interval != nullptr ? *Interval : 1;
+}
+
+void FPollScheduler::BeginFrame()
+{
+	FrameThrottle = 1;
+	if (ThrottledInterval <= 1)
+	{
+		return;
+	}
+
+	const UGameViewportClient* Viewport = GEngine != nullptr ? GEngine->GameViewport : nullptr;
+	const UWorld* World = Viewport != nullptr ? Viewport->GetWorld() : nullptr;
+	if (!FPlatformApplicationMisc::IsThisApplicationForeground() || (World != nullptr && World->IsPaused()))
+	{
+		FrameThrottle = ThrottledInterval;
+	}
+}
+
+bool FPollScheduler::IsDue(FPollSchedule& Schedule) const
+{
+	const uint32 Interval = FMath::Max(Schedule.Interval * Schedule.Backoff, FrameThrottle);
+	if (++Schedule.FramesSinceRead < Interval)
+	{
+		return false;
+	}
+
+	Schedule.FramesSinceRead = 0;
+	return true;
+}
+
+void FPollScheduler::RecordRead(FPollSchedule& Schedule, const bool bChanged) const
+{
+	if (bChanged || IdleSamples == 0)
+	{
+		Schedule.IdleSamples = 0;
+		Schedule.Backoff = 1;
+		return;
+	}
+
+	// Doubles every time the device stays idle for as many reads again
+	if (++Schedule.IdleSamples >= IdleSamples)
+	{
+		Schedule.IdleSamples = 0;
+		Schedule.Backoff = FMath::Min(Schedule.Backoff * 2, FMath::Max(MaxBackoff / Schedule.Interval, 1u));
+	}
+}
+
+void FPollScheduler::RecordCalls(const uint32 Made, const uint32 Saved)
+{
+	NumCalls += Made;
+	NumSavedCalls += Saved;
+}
+
+double FPollScheduler::GetCallsPerSecond() const
+{
+	const double Elapsed = FPlatformTime::Seconds() - CounterStartTime;
+	return Elapsed > 0.0 ? NumCalls / Elapsed : 0.0;
+}
+
+double FPollScheduler::GetSavedCallsPerSecond() const
+{
+	const double Elapsed = FPlatformTime::Seconds() - CounterStartTime;
+	return Elapsed > 0.0 ? NumSavedCalls / Elapsed : 0.0;
+}
+
+void FPollScheduler::ResetCounters()
+{
+	NumCalls = 0;
+	NumSavedCalls = 0;
+	CounterStartTime = FPlatformTime::Seconds();
+}
@@ -0,0 +1,174 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "Remap.h"
+#include "Bindings.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogRemap, Log, All);
+
+void FRemapStore::LoadConfig()
+{
+	Profiles.Reset();
+
+	TArray<FString> Entries;
+	GConfig->GetArray(TEXT("DirectInput"), TEXT("AxisRemap"), Entries, GInputIni);
+
+	for (const FString& Entry : Entries)
+	{
+		TArray<FString> Fields;
+		Entry.ParseIntoArray(Fields, TEXT(","));
+
+		FGuid Product;
+		if (Fields.Num() < 3 || !FGuid::Parse(Fields[0].TrimStartAndEnd(), Product))
+		{
+			UE_LOG(LogRemap, Warning, TEXT("Ignoring AxisRemap=%s, expected <ProductGuid>,<SourceAxis>,<TargetKey>[,Invert][,Positive|Negative]"), *Entry);
+			continue;
+		}
+
+		FAxisRemapRule& Rule = Profiles.FindOrAdd(Product).Axes.AddDefaulted_GetRef();
+		Rule.Source = FCString::Atoi(*Fields[1]);
+		Rule.Target = FName(*Fields[2].TrimStartAndEnd());
+		Rule.bInvert = false;
+		Rule.Combine = ERemapCombine::None;
+
+		for (int32 Field = 3; Field < Fields.Num(); Field++)
+		{
+			const FString Option = Fields[Field].TrimStartAndEnd();
+			if (Option == TEXT("Invert"))
+			{
+				Rule.bInvert = true;
+			}
+			else if (Option == TEXT("Positive"))
+			{
+				Rule.Combine = ERemapCombine::Positive;
+			}
+			else if (Option == TEXT("Negative"))
+			{
+				Rule.Combine = ERemapCombine::Negative;
+			}
+			else
+			{
+				UE_LOG(LogRemap, Warning, TEXT("Ignoring unknown option '%s' in AxisRemap=%s"), *Option, *Entry);
+			}
+		}
+	}
+
+	Entries.Reset();
+	GConfig->GetArray(TEXT("DirectInput"), TEXT("ButtonRemap"), Entries, GInputIni);
+
+	for (const FString& Entry : Entries)
+	{
+		TArray<FString> Fields;
+		Entry.ParseIntoArray(Fields, TEXT(","));
+
+		FGuid Product;
+		if (Fields.Num() < 3 || !FGuid::Parse(Fields[0].TrimStartAndEnd(), Product))
+		{
+			UE_LOG(LogRemap, Warning, TEXT("Ignoring ButtonRemap=%s, expected <ProductGuid>,<SourceButton>,<TargetKey>[,Invert]"), *Entry);
+			continue;
+		}
+
+		FButtonRemapRule& Rule = Profiles.FindOrAdd(Product).Buttons.AddDefaulted_GetRef();
+		Rule.Source = FCString::Atoi(*Fields[1]);
+		Rule.Target = FName(*Fields[2].TrimStartAndEnd());
+		Rule.bInvert = Fields.Num() > 3 && Fields[3].TrimStartAndEnd() == TEXT("Invert");
+	}
+}
+
+void FRemapTable::Compile(const FRemapProfile* Profile, const FDirectInputKeySet& Keys, const FDeviceObject* AxisObjects, const uint32 NumAxes, const uint32 NumButtons)
+{
+	for (uint32 Axis = 0; Axis < MaxAxes; Axis++)
+	{
+		Axes[Axis] = { Axis < NumAxes ? Keys.Axes[Axis] : NAME_None, 1.0f, 0.0f, INDEX_NONE };
+		CombineCenter[Axis] = 0.0f;
+	}
+
+	for (uint32 Button = 0; Button < MaxButtons; Button++)
+	{
+		Buttons[Button] = { Button < NumButtons ? Keys.Buttons[Button] : NAME_None, false };
+	}
+
+	if (Profile == nullptr)
+	{
+		return;
+	}
+
+	for (const FAxisRemapRule& Rule : Profile->Axes)
+	{
+		if (Rule.Source >= NumAxes)
+		{
+			continue;
+		}
+
+		const float Min = AxisObjects[Rule.Source].RangeMin;
+		const float Max = AxisObjects[Rule.Source].RangeMax;
+
+		FAxis& Entry = Axes[Rule.Source];
+		Entry.Key = Rule.Target;
+		Entry.Scale = Rule.bInvert ? -1.0f : 1.0f;
+		Entry.Offset = Rule.bInvert ? Min + Max : 0.0f;
+		Entry.Combine = INDEX_NONE;
+
+		if (Rule.Combine == ERemapCombine::None)
+		{
+			continue;
+		}
+
+		// Each pedal covers half the range on its own side of the centre
+		const float Sign = Rule.Combine == ERemapCombine::Positive ? 0.5f : -0.5f;
+		Entry.Scale *= Sign;
+		Entry.Offset = (Entry.Offset - Min) * Sign;
+
+		Entry.Combine = Rule.Source;
+	}
+
+	// The first axis combined into a key carries the centre for all of them
+	for (uint32 Axis = 0; Axis < NumAxes; Axis++)
+	{
+		if (Axes[Axis].Combine == INDEX_NONE)
+		{
+			continue;
+		}
+
+		Axes[Axis].Combine = Axis;
+		for (uint32 First = 0; First < Axis; First++)
+		{
+			if (Axes[First].Combine != INDEX_NONE && Axes[First].Key == Axes[Axis].Key)
+			{
+				Axes[Axis].Combine = Axes[First].Combine;
+				break;
+			}
+		}
+
+		if (Axes[Axis].Combine == static_cast<int32>(Axis))
+		{
+			CombineCenter[Axis] = AxisObjects[Axis].RangeMin + (AxisObjects[Axis].RangeMax - AxisObjects[Axis].RangeMin) * 0.5f;
+		}
+	}
+
+	for (const FButtonRemapRule& Rule : Profile->Buttons)
+	{
+		if (Rule.Source < NumButtons)
+		{
+			Buttons[Rule.Source] = { Rule.Target, Rule.bInvert };
+		}
+	}
+}
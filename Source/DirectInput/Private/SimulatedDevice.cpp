@@ -0,0 +1,458 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "SimulatedDevice.h"
+#include "DirectInputDevice.h"
+
+extern FJoystickArray GInputDevices;
+extern FCriticalSection GInputDevicesLock;
+extern FAxisNormalizer GAxisNormalizer;
+
+// Every simulated device is the same product so they share one entry in the device cache
+static const GUID SimulatedProductGuid = { 0x5d1a7ed0, 0x0000, 0x0000, { 0x53, 0x49, 0x4d, 0x44, 0x45, 0x56, 0x00, 0x00 } };
+
+// Constant force effect that only counts how often it is updated
+class FSimulatedEffect : public IDirectInputEffect
+{
+public:
+	explicit FSimulatedEffect(FSimulatedDevice* InDevice) :
+		Device(InDevice),
+		RefCount(1)
+	{
+		Device->AddRef();
+	}
+
+	STDMETHOD(QueryInterface)(REFIID Riid, LPVOID* Object) override { *Object = nullptr; return E_NOINTERFACE; }
+	STDMETHOD_(ULONG, AddRef)() override { return ++RefCount; }
+	STDMETHOD_(ULONG, Release)() override
+	{
+		const ULONG Count = --RefCount;
+		if (Count == 0)
+		{
+			Device->Release();
+			delete this;
+		}
+		return Count;
+	}
+
+	STDMETHOD(Initialize)(HINSTANCE Instance, DWORD Version, REFGUID Guid) override { return DI_OK; }
+	STDMETHOD(GetEffectGuid)(LPGUID Guid) override { *Guid = GUID(); return DI_OK; }
+	STDMETHOD(GetParameters)(LPDIEFFECT Effect, DWORD Flags) override { return DIERR_UNSUPPORTED; }
+	STDMETHOD(SetParameters)(LPCDIEFFECT Effect, DWORD Flags) override
+	{
+		if (!Device->IsConnected())
+		{
+			return DIERR_INPUTLOST;
+		}
+
+		Device->AddEffectUpdate();
+		return DI_OK;
+	}
+	STDMETHOD(Start)(DWORD Iterations, DWORD Flags) override { return DI_OK; }
+	STDMETHOD(Stop)() override { return DI_OK; }
+	STDMETHOD(GetEffectStatus)(LPDWORD Status) override { *Status = DIEGES_PLAYING; return DI_OK; }
+	STDMETHOD(Download)() override { return DI_OK; }
+	STDMETHOD(Unload)() override { return DI_OK; }
+	STDMETHOD(Escape)(LPDIEFFESCAPE EffectEscape) override { return DIERR_UNSUPPORTED; }
+
+private:
+	virtual ~FSimulatedEffect() = default;
+
+	FSimulatedDevice* Device;
+	ULONG RefCount;
+};
+
+FSimulatedDevice::FSimulatedDevice(const uint32 InIndex, const uint32 InNumAxes, const uint32 InNumButtons, const uint32 InNumPovs) :
+	Index(InIndex),
+	NumAxes(FMath::Min(InNumAxes, FJoystick::MaxAxes)),
+	NumButtons(FMath::Min(InNumButtons, FJoystick::MaxButtons)),
+	NumPovs(FMath::Min(InNumPovs, FJoystick::MaxPovs)),
+	DataSize(0),
+	bConnected(true),
+	bAcquired(false),
+	AcquireFailures(0),
+	NumStateReads(0),
+	NumEffectUpdates(0),
+	RefCount(1)
+{
+	for (LONG& Axis : Axes)
+	{
+		Axis = 32767;
+	}
+	FMemory::Memzero(Buttons);
+	for (DWORD& Pov : Povs)
+	{
+		Pov = MAXDWORD;
+	}
+}
+
+void FSimulatedDevice::SetConnected(const bool bInConnected)
+{
+	bConnected = bInConnected;
+	if (!bConnected)
+	{
+		bAcquired = false;
+	}
+}
+
+STDMETHODIMP FSimulatedDevice::QueryInterface(REFIID Riid, LPVOID* Object)
+{
+	*Object = nullptr;
+	return E_NOINTERFACE;
+}
+
+STDMETHODIMP_(ULONG) FSimulatedDevice::AddRef()
+{
+	return ++RefCount;
+}
+
+STDMETHODIMP_(ULONG) FSimulatedDevice::Release()
+{
+	const ULONG Count = --RefCount;
+	if (Count == 0)
+	{
+		delete this;
+	}
+	return Count;
+}
+
+STDMETHODIMP FSimulatedDevice::GetCapabilities(LPDIDEVCAPS DevCaps)
+{
+	if (DevCaps == nullptr || DevCaps->dwSize != sizeof(DIDEVCAPS))
+	{
+		return DIERR_INVALIDPARAM;
+	}
+
+	DevCaps->dwFlags = (bConnected ? DIDC_ATTACHED : 0) | DIDC_POLLEDDEVICE | DIDC_FORCEFEEDBACK;
+	DevCaps->dwDevType = DI8DEVTYPE_DRIVING;
+	DevCaps->dwAxes = NumAxes;
+	DevCaps->dwButtons = NumButtons;
+	DevCaps->dwPOVs = NumPovs;
+	DevCaps->dwFFSamplePeriod = 1000;
+	DevCaps->dwFFMinTimeResolution = 1000;
+	DevCaps->dwFirmwareRevision = 1;
+	DevCaps->dwHardwareRevision = 1;
+	DevCaps->dwFFDriverVersion = 1;
+	return DI_OK;
+}
+
+STDMETHODIMP FSimulatedDevice::EnumObjects(LPDIENUMDEVICEOBJECTSCALLBACK Callback, LPVOID Ref, DWORD Flags)
+{
+	// Axes in the order of DIJOYSTATE, the rest are sliders
+	static const GUID* const AxisGuids[] = { &GUID_XAxis, &GUID_YAxis, &GUID_ZAxis, &GUID_RxAxis, &GUID_RyAxis, &GUID_RzAxis, &GUID_Slider };
+
+	const auto Enumerate = [Callback, Ref, Flags](const DWORD Type, const uint32 Count, const TCHAR* Name)
+	{
+		if (Flags != DIDFT_ALL && !(Flags & Type))
+		{
+			return true;
+		}
+
+		for (uint32 Instance = 0; Instance < Count; Instance++)
+		{
+			DIDEVICEOBJECTINSTANCE ObjectInstance;
+			ZeroMemory(&ObjectInstance, sizeof(DIDEVICEOBJECTINSTANCE));
+			ObjectInstance.dwSize = sizeof(DIDEVICEOBJECTINSTANCE);
+			ObjectInstance.guidType = Type == DIDFT_AXIS ? *AxisGuids[FMath::Min<uint32>(Instance, UE_ARRAY_COUNT(AxisGuids) - 1)] : GUID_Unknown;
+			ObjectInstance.dwType = (Type == DIDFT_AXIS ? DIDFT_ABSAXIS : Type == DIDFT_BUTTON ? DIDFT_PSHBUTTON : DIDFT_POV) | DIDFT_MAKEINSTANCE(Instance);
+			ObjectInstance.dwFlags = (Type == DIDFT_AXIS && Instance == 0) ? DIDOI_FFACTUATOR : 0;
+			ObjectInstance.dwFFMaxForce = (Type == DIDFT_AXIS && Instance == 0) ? 10 : 0;
+			ObjectInstance.dwFFForceResolution = (Type == DIDFT_AXIS && Instance == 0) ? 10000 : 0;
+			FCString::Snprintf(ObjectInstance.tszName, MAX_PATH, TEXT("%s %d"), Name, Instance);
+
+			if (Callback(&ObjectInstance, Ref) == DIENUM_STOP)
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	if (Enumerate(DIDFT_AXIS, NumAxes, TEXT("Axis")) && Enumerate(DIDFT_POV, NumPovs, TEXT("POV")))
+	{
+		Enumerate(DIDFT_BUTTON, NumButtons, TEXT("Button"));
+	}
+	return DI_OK;
+}
+
+STDMETHODIMP FSimulatedDevice::GetProperty(REFGUID Property, LPDIPROPHEADER Header)
+{
+	// Property GUIDs are small integers cast to pointers, so they compare by address
+	if (&Property == &DIPROP_RANGE && Header->dwSize == sizeof(DIPROPRANGE))
+	{
+		LPDIPROPRANGE Range = reinterpret_cast<LPDIPROPRANGE>(Header);
+		Range->lMin = 0;
+		Range->lMax = 65535;
+		return DI_OK;
+	}
+
+	return DIERR_UNSUPPORTED;
+}
+
+STDMETHODIMP FSimulatedDevice::SetProperty(REFGUID Property, LPCDIPROPHEADER Header)
+{
+	return DI_OK;
+}
+
+STDMETHODIMP FSimulatedDevice::Acquire()
+{
+	if (!bConnected)
+	{
+		return DIERR_UNPLUGGED;
+	}
+
+	if (AcquireFailures > 0)
+	{
+		AcquireFailures--;
+		return DIERR_OTHERAPPHASPRIO;
+	}
+
+	const bool bWasAcquired = bAcquired;
+	bAcquired = true;
+	return bWasAcquired ? S_FALSE : DI_OK;
+}
+
+STDMETHODIMP FSimulatedDevice::Unacquire()
+{
+	const bool bWasAcquired = bAcquired;
+	bAcquired = false;
+	return bWasAcquired ? DI_OK : DI_NOEFFECT;
+}
+
+STDMETHODIMP FSimulatedDevice::GetDeviceState(DWORD Size, LPVOID Data)
+{
+	if (!bConnected)
+	{
+		return DIERR_INPUTLOST;
+	}
+
+	if (!bAcquired)
+	{
+		return DIERR_NOTACQUIRED;
+	}
+
+	if (Size != DataSize || Data == nullptr)
+	{
+		return DIERR_INVALIDPARAM;
+	}
+
+	// Fill the state the way the data format set by FJoystick lays it out
+	uint8* State = static_cast<uint8*>(Data);
+	for (const DIOBJECTDATAFORMAT& Format : ObjectFormats)
+	{
+		const uint32 Instance = DIDFT_GETINSTANCE(Format.dwType);
+		if (Format.dwType & DIDFT_AXIS)
+		{
+			*reinterpret_cast<LONG*>(State + Format.dwOfs) = Instance < NumAxes ? Axes[Instance] : 0;
+		}
+		else if (Format.dwType & DIDFT_POV)
+		{
+			*reinterpret_cast<DWORD*>(State + Format.dwOfs) = Instance < NumPovs ? Povs[Instance] : MAXDWORD;
+		}
+		else if (Format.dwType & DIDFT_BUTTON)
+		{
+			State[Format.dwOfs] = Instance < NumButtons ? Buttons[Instance] : 0;
+		}
+	}
+
+	NumStateReads++;
+	return DI_OK;
+}
+
+STDMETHODIMP FSimulatedDevice::GetDeviceData(DWORD ObjectDataSize, LPDIDEVICEOBJECTDATA ObjectData, LPDWORD InOut, DWORD Flags)
+{
+	return DIERR_NOTBUFFERED;
+}
+
+STDMETHODIMP FSimulatedDevice::SetDataFormat(LPCDIDATAFORMAT Format)
+{
+	if (bAcquired)
+	{
+		return DIERR_ACQUIRED;
+	}
+
+	if (Format == nullptr || Format->dwObjSize != sizeof(DIOBJECTDATAFORMAT))
+	{
+		return DIERR_INVALIDPARAM;
+	}
+
+	ObjectFormats.Reset(Format->dwNumObjs);
+	ObjectFormats.Append(Format->rgodf, Format->dwNumObjs);
+	DataSize = Format->dwDataSize;
+	return DI_OK;
+}
+
+STDMETHODIMP FSimulatedDevice::SetEventNotification(HANDLE Event)
+{
+	return DI_OK;
+}
+
+STDMETHODIMP FSimulatedDevice::SetCooperativeLevel(HWND Window, DWORD Flags)
+{
+	return DI_OK;
+}
+
+STDMETHODIMP FSimulatedDevice::GetObjectInfo(LPDIDEVICEOBJECTINSTANCE ObjectInstance, DWORD Object, DWORD How)
+{
+	return DIERR_UNSUPPORTED;
+}
+
+STDMETHODIMP FSimulatedDevice::GetDeviceInfo(LPDIDEVICEINSTANCE DeviceInstance)
+{
+	if (DeviceInstance == nullptr || DeviceInstance->dwSize != sizeof(DIDEVICEINSTANCE))
+	{
+		return DIERR_INVALIDPARAM;
+	}
+
+	DeviceInstance->guidInstance = SimulatedProductGuid;
+	DeviceInstance->guidInstance.Data4[7] = static_cast<BYTE>(Index);
+	DeviceInstance->guidInstance.Data4[6] = static_cast<BYTE>(Index >> 8);
+	DeviceInstance->guidProduct = SimulatedProductGuid;
+	DeviceInstance->dwDevType = DI8DEVTYPE_DRIVING;
+	DeviceInstance->guidFFDriver = GUID();
+	FCString::Snprintf(DeviceInstance->tszInstanceName, MAX_PATH, TEXT("Simulated Device %d"), Index);
+	FCString::Snprintf(DeviceInstance->tszProductName, MAX_PATH, TEXT("Simulated Device"));
+	return DI_OK;
+}
+
+STDMETHODIMP FSimulatedDevice::RunControlPanel(HWND Owner, DWORD Flags)
+{
+	return DIERR_UNSUPPORTED;
+}
+
+STDMETHODIMP FSimulatedDevice::Initialize(HINSTANCE Instance, DWORD Version, REFGUID Guid)
+{
+	return DI_OK;
+}
+
+STDMETHODIMP FSimulatedDevice::CreateEffect(REFGUID Guid, LPCDIEFFECT Effect, LPDIRECTINPUTEFFECT* OutEffect, LPUNKNOWN Outer)
+{
+	*OutEffect = new FSimulatedEffect(this);
+	return DI_OK;
+}
+
+STDMETHODIMP FSimulatedDevice::EnumEffects(LPDIENUMEFFECTSCALLBACK Callback, LPVOID Ref, DWORD Type)
+{
+	return DI_OK;
+}
+
+STDMETHODIMP FSimulatedDevice::GetEffectInfo(LPDIEFFECTINFO EffectInfo, REFGUID Guid)
+{
+	return DIERR_DEVICENOTREG;
+}
+
+STDMETHODIMP FSimulatedDevice::GetForceFeedbackState(LPDWORD Out)
+{
+	*Out = DIGFFS_ACTUATORSON | DIGFFS_POWERON;
+	return DI_OK;
+}
+
+STDMETHODIMP FSimulatedDevice::SendForceFeedbackCommand(DWORD Flags)
+{
+	return DI_OK;
+}
+
+STDMETHODIMP FSimulatedDevice::EnumCreatedEffectObjects(LPDIENUMCREATEDEFFECTOBJECTSCALLBACK Callback, LPVOID Ref, DWORD Flags)
+{
+	return DI_OK;
+}
+
+STDMETHODIMP FSimulatedDevice::Escape(LPDIEFFESCAPE EffectEscape)
+{
+	return DIERR_UNSUPPORTED;
+}
+
+STDMETHODIMP FSimulatedDevice::Poll()
+{
+	if (!bConnected)
+	{
+		return DIERR_INPUTLOST;
+	}
+
+	return bAcquired ? DI_OK : DIERR_NOTACQUIRED;
+}
+
+STDMETHODIMP FSimulatedDevice::SendDeviceData(DWORD ObjectDataSize, LPCDIDEVICEOBJECTDATA ObjectData, LPDWORD InOut, DWORD Flags)
+{
+	return DIERR_UNSUPPORTED;
+}
+
+STDMETHODIMP FSimulatedDevice::EnumEffectsInFile(LPCTSTR FileName, LPDIENUMEFFECTSINFILECALLBACK Callback, LPVOID Ref, DWORD Flags)
+{
+	return DIERR_UNSUPPORTED;
+}
+
+STDMETHODIMP FSimulatedDevice::WriteEffectToFile(LPCTSTR FileName, DWORD Entries, LPDIFILEEFFECT Effects, DWORD Flags)
+{
+	return DIERR_UNSUPPORTED;
+}
+
+STDMETHODIMP FSimulatedDevice::BuildActionMap(LPDIACTIONFORMAT ActionFormat, LPCTSTR UserName, DWORD Flags)
+{
+	return DIERR_UNSUPPORTED;
+}
+
+STDMETHODIMP FSimulatedDevice::SetActionMap(LPDIACTIONFORMAT ActionFormat, LPCTSTR UserName, DWORD Flags)
+{
+	return DIERR_UNSUPPORTED;
+}
+
+STDMETHODIMP FSimulatedDevice::GetImageInfo(LPDIDEVICEIMAGEINFOHEADER ImageInfo)
+{
+	return DIERR_UNSUPPORTED;
+}
+
+FSimulatedDeviceScope::FSimulatedDeviceScope(FDirectInputDevice& InInputDevice, const TSharedRef<FGenericApplicationMessageHandler>& MessageHandler, const uint32 NumDevices, const uint32 NumAxes, const uint32 NumButtons, const uint32 NumPovs) :
+	InputDevice(InInputDevice),
+	SavedNormalizer(MoveTemp(GAxisNormalizer)),
+	SavedMessageHandler(InInputDevice.GetMessageHandler())
+{
+	FScopeLock Lock(&GInputDevicesLock);
+
+	SavedDevices = MoveTemp(GInputDevices);
+	GInputDevices.Reset();
+	GAxisNormalizer.Reset();
+	InputDevice.SetMessageHandler(MessageHandler);
+
+	for (uint32 Index = 0; Index < NumDevices; Index++)
+	{
+		FSimulatedDevice* Device = new FSimulatedDevice(Index, NumAxes, NumButtons, NumPovs);
+		Devices.Add(Device);
+
+		FJoystick& Joy = GInputDevices.Emplace_GetRef(Device, &Cache);
+		Joy.SetNormalizer(&GAxisNormalizer, InputDevice.GetDeadZone());
+	}
+}
+
+FSimulatedDeviceScope::~FSimulatedDeviceScope()
+{
+	FScopeLock Lock(&GInputDevicesLock);
+
+	// Releasing the joysticks releases the simulated devices
+	for (FJoystick& Joy : GInputDevices)
+	{
+		Joy.Release();
+	}
+
+	GInputDevices = MoveTemp(SavedDevices);
+	GAxisNormalizer = MoveTemp(SavedNormalizer);
+	InputDevice.SetMessageHandler(SavedMessageHandler);
+}
@@ -0,0 +1,337 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "SoakTest.h"
+#include "Bindings.h"
+#include "DirectInputDevice.h"
+#include "LatencyHistogram.h"
+#include "SimulatedDevice.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+extern FCriticalSection GInputDevicesLock;
+
+DEFINE_LOG_CATEGORY_STATIC(LogDirectInputSoak, Log, All);
+
+static constexpr uint32 SoakNumAxes = 6;
+static constexpr uint32 SoakNumButtons = 32;
+static constexpr uint32 SoakNumPovs = 1;
+
+// Keeps the button state as the dispatch reports it for every device, counting edges that arrive twice, and the
+// dispatch latency of each event, from the start of the poll pass to the event reaching the handler. It doesn't include
+// the time a change waits for the next poll, up to one period.
+class FEdgeTrackingMessageHandler : public FGenericApplicationMessageHandler
+{
+public:
+	explicit FEdgeTrackingMessageHandler(const uint32 NumDevices)
+	{
+		Pressed.SetNumZeroed(NumDevices * FDirectInputKeys::NumButtons);
+
+		for (uint32 Button = 0; Button < FDirectInputKeys::NumButtons; Button++)
+		{
+			ButtonIndices.Add(FDirectInputKeys::Shared.Buttons[Button], Button);
+		}
+	}
+
+	virtual bool OnControllerAnalog(FGamepadKeyNames::Type KeyName, int32 ControllerId, float AnalogValue) override
+	{
+		RecordEvent();
+		return false;
+	}
+
+	virtual bool OnControllerButtonPressed(FGamepadKeyNames::Type KeyName, int32 ControllerId, bool IsRepeat) override
+	{
+		RecordEvent();
+		RecordEdge(KeyName, ControllerId, true);
+		return false;
+	}
+
+	virtual bool OnControllerButtonReleased(FGamepadKeyNames::Type KeyName, int32 ControllerId, bool IsRepeat) override
+	{
+		RecordEvent();
+		RecordEdge(KeyName, ControllerId, false);
+		return false;
+	}
+
+	bool IsPressed(const uint32 Device, const uint32 Button) const { return Pressed[Device * FDirectInputKeys::NumButtons + Button]; }
+	void SetPressed(const uint32 Device, const uint32 Button, const bool bPressed) { Pressed[Device * FDirectInputKeys::NumButtons + Button] = bPressed; }
+
+	uint64 PollStartCycles = 0;
+	FLatencyHistogram Latency;
+
+	uint64 NumEvents = 0;
+	uint64 NumEdges = 0;
+	uint64 NumDuplicateEdges = 0;
+
+private:
+	void RecordEvent()
+	{
+		NumEvents++;
+		Latency.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - PollStartCycles) * 1000.0);
+	}
+
+	void RecordEdge(const FName KeyName, const int32 ControllerId, const bool bPressed)
+	{
+		const uint32* Button = ButtonIndices.Find(KeyName);
+		if (Button == nullptr || !Pressed.IsValidIndex(ControllerId * FDirectInputKeys::NumButtons))
+		{
+			return;
+		}
+
+		bool& bWasPressed = Pressed[ControllerId * FDirectInputKeys::NumButtons + *Button];
+		if (bWasPressed == bPressed)
+		{
+			NumDuplicateEdges++;
+		}
+		else
+		{
+			NumEdges++;
+		}
+		bWasPressed = bPressed;
+	}
+
+	TMap<FName, uint32> ButtonIndices;
+	TArray<bool> Pressed;
+};
+
+// At most this much of the run catches up on one game tick, frames due beyond it are dropped rather than stalling the game
+static constexpr double MaxCatchUpSeconds = 0.1;
+
+static double GetUsedMegabytes()
+{
+	return FPlatformMemory::GetStats().UsedPhysical / (1024.0 * 1024.0);
+}
+
+FDirectInputSoakTest::FDirectInputSoakTest(FDirectInputDevice& InInputDevice, const FSoakTestSettings& InSettings) :
+	InputDevice(InInputDevice),
+	Settings(InSettings),
+	Handler(MakeShared<FEdgeTrackingMessageHandler>(InSettings.NumDevices)),
+	Rate(FMath::Max<uint32>(InSettings.Rate, 1)),
+	NumFrames(FMath::Max<uint64>(static_cast<uint64>(InSettings.Minutes * 60.0 * FMath::Max<uint32>(InSettings.Rate, 1)), 1)),
+	Frame(0),
+	NextReportFrame(static_cast<uint64>(Rate) * 60),
+	NumDroppedFrames(0),
+	IntervalDroppedFrames(0),
+	bStopping(false),
+	bDone(false)
+{
+	Simulated = MakeUnique<FSimulatedDeviceScope>(InputDevice, Handler, Settings.NumDevices, SoakNumAxes, SoakNumButtons, SoakNumPovs);
+
+	Drivers.SetNum(Simulated->Num());
+	for (uint32 Index = 0; Index < Simulated->Num(); Index++)
+	{
+		Drivers[Index].Random.Initialize(Settings.Seed * 1000 + static_cast<int32>(Index));
+	}
+
+	Report = FString::Printf(TEXT("DirectInput soak test, %d devices at %d Hz for %.1f minutes, seed %d\r\n\r\n"), Simulated->Num(), Rate, Settings.Minutes, Settings.Seed);
+	Report += TEXT("Dispatch latency is from the start of the poll pass to each event reaching the message handler.\r\n");
+	Report += TEXT("Frames are run in batches on the game tick, dropped frames came due while a tick was late by more than 100 ms.\r\n\r\n");
+	Report += TEXT("Minute   Frame cost mean/p99/max us   Dispatch p99 us   Dropped frames   Used MB   Lost   Duplicate\r\n");
+
+	StartMegabytes = GetUsedMegabytes();
+	PeakMegabytes = StartMegabytes;
+	StartTime = FPlatformTime::Seconds();
+	NextFrameTime = StartTime;
+}
+
+FDirectInputSoakTest::~FDirectInputSoakTest()
+{
+	// Destroyed early, the report still covers the frames run so far
+	if (!bDone)
+	{
+		Finish();
+	}
+
+	// Puts the connected devices back
+	Simulated.Reset();
+}
+
+void FDirectInputSoakTest::Tick()
+{
+	if (bDone)
+	{
+		return;
+	}
+
+	// Every frame due since the last tick runs now, up to a limit so a hitch doesn't turn into a long stall
+	const double Period = 1.0 / Rate;
+	const double Now = FPlatformTime::Seconds();
+	const uint64 Due = Now >= NextFrameTime ? FMath::Min(static_cast<uint64>((Now - NextFrameTime) / Period) + 1, NumFrames - Frame) : 0;
+	const uint64 ToRun = FMath::Min(Due, FMath::Max<uint64>(static_cast<uint64>(MaxCatchUpSeconds * Rate), 1));
+	NextFrameTime += Due * Period;
+
+	for (uint64 Run = 0; Run < ToRun && !bStopping; Run++)
+	{
+		RunFrame();
+	}
+
+	NumDroppedFrames += Due - ToRun;
+	IntervalDroppedFrames += Due - ToRun;
+	Frame += Due - ToRun;
+
+	if (Frame >= NextReportFrame || Frame >= NumFrames || bStopping)
+	{
+		ReportInterval();
+		NextReportFrame = (Frame / (static_cast<uint64>(Rate) * 60) + 1) * Rate * 60;
+	}
+
+	if (Frame >= NumFrames || bStopping)
+	{
+		Finish();
+	}
+}
+
+void FDirectInputSoakTest::RunFrame()
+{
+	for (uint32 Index = 0; Index < Simulated->Num(); Index++)
+	{
+		DriveDevice(Index);
+	}
+
+	double Cost;
+	{
+		// Keeps the force feedback thread off the devices while they are polled
+		FScopeLock Lock(&GInputDevicesLock);
+		Handler->PollStartCycles = FPlatformTime::Cycles64();
+		InputDevice.SendDeviceEvents();
+		Cost = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - Handler->PollStartCycles) * 1000.0;
+	}
+	FrameCost.Add(Cost);
+	IntervalFrameCost.Add(Cost);
+
+	// After a successful read the dispatched buttons must match the device, anything else is a lost edge
+	for (uint32 Index = 0; Index < Simulated->Num(); Index++)
+	{
+		FSimulatedDevice& Device = Simulated->GetDevice(Index);
+		if (Device.GetNumStateReads() == Drivers[Index].NumStateReads)
+		{
+			continue;
+		}
+		Drivers[Index].NumStateReads = Device.GetNumStateReads();
+
+		for (uint32 Button = 0; Button < Device.GetNumButtons(); Button++)
+		{
+			if (Handler->IsPressed(Index, Button) != Device.GetButton(Button))
+			{
+				UE_CLOG(Result.NumLostEdges < 10, LogDirectInputSoak, Error, TEXT("Soak: Device %d button %d lost an edge in frame %llu"), Index, Button, Frame);
+				Result.NumLostEdges++;
+				Handler->SetPressed(Index, Button, Device.GetButton(Button));
+			}
+		}
+	}
+
+	Result.NumFrames++;
+	Frame++;
+}
+
+void FDirectInputSoakTest::DriveDevice(const uint32 Index)
+{
+	FSimulatedDevice& Device = Simulated->GetDevice(Index);
+	FDriver& Driver = Drivers[Index];
+	FRandomStream& Random = Driver.Random;
+
+	if (Driver.OfflineFrames > 0)
+	{
+		if (--Driver.OfflineFrames == 0)
+		{
+			// Plugged back in, but it may take a few attempts before it can be acquired
+			const uint32 Failures = Random.RandHelper(4);
+			Device.SetConnected(true);
+			Device.FailAcquire(Failures);
+			Result.NumAcquireFailures += Failures;
+		}
+	}
+	else if (Random.FRand() * Settings.DisconnectInterval * Rate < 1.0)
+	{
+		Device.SetConnected(false);
+		Driver.OfflineFrames = Random.RandRange(Rate / 20 + 1, Rate * 2);
+		Result.NumDisconnects++;
+	}
+
+	// Input keeps changing while the device is unplugged, edges in between are never seen and that is fine
+	const uint32 Axis = Random.RandHelper(Device.GetNumAxes());
+	Device.SetAxis(Axis, FMath::Clamp<int32>(Device.GetAxis(Axis) + Random.RandRange(-2000, 2000), 0, 65535));
+
+	const float Roll = Random.FRand();
+	if (Roll < 0.005f)
+	{
+		// Mash several buttons in the same frame now and then
+		for (uint32 Change = 0; Change < 8; Change++)
+		{
+			const uint32 Button = Random.RandHelper(Device.GetNumButtons());
+			Device.SetButton(Button, !Device.GetButton(Button));
+		}
+	}
+	else if (Roll < 0.05f)
+	{
+		const uint32 Button = Random.RandHelper(Device.GetNumButtons());
+		Device.SetButton(Button, !Device.GetButton(Button));
+	}
+	else if (Roll < 0.052f)
+	{
+		const int32 Direction = Random.RandRange(-1, 7);
+		Device.SetPov(0, Direction < 0 ? 0xFFFFFFFF : static_cast<DWORD>(Direction * 4500));
+	}
+}
+
+void FDirectInputSoakTest::ReportInterval()
+{
+	const double UsedMegabytes = GetUsedMegabytes();
+	PeakMegabytes = FMath::Max(PeakMegabytes, UsedMegabytes);
+
+	const FString Line = FString::Printf(TEXT("%6.1f   %8.1f %8.1f %8.1f   %15.1f   %14llu   %7.1f   %4llu   %9llu"),
+		Frame / (60.0 * Rate), IntervalFrameCost.GetMean(), IntervalFrameCost.GetPercentile(0.99), IntervalFrameCost.GetMax(),
+		Handler->Latency.GetPercentile(0.99), IntervalDroppedFrames, UsedMegabytes, Result.NumLostEdges, Handler->NumDuplicateEdges);
+	Report += Line + TEXT("\r\n");
+	UE_LOG(LogDirectInputSoak, Display, TEXT("Soak: %s"), *Line);
+
+	IntervalFrameCost.Reset();
+	IntervalDroppedFrames = 0;
+}
+
+void FDirectInputSoakTest::Finish()
+{
+	const double Elapsed = FPlatformTime::Seconds() - StartTime;
+	const double EndMegabytes = GetUsedMegabytes();
+
+	Result.NumEvents = Handler->NumEvents;
+	Result.NumEdges = Handler->NumEdges;
+	Result.NumDuplicateEdges = Handler->NumDuplicateEdges;
+
+	Report += FString::Printf(TEXT("\r\n%s%s\r\n"), Result.IsPassed() ? TEXT("PASSED") : TEXT("FAILED"), Frame < NumFrames ? TEXT(", stopped early") : TEXT(""));
+	Report += FString::Printf(TEXT("Frames           %llu in %.1f s, %.1f Hz achieved, %llu dropped\r\n"), Result.NumFrames, Elapsed, Elapsed > 0.0 ? Result.NumFrames / Elapsed : 0.0, NumDroppedFrames);
+	Report += FString::Printf(TEXT("Events           %llu, %llu button edges, %llu lost, %llu duplicate\r\n"), Result.NumEvents, Result.NumEdges, Result.NumLostEdges, Result.NumDuplicateEdges);
+	Report += FString::Printf(TEXT("Faults           %llu disconnects, %llu failed reacquires\r\n"), Result.NumDisconnects, Result.NumAcquireFailures);
+	Report += FString::Printf(TEXT("Frame cost us    mean %.1f, p50 %.0f, p99 %.0f, p99.9 %.0f, max %.1f\r\n"),
+		FrameCost.GetMean(), FrameCost.GetPercentile(0.5), FrameCost.GetPercentile(0.99), FrameCost.GetPercentile(0.999), FrameCost.GetMax());
+	Report += FString::Printf(TEXT("Dispatch us      mean %.1f, p50 %.0f, p99 %.0f, p99.9 %.0f, max %.1f\r\n"),
+		Handler->Latency.GetMean(), Handler->Latency.GetPercentile(0.5), Handler->Latency.GetPercentile(0.99), Handler->Latency.GetPercentile(0.999), Handler->Latency.GetMax());
+	Report += FString::Printf(TEXT("Memory MB        %.1f at start, %.1f at end, %.1f peak, %+.1f growth\r\n"), StartMegabytes, EndMegabytes, PeakMegabytes, EndMegabytes - StartMegabytes);
+
+	Result.ReportPath = FPaths::ProjectSavedDir() / TEXT("DirectInput") / FString::Printf(TEXT("Soak-%s.txt"), *FDateTime::Now().ToString());
+	if (!FFileHelper::SaveStringToFile(Report, *Result.ReportPath))
+	{
+		Result.ReportPath.Reset();
+	}
+
+	bDone = true;
+}
@@ -0,0 +1,76 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "StateSnapshot.h"
+
+FStateSnapshot::FStateSnapshot() :
+	Latest(0)
+{
+	for (FSlot& Slot : Slots)
+	{
+		Slot.Sequence.store(0, std::memory_order_relaxed);
+	}
+}
+
+void FStateSnapshot::Publish(const FDirectInputState& State)
+{
+	// Sequence 0 means nothing has been published, so the first state goes out as 1
+	const uint64 Sequence = Latest.load(std::memory_order_relaxed) + 1;
+	FSlot& Slot = Slots[Sequence % NumSlots];
+
+	// Invalidate the slot for readers that still hold an older sequence for it
+	Slot.Sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	Slot.State = State;
+	Slot.State.Sequence = Sequence;
+
+	Slot.Sequence.store(Sequence, std::memory_order_release);
+	Latest.store(Sequence, std::memory_order_release);
+}
+
+bool FStateSnapshot::Read(FDirectInputState& OutState) const
+{
+	for (uint32 Attempt = 0; Attempt < MaxReadAttempts; Attempt++)
+	{
+		const uint64 Sequence = Latest.load(std::memory_order_acquire);
+		if (Sequence == 0)
+		{
+			return false;
+		}
+
+		const FSlot& Slot = Slots[Sequence % NumSlots];
+		if (Slot.Sequence.load(std::memory_order_acquire) != Sequence)
+		{
+			continue;
+		}
+
+		FMemory::Memcpy(&OutState, &Slot.State, sizeof(FDirectInputState));
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (Slot.Sequence.load(std::memory_order_relaxed) == Sequence)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,185 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "TelemetryPublisher.h"
+
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include "Windows/WindowsHWrapper.h"
+#include "Windows/HideWindowsPlatformTypes.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogDirectInputTelemetry, Log, All);
+
+using namespace DirectInputTelemetry;
+
+static_assert(sizeof(FDirectInputState::Axes) == sizeof(FDeviceState::Axes), "Telemetry axes must match the state");
+static_assert(sizeof(FDirectInputState::Buttons) == sizeof(FDeviceState::Buttons), "Telemetry buttons must match the state");
+static_assert(sizeof(FDirectInputState::Povs) == sizeof(FDeviceState::Povs), "Telemetry POVs must match the state");
+
+// Back to the layout of the GUID the device reported, see ToFGuid for how its fields were packed into the words
+static void CopyGuid(const FGuid& Guid, uint8_t* Out)
+{
+	const uint32 Data1 = Guid.A;
+	const uint16 Data2 = static_cast<uint16>(Guid.B >> 16);
+	const uint16 Data3 = static_cast<uint16>(Guid.B);
+
+	for (int32 Byte = 0; Byte < 4; Byte++)
+	{
+		Out[Byte] = static_cast<uint8_t>(Data1 >> (Byte * 8));
+		Out[8 + Byte] = static_cast<uint8_t>(Guid.C >> (24 - Byte * 8));
+		Out[12 + Byte] = static_cast<uint8_t>(Guid.D >> (24 - Byte * 8));
+	}
+	for (int32 Byte = 0; Byte < 2; Byte++)
+	{
+		Out[4 + Byte] = static_cast<uint8_t>(Data2 >> (Byte * 8));
+		Out[6 + Byte] = static_cast<uint8_t>(Data3 >> (Byte * 8));
+	}
+}
+
+FTelemetryPublisher::FTelemetryPublisher() :
+	Mapping(nullptr),
+	Header(nullptr)
+{
+}
+
+FTelemetryPublisher::~FTelemetryPublisher()
+{
+	Close();
+}
+
+bool FTelemetryPublisher::Open(const FString& Name)
+{
+	Close();
+
+	const uint64 Size = GetRegionSize();
+	Mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(Size >> 32), static_cast<DWORD>(Size), *Name);
+	if (Mapping == nullptr)
+	{
+		UE_LOG(LogDirectInputTelemetry, Error, TEXT("Could not create %s: error %u"), *Name, GetLastError());
+		return false;
+	}
+
+	if (GetLastError() == ERROR_ALREADY_EXISTS)
+	{
+		UE_LOG(LogDirectInputTelemetry, Warning, TEXT("%s already exists, taking it over"), *Name);
+	}
+
+	void* View = MapViewOfFile(Mapping, FILE_MAP_ALL_ACCESS, 0, 0, Size);
+	if (View == nullptr)
+	{
+		UE_LOG(LogDirectInputTelemetry, Error, TEXT("Could not map %s: error %u"), *Name, GetLastError());
+		Close();
+		return false;
+	}
+
+	// Readers check the magic last, so the header is complete once it shows up
+	FMemory::Memzero(View, Size);
+	Header = static_cast<FHeader*>(View);
+	Header->Version = Version;
+	Header->HeaderSize = sizeof(FHeader);
+	Header->DeviceSize = sizeof(FDevice);
+	Header->MaxDevices = MaxDevices;
+	Header->NumDevices = 0;
+	Header->TicksPerSecond = static_cast<uint64_t>(1.0 / FPlatformTime::GetSecondsPerCycle64());
+	Header->ProcessId = FPlatformProcess::GetCurrentProcessId();
+	std::atomic_thread_fence(std::memory_order_release);
+	Header->Magic = Magic;
+
+	UE_LOG(LogDirectInputTelemetry, Display, TEXT("Publishing telemetry of up to %d devices to %s"), MaxDevices, *Name);
+	return true;
+}
+
+void FTelemetryPublisher::Close()
+{
+	if (Header != nullptr)
+	{
+		Header->Magic = 0;
+		UnmapViewOfFile(Header);
+		Header = nullptr;
+	}
+
+	if (Mapping != nullptr)
+	{
+		CloseHandle(Mapping);
+		Mapping = nullptr;
+	}
+}
+
+FDevice* FTelemetryPublisher::GetDevice(const uint32 Slot) const
+{
+	if (Header == nullptr || Slot >= MaxDevices)
+	{
+		return nullptr;
+	}
+
+	return reinterpret_cast<FDevice*>(reinterpret_cast<uint8*>(Header) + GetDeviceOffset(Header->HeaderSize, Header->DeviceSize, Slot));
+}
+
+void FTelemetryPublisher::SetDevice(const uint32 Slot, const FGuid& ProductGuid, const FGuid& InstanceGuid, const FString& Name)
+{
+	FDevice* Device = GetDevice(Slot);
+	if (Device == nullptr)
+	{
+		return;
+	}
+
+	const uint64 Sequence = Device->Sequence.load(std::memory_order_relaxed);
+	Device->Sequence.store(Sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	CopyGuid(ProductGuid, Device->State.ProductGuid);
+	CopyGuid(InstanceGuid, Device->State.InstanceGuid);
+
+	// Truncated to fit, a name cut inside a multibyte character ends with a partial one
+	const FTCHARToUTF8 Utf8(*Name);
+	const int32 Length = FMath::Min<int32>(Utf8.Length(), NameSize - 1);
+	FMemory::Memcpy(Device->State.Name, Utf8.Get(), Length);
+	Device->State.Name[Length] = '\0';
+
+	Device->Sequence.store(Sequence + 2, std::memory_order_release);
+
+	Header->NumDevices = FMath::Max(Header->NumDevices, Slot + 1);
+}
+
+void FTelemetryPublisher::Publish(const uint32 Slot, const FDirectInputState& State)
+{
+	FDevice* Device = GetDevice(Slot);
+	if (Device == nullptr)
+	{
+		return;
+	}
+
+	// Odd while writing, readers that saw it or saw it change retry
+	const uint64 Sequence = Device->Sequence.load(std::memory_order_relaxed);
+	Device->Sequence.store(Sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	FDeviceState& Out = Device->State;
+	Out.PublishCount++;
+	Out.Timestamp = FPlatformTime::Cycles64();
+	Out.NumAxes = State.NumAxes;
+	Out.NumButtons = State.NumButtons;
+	Out.NumPovs = State.NumPovs;
+	FMemory::Memcpy(Out.Axes, State.Axes, sizeof(Out.Axes));
+	FMemory::Memcpy(Out.Buttons, State.Buttons, sizeof(Out.Buttons));
+	FMemory::Memcpy(Out.Povs, State.Povs, sizeof(Out.Povs));
+
+	Device->Sequence.store(Sequence + 2, std::memory_order_release);
+}
@@ -0,0 +1,148 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "AxisFilter.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace AxisFilterTests
+{
+	enum EAxis { None, LowPass, OneEuro, Median3, Median5, NumFilters };
+
+	static const TCHAR* AxisNames[NumFilters] = { TEXT("None"), TEXT("LowPass"), TEXT("OneEuro"), TEXT("Median3"), TEXT("Median5") };
+
+	static constexpr float DeltaTime = 0.001f;
+	static constexpr float Cutoff = 5.0f;
+
+	// One axis for each filter, the rest unfiltered
+	static FAxisFilterProfile MakeProfile()
+	{
+		FAxisFilterProfile Profile;
+		Profile.Axes[LowPass].Type = EAxisFilter::LowPass;
+		Profile.Axes[LowPass].MinCutoff = Cutoff;
+		Profile.Axes[OneEuro].Type = EAxisFilter::OneEuro;
+		Profile.Axes[OneEuro].MinCutoff = Cutoff;
+		Profile.Axes[OneEuro].Beta = 0.001f;
+		Profile.Axes[Median3].Type = EAxisFilter::Median3;
+		Profile.Axes[Median5].Type = EAxisFilter::Median5;
+		return Profile;
+	}
+
+	static void Apply(FAxisFilterBank& Bank, const float Value, float* Out)
+	{
+		float In[FAxisFilterBank::NumAxes];
+		for (float& Axis : In)
+		{
+			Axis = Value;
+		}
+		Bank.Apply(In, Out, DeltaTime);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAxisFilterStepTest, "Plugins.DirectInput.AxisFilter.Step", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FAxisFilterStepTest::RunTest(const FString& Parameters)
+{
+	using namespace AxisFilterTests;
+
+	static constexpr int32 NumSamples = 1000;
+	static constexpr float Step = 1000.0f;
+
+	FAxisFilterBank Bank(MakeProfile());
+	float Out[FAxisFilterBank::NumAxes];
+	Apply(Bank, 0.0f, Out);
+
+	// Sample each axis first reads the step at, and its value one time constant after the step
+	int32 Settled[NumFilters] = { INDEX_NONE, INDEX_NONE, INDEX_NONE, INDEX_NONE, INDEX_NONE };
+	float Previous[NumFilters] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+	float AtTimeConstant = 0.0f;
+	const int32 TimeConstantSample = FMath::RoundToInt(1.0f / (2.0f * PI * Cutoff * DeltaTime)) - 1;
+
+	for (int32 Sample = 0; Sample < NumSamples; Sample++)
+	{
+		Apply(Bank, Step, Out);
+
+		for (int32 Axis = 0; Axis < NumFilters; Axis++)
+		{
+			// Rises without overshoot and stays put once it gets there
+			if (!TestTrue(FString::Printf(TEXT("%s rises to the step at %d"), AxisNames[Axis], Sample), Out[Axis] >= Previous[Axis] && Out[Axis] <= Step))
+				return false;
+
+			if (Settled[Axis] == INDEX_NONE && Out[Axis] == Step)
+			{
+				Settled[Axis] = Sample;
+			}
+			else if (Settled[Axis] != INDEX_NONE && !TestEqual(FString::Printf(TEXT("%s unchanged after settling, at %d"), AxisNames[Axis], Sample), Out[Axis], Previous[Axis]))
+			{
+				return false;
+			}
+			Previous[Axis] = Out[Axis];
+		}
+
+		if (Sample == TimeConstantSample)
+		{
+			AtTimeConstant = Out[LowPass];
+		}
+	}
+
+	TestEqual(TEXT("None passes the step"), Settled[None], 0);
+	TestEqual(TEXT("Median3 passes the step on the second sample"), Settled[Median3], 1);
+	TestEqual(TEXT("Median5 passes the step on the third sample"), Settled[Median5], 2);
+	TestTrue(TEXT("LowPass settles"), Settled[LowPass] != INDEX_NONE);
+	TestTrue(TEXT("OneEuro settles sooner than LowPass"), Settled[OneEuro] != INDEX_NONE && Settled[OneEuro] < Settled[LowPass]);
+
+	// A first-order low-pass covers 1 - 1 / e of the step in one time constant
+	TestEqual(TEXT("LowPass after one time constant"), AtTimeConstant, Step * (1.0f - FMath::Exp(-1.0f)), Step * 0.02f);
+	AddInfo(FString::Printf(TEXT("Settled within half a count after %d samples (LowPass) and %d samples (OneEuro) at %.0f Hz"), Settled[LowPass], Settled[OneEuro], 1.0f / DeltaTime));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAxisFilterSpikeTest, "Plugins.DirectInput.AxisFilter.Spike", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FAxisFilterSpikeTest::RunTest(const FString& Parameters)
+{
+	using namespace AxisFilterTests;
+
+	FAxisFilterBank Bank(MakeProfile());
+	float Out[FAxisFilterBank::NumAxes];
+	Apply(Bank, 0.0f, Out);
+
+	// A single sample spike is dropped by both medians
+	for (const float Value : { 1000.0f, 0.0f, 0.0f })
+	{
+		Apply(Bank, Value, Out);
+		TestEqual(TEXT("Median3 drops a spike"), Out[Median3], 0.0f);
+		TestEqual(TEXT("Median5 drops a spike"), Out[Median5], 0.0f);
+	}
+
+	// and two in a row by the five tap median, once the first spike has left its taps
+	for (const float Value : { 0.0f, 0.0f, 0.0f, 1000.0f, 1000.0f, 0.0f, 0.0f, 0.0f })
+	{
+		Apply(Bank, Value, Out);
+		TestEqual(TEXT("Median5 drops two spikes"), Out[Median5], 0.0f);
+	}
+
+	return true;
+}
+
+#endif
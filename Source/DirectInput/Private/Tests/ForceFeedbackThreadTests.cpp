@@ -0,0 +1,116 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "DirectInputDevice.h"
+#include "ForceFeedbackThread.h"
+#include "SimulatedDevice.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace ForceFeedbackThreadTests
+{
+	static constexpr uint32 NumDevices = 4;
+	static constexpr uint32 DefaultRate = 1000;
+	static constexpr float Seconds = 2.0f;
+
+	// Simulated devices with a force feedback thread of their own in place of the device's, put back when released
+	struct FRun
+	{
+		FRun(FDirectInputDevice& InInputDevice, const uint32 InRate) :
+			InputDevice(InInputDevice),
+			Rate(InRate)
+		{
+			// The running thread would drive the simulated devices as well
+			InputDevice.SuspendForceFeedback();
+			Simulated = MakeUnique<FSimulatedDeviceScope>(InputDevice, MakeShared<FGenericApplicationMessageHandler>(), NumDevices, 2, 8, 0);
+
+			// A force that flips every tick, so every tick updates every effect
+			Thread = MakeUnique<FForceFeedbackThread>(Rate, [NumCalls = 0u](int32 ControllerId, double Time) mutable
+			{
+				return (NumCalls++ / NumDevices) % 2 ? 5000.0f : -5000.0f;
+			});
+			StartTime = FPlatformTime::Seconds();
+		}
+
+		~FRun()
+		{
+			Thread.Reset();
+			Simulated.Reset();
+			InputDevice.ResumeForceFeedback();
+		}
+
+		FDirectInputDevice& InputDevice;
+		const uint32 Rate;
+		TUniquePtr<FSimulatedDeviceScope> Simulated;
+		TUniquePtr<FForceFeedbackThread> Thread;
+		double StartTime;
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FForceFeedbackThreadRateTest, "Plugins.DirectInput.ForceFeedbackThread.Rate", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FForceFeedbackThreadRateTest::RunTest(const FString& Parameters)
+{
+	using namespace ForceFeedbackThreadTests;
+
+	if (!FDirectInputModule::IsAvailable() || !FDirectInputModule::Get().GetDirectInputDevice().IsValid())
+	{
+		AddError(TEXT("The DirectInput device hasn't been created"));
+		return false;
+	}
+
+	FDirectInputDevice& InputDevice = static_cast<FDirectInputDevice&>(*FDirectInputModule::Get().GetDirectInputDevice());
+	if (InputDevice.IsSoakRunning())
+	{
+		AddError(TEXT("The soak test is running, stop it with DINPUT SOAK STOP"));
+		return false;
+	}
+
+	// The configured rate when the thread runs, so the check covers the rate the game will use
+	const uint32 Rate = InputDevice.GetForceFeedbackRate() > 0 ? InputDevice.GetForceFeedbackRate() : DefaultRate;
+	const TSharedRef<FRun> Run = MakeShared<FRun>(InputDevice, Rate);
+
+	// Waits for the thread to run a while without blocking the game thread
+	ADD_LATENT_AUTOMATION_COMMAND(FDelayedFunctionLatentCommand([this, Run]()
+	{
+		const FForceFeedbackStats Stats = Run->Thread->GetStats();
+		uint64 NumUpdates[NumDevices];
+		for (uint32 Index = 0; Index < NumDevices; Index++)
+		{
+			NumUpdates[Index] = Run->Simulated->GetDevice(Index).GetNumEffectUpdates();
+		}
+		const double Elapsed = FPlatformTime::Seconds() - Run->StartTime;
+
+		// Within 5% of the rate on every device
+		for (uint32 Index = 0; Index < NumDevices; Index++)
+		{
+			const double AchievedRate = NumUpdates[Index] / Elapsed;
+			AddInfo(FString::Printf(TEXT("Device %d: %.0f updates/s of %d"), Index, AchievedRate, Run->Rate));
+			TestTrue(FString::Printf(TEXT("Device %d gets within 5%% of the rate"), Index), AchievedRate >= Run->Rate * 0.95);
+		}
+		AddInfo(FString::Printf(TEXT("Jitter mean %.1f us, p99 %.0f us, max %.1f us"), Stats.JitterMean, Stats.JitterP99, Stats.JitterMax));
+	}, Seconds));
+
+	return true;
+}
+
+#endif
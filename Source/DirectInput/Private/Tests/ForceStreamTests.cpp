@@ -0,0 +1,164 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "ForceStream.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace ForceStreamTests
+{
+	static constexpr uint32 SampleRate = 1000;
+	static constexpr float BufferSeconds = 0.5f;
+
+	// Sample values that come out as whole force units, so the blocks can be compared exactly
+	static float MakeSample(const uint32 Sequence)
+	{
+		return static_cast<float>(static_cast<int32>(Sequence % 200) - 100) / 100.0f;
+	}
+
+	static int32 ToForce(const uint32 Sequence)
+	{
+		return (static_cast<int32>(Sequence % 200) - 100) * 100;
+	}
+
+	static int32 PushSequence(FForceStream& Stream, uint32& Sequence, const int32 Num)
+	{
+		TArray<float> Samples;
+		for (int32 Index = 0; Index < Num; Index++)
+		{
+			Samples.Add(MakeSample(Sequence + Index));
+		}
+		const int32 Taken = Stream.Push(Samples.GetData(), Num);
+		Sequence += Taken;
+		return Taken;
+	}
+
+	// Checks the current block holds the samples from Expected on, and advances Expected past them
+	static bool CheckBlock(FAutomationTestBase& Test, const FForceStream& Stream, uint32& Expected)
+	{
+		for (int32 Index = 0; Index < Stream.GetBlockSize(); Index++, Expected++)
+		{
+			if (!Test.TestEqual(FString::Printf(TEXT("Sample %u"), Expected), Stream.GetBlock()[Index], ToForce(Expected)))
+				return false;
+		}
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FForceStreamUnderrunTest, "Plugins.DirectInput.ForceStream.Underrun", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FForceStreamUnderrunTest::RunTest(const FString& Parameters)
+{
+	using namespace ForceStreamTests;
+
+	FForceStream Stream(SampleRate, BufferSeconds);
+	uint32 Sequence = 0;
+	uint32 Expected = 0;
+
+	TestEqual(TEXT("Capacity is the buffer rounded up to a power of two"), Stream.GetCapacity(), 512u);
+	TestFalse(TEXT("Nothing to fill before the generator starts"), Stream.Fill());
+
+	PushSequence(Stream, Sequence, 30);
+	const uint32 FirstBlock = Stream.GetBlockIndex();
+	TestTrue(TEXT("Fills what has arrived"), Stream.Fill());
+	TestEqual(TEXT("Block holds only what arrived"), Stream.GetBlockSize(), 30);
+	TestEqual(TEXT("Block duration"), Stream.GetBlockDuration(), 30000u);
+	TestNotEqual(TEXT("Fill switches block"), Stream.GetBlockIndex(), FirstBlock);
+	CheckBlock(*this, Stream, Expected);
+
+	// The generator fell behind, the block the device has is left alone and nothing new is handed out
+	const uint32 LastBlock = Stream.GetBlockIndex();
+	TestFalse(TEXT("Nothing to fill when the generator falls behind"), Stream.Fill());
+	TestEqual(TEXT("Block kept on underrun"), Stream.GetBlockIndex(), LastBlock);
+	TestEqual(TEXT("Block size kept on underrun"), Stream.GetBlockSize(), 30);
+
+	// and picks up where it left off when it catches up
+	PushSequence(Stream, Sequence, 10);
+	TestTrue(TEXT("Fills after catching up"), Stream.Fill());
+	TestNotEqual(TEXT("Fill switches block after an underrun"), Stream.GetBlockIndex(), LastBlock);
+	CheckBlock(*this, Stream, Expected);
+	TestEqual(TEXT("No samples lost or repeated"), Expected, Sequence);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FForceStreamWrapTest, "Plugins.DirectInput.ForceStream.Wrap", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FForceStreamWrapTest::RunTest(const FString& Parameters)
+{
+	using namespace ForceStreamTests;
+
+	FForceStream Stream(SampleRate, BufferSeconds);
+	uint32 Sequence = 0;
+	uint32 Expected = 0;
+
+	// Odd sized pushes and drains go around the ring several times with the indices landing everywhere in it
+	for (int32 Round = 0; Round < 50; Round++)
+	{
+		PushSequence(Stream, Sequence, 37 + Round % 7 * 13);
+		while (Stream.Fill())
+		{
+			if (!TestTrue(TEXT("Block no longer than a tenth of a second"), Stream.GetBlockSize() <= static_cast<int32>(Stream.GetMaxBlockSize())))
+				return false;
+			if (!CheckBlock(*this, Stream, Expected))
+				return false;
+		}
+	}
+
+	TestTrue(TEXT("Went around the ring"), Sequence > 4 * Stream.GetCapacity());
+	TestEqual(TEXT("Every sample drained in order"), Expected, Sequence);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FForceStreamOverrunTest, "Plugins.DirectInput.ForceStream.Overrun", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FForceStreamOverrunTest::RunTest(const FString& Parameters)
+{
+	using namespace ForceStreamTests;
+
+	FForceStream Stream(SampleRate, BufferSeconds);
+	uint32 Sequence = 0;
+	uint32 Expected = 0;
+
+	// A full ring takes nothing more, the samples already in it are kept rather than overwritten
+	TestEqual(TEXT("Takes up to the capacity"), PushSequence(Stream, Sequence, 500), 500);
+	TestEqual(TEXT("Takes only the free space"), PushSequence(Stream, Sequence, 100), 12);
+	TestEqual(TEXT("Takes nothing when full"), PushSequence(Stream, Sequence, 1), 0);
+
+	// Draining frees the space a block at a time
+	TestTrue(TEXT("Fills from a full ring"), Stream.Fill());
+	TestEqual(TEXT("Block capped at a tenth of a second"), Stream.GetBlockSize(), static_cast<int32>(Stream.GetMaxBlockSize()));
+	CheckBlock(*this, Stream, Expected);
+	TestEqual(TEXT("Takes the freed space"), PushSequence(Stream, Sequence, 200), static_cast<int32>(Stream.GetMaxBlockSize()));
+
+	while (Stream.Fill())
+	{
+		if (!CheckBlock(*this, Stream, Expected))
+			return false;
+	}
+	TestEqual(TEXT("Kept the oldest samples"), Expected, Sequence);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,308 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "InputPacket.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+static FInputPacket MakeRandomPacket(const FInputPacketFormat& Format, FRandomStream& Random)
+{
+	FInputPacket Packet;
+	for (uint32 Axis = 0; Axis < Format.NumAxes; Axis++)
+	{
+		Packet.Axes[Axis] = static_cast<uint32>(Random.RandHelper(1 << Format.AxisBits[Axis]));
+	}
+	for (uint32 Button = 0; Button < Format.NumButtons; Button++)
+	{
+		if (Random.RandHelper(2))
+		{
+			Packet.Buttons[Button / 32] |= 1u << (Button % 32);
+		}
+	}
+	return Packet;
+}
+
+// Writes Packet against Baseline and reads it back against ReadBaseline, returns the bits written
+static int64 RoundTrip(const FInputPacketCodec& Codec, const FInputPacket& Packet, const FInputPacket& Baseline, const FInputPacket& ReadBaseline, FInputPacket& OutPacket)
+{
+	FBitWriter Writer(0, true);
+	FInputPacket Written = Packet;
+	Codec.Serialize(Writer, Written, Baseline);
+
+	FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+	Codec.Serialize(Reader, OutPacket, ReadBaseline);
+	return Writer.GetNumBits();
+}
+
+// Bits a packet costs when every axis and button word is sent as a full word
+static uint32 GetFullWordBits(const FInputPacketFormat& Format)
+{
+	return (Format.NumAxes + FMath::DivideAndRoundUp(Format.NumButtons, 32u)) * 32;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInputPacketQuantizeTest, "Plugins.DirectInput.InputPacket.Quantize", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FInputPacketQuantizeTest::RunTest(const FString& Parameters)
+{
+	for (const uint32 Bits : { 1u, 2u, 8u, 10u, 15u, 16u })
+	{
+		const FInputPacketCodec Codec(FInputPacketFormat(1, Bits, 0));
+		const uint32 MaxValue = (1u << Bits) - 1;
+
+		FDirectInputState State;
+		FMemory::Memzero(State);
+		State.NumAxes = 1;
+
+		FInputPacket Packet;
+		FDirectInputState Decoded;
+
+		// The ends of the range and anything past them map to the first and last step
+		for (const float Value : { -1.0f, -1.5f })
+		{
+			State.Axes[0] = Value;
+			Codec.Quantize(State, Packet);
+			TestEqual(FString::Printf(TEXT("%d bits, %f"), Bits, Value), static_cast<int64>(Packet.Axes[0]), static_cast<int64>(0));
+		}
+		for (const float Value : { 1.0f, 1.5f })
+		{
+			State.Axes[0] = Value;
+			Codec.Quantize(State, Packet);
+			TestEqual(FString::Printf(TEXT("%d bits, %f"), Bits, Value), static_cast<int64>(Packet.Axes[0]), static_cast<int64>(MaxValue));
+			Codec.Dequantize(Packet, Decoded);
+			TestEqual(FString::Printf(TEXT("%d bits, %f decoded"), Bits, Value), Decoded.Axes[0], 1.0f);
+		}
+
+		// Everything in between comes back within half a step, a step being 2 / MaxValue
+		const float Tolerance = 1.0f / MaxValue + KINDA_SMALL_NUMBER;
+		for (int32 Index = 0; Index <= 200; Index++)
+		{
+			State.Axes[0] = Index / 100.0f - 1.0f;
+			Codec.Quantize(State, Packet);
+			TestTrue(FString::Printf(TEXT("%d bits in range"), Bits), Packet.Axes[0] <= MaxValue);
+			Codec.Dequantize(Packet, Decoded);
+			TestTrue(FString::Printf(TEXT("%d bits, %f within half a step"), Bits, State.Axes[0]), FMath::Abs(Decoded.Axes[0] - State.Axes[0]) <= Tolerance);
+		}
+	}
+
+	// Axes the state doesn't have are centred and buttons past the format are masked off
+	{
+		const FInputPacketCodec Codec(FInputPacketFormat(2, 8, 33));
+
+		FDirectInputState State;
+		FMemory::Memzero(State);
+		State.NumAxes = 1;
+		State.Axes[1] = 1.0f;
+		for (uint32& Word : State.Buttons)
+		{
+			Word = ~0u;
+		}
+
+		FInputPacket Packet;
+		Codec.Quantize(State, Packet);
+		TestEqual(TEXT("Missing axis centred"), static_cast<int64>(Packet.Axes[1]), static_cast<int64>(128));
+		TestEqual(TEXT("First button word"), static_cast<int64>(Packet.Buttons[0]), static_cast<int64>(~0u));
+		TestEqual(TEXT("Second button word"), static_cast<int64>(Packet.Buttons[1]), static_cast<int64>(1));
+		TestEqual(TEXT("Third button word"), static_cast<int64>(Packet.Buttons[2]), static_cast<int64>(0));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInputPacketSerializeTest, "Plugins.DirectInput.InputPacket.Serialize", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FInputPacketSerializeTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(31);
+
+	for (const uint32 NumAxes : { 0u, 1u, 4u, 8u })
+	{
+		for (const uint32 Bits : { 1u, 7u, 16u })
+		{
+			for (const uint32 NumButtons : { 0u, 1u, 31u, 32u, 33u, 128u })
+			{
+				FInputPacketFormat Format(NumAxes, Bits, NumButtons);
+				if (NumAxes > 1)
+				{
+					// Mixed depths in one packet
+					Format.SetAxisBits(1, 16);
+				}
+				const FInputPacketCodec Codec(Format);
+				const FString Case = FString::Printf(TEXT("%d axes of %d bits, %d buttons"), NumAxes, Bits, NumButtons);
+
+				for (int32 Iteration = 0; Iteration < 50; Iteration++)
+				{
+					const FInputPacket Baseline = MakeRandomPacket(Format, Random);
+					const FInputPacket Packet = MakeRandomPacket(Format, Random);
+
+					FInputPacket Decoded;
+					const int64 NumBits = RoundTrip(Codec, Packet, Baseline, Baseline, Decoded);
+					if (!TestTrue(Case, Decoded == Packet) || !TestEqual(Case + TEXT(" size"), NumBits, static_cast<int64>(Codec.GetSerializedBits(Packet, Baseline))))
+					{
+						return false;
+					}
+				}
+
+				// Nothing changed costs one bit per axis and button word
+				const FInputPacket Packet = MakeRandomPacket(Format, Random);
+				FInputPacket Decoded;
+				TestEqual(Case + TEXT(" unchanged size"), RoundTrip(Codec, Packet, Packet, Packet, Decoded), static_cast<int64>(NumAxes + FMath::DivideAndRoundUp(NumButtons, 32u)));
+				TestTrue(Case + TEXT(" unchanged"), Decoded == Packet);
+			}
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInputPacketDeltaTest, "Plugins.DirectInput.InputPacket.Delta", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FInputPacketDeltaTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(310);
+	const FInputPacketFormat Format(4, 10, 16);
+	const FInputPacketCodec Codec(Format);
+
+	// Every packet sent since the last acknowledgement is against the same baseline, so any of them can be lost
+	const FInputPacket Acknowledged = MakeRandomPacket(Format, Random);
+	FInputPacket Sent[4];
+	for (FInputPacket& Packet : Sent)
+	{
+		Packet = Acknowledged;
+		Packet.Axes[Random.RandHelper(Format.NumAxes)] = Random.RandHelper(1 << 10);
+		Packet.Buttons[0] ^= 1u << Random.RandHelper(16);
+	}
+
+	for (const int32 Received : { 0, 2, 3 })
+	{
+		FInputPacket Decoded;
+		RoundTrip(Codec, Sent[Received], Acknowledged, Acknowledged, Decoded);
+		TestTrue(FString::Printf(TEXT("Packet %d after a gap"), Received), Decoded == Sent[Received]);
+	}
+
+	// Once a newer packet is acknowledged both sides move to it
+	{
+		const FInputPacket& NewBaseline = Sent[2];
+		FInputPacket Next = NewBaseline;
+		Next.Axes[0] ^= 1;
+
+		FInputPacket Decoded;
+		const int64 NumBits = RoundTrip(Codec, Next, NewBaseline, NewBaseline, Decoded);
+		TestTrue(TEXT("Against the new baseline"), Decoded == Next);
+		TestEqual(TEXT("One changed axis"), NumBits, static_cast<int64>(Format.NumAxes + 1 + 10));
+	}
+
+	// A receiver on another baseline decodes the unchanged fields from its own, which is why the baseline has to be
+	// the last packet the receiver acknowledged
+	{
+		FInputPacket Other = Acknowledged;
+		Other.Axes[3] ^= 1;
+		Other.Buttons[0] ^= 1;
+
+		FInputPacket Decoded;
+		RoundTrip(Codec, Acknowledged, Acknowledged, Other, Decoded);
+		TestTrue(TEXT("Mismatched baselines differ"), Decoded != Acknowledged);
+		TestTrue(TEXT("Mismatched baselines decode to the receiver's"), Decoded == Other);
+	}
+
+	// Before anything is acknowledged the baseline is a default packet
+	{
+		const FInputPacket Packet = MakeRandomPacket(Format, Random);
+		FInputPacket Decoded;
+		RoundTrip(Codec, Packet, FInputPacket(), FInputPacket(), Decoded);
+		TestTrue(TEXT("Against the default baseline"), Decoded == Packet);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInputPacketBandwidthTest, "Plugins.DirectInput.InputPacket.Bandwidth", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FInputPacketBandwidthTest::RunTest(const FString& Parameters)
+{
+	// A wheel, three pedals and 16 buttons driven for a minute at 60 Hz, acknowledged three packets late
+	static constexpr int32 NumFrames = 3600;
+	static constexpr int32 AckDelay = 3;
+
+	FInputPacketFormat Format(4, 10, 16);
+	Format.SetAxisBits(0, 14);
+	const FInputPacketCodec Codec(Format);
+
+	FRandomStream Random(3100);
+	FDirectInputState State;
+	FMemory::Memzero(State);
+	State.NumAxes = 4;
+	State.NumButtons = 16;
+
+	TArray<FInputPacket> Packets;
+	Packets.SetNum(NumFrames);
+
+	uint64 PackedBits = 0;
+	for (int32 Frame = 0; Frame < NumFrames; Frame++)
+	{
+		// The wheel moves most frames, a pedal some of them and a button now and then
+		State.Axes[0] = FMath::Clamp(State.Axes[0] + Random.FRandRange(-0.02f, 0.02f), -1.0f, 1.0f);
+		if (Random.FRand() < 0.3f)
+		{
+			const int32 Pedal = 1 + Random.RandHelper(3);
+			State.Axes[Pedal] = FMath::Clamp(State.Axes[Pedal] + Random.FRandRange(-0.1f, 0.1f), -1.0f, 1.0f);
+		}
+		if (Random.FRand() < 0.02f)
+		{
+			State.Buttons[0] ^= 1u << Random.RandHelper(16);
+		}
+
+		Codec.Quantize(State, Packets[Frame]);
+		const FInputPacket Baseline = Frame >= AckDelay ? Packets[Frame - AckDelay] : FInputPacket();
+
+		FInputPacket Decoded;
+		PackedBits += RoundTrip(Codec, Packets[Frame], Baseline, Baseline, Decoded);
+		if (!TestTrue(FString::Printf(TEXT("Frame %d"), Frame), Decoded == Packets[Frame]))
+		{
+			return false;
+		}
+	}
+
+	const uint64 FullWordBits = static_cast<uint64>(GetFullWordBits(Format)) * NumFrames;
+	const double Ratio = static_cast<double>(PackedBits) / FullWordBits;
+	AddInfo(FString::Printf(TEXT("%.1f bits per packet against %d as full words, %.1f%%"), static_cast<double>(PackedBits) / NumFrames, GetFullWordBits(Format), Ratio * 100.0));
+	TestTrue(TEXT("Packed smaller than full words"), Ratio < 0.5);
+
+	// Throughput of quantising and writing, the receiver side costs about the same
+	static constexpr int32 NumIterations = 100000;
+	FBitWriter Writer(0, true);
+	const double StartTime = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+	{
+		FInputPacket Packet;
+		Codec.Quantize(State, Packet);
+		Writer.Reset();
+		Codec.Serialize(Writer, Packet, Packets[Iteration % NumFrames]);
+	}
+	const double Elapsed = FPlatformTime::Seconds() - StartTime;
+	AddInfo(FString::Printf(TEXT("%.0f ns per packet, %.1f million packets per second"), Elapsed * 1.0e9 / NumIterations, NumIterations / Elapsed / 1.0e6));
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,110 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Runtime/Launch/Resources/Version.h"
+
+// Four floats, VectorRegister holds doubles since large world coordinates
+#if ENGINE_MAJOR_VERSION >= 5
+typedef VectorRegister4Float FAxisFilterRegister;
+#else
+typedef VectorRegister FAxisFilterRegister;
+#endif
+
+enum class EAxisFilter : uint8
+{
+	None,
+	LowPass,
+	OneEuro,
+	Median3,
+	Median5,
+};
+
+struct FAxisFilterSettings
+{
+	EAxisFilter Type = EAxisFilter::None;
+	// Cut-off in Hz of the low-pass, or the cut-off of the one-euro filter when the axis is at rest
+	float MinCutoff = 1.0f;
+	// How much the one-euro cut-off rises with speed in counts per second, and the cut-off of that speed estimate
+	float Beta = 0.0f;
+	float DerivativeCutoff = 1.0f;
+};
+
+struct FAxisFilterProfile
+{
+	static constexpr uint32 MaxAxes = 8;
+
+	FAxisFilterSettings Axes[MaxAxes];
+};
+
+// Filter settings keyed by product GUID, read from the [DirectInput] section of the input config:
+// +AxisFilter=<ProductGuid>,<Axis>,LowPass,<CutoffHz>
+// +AxisFilter=<ProductGuid>,<Axis>,OneEuro,<MinCutoffHz>,<Beta>[,<DerivativeCutoffHz>]
+// +AxisFilter=<ProductGuid>,<Axis>,Median3|Median5
+class FAxisFilterStore
+{
+public:
+	void LoadConfig();
+
+	const FAxisFilterProfile* Find(const FGuid& Product) const { return Profiles.Find(Product); }
+	int32 Num() const { return Profiles.Num(); }
+
+private:
+	TMap<FGuid, FAxisFilterProfile> Profiles;
+};
+
+// Filters the eight axes of a device four at a time with the engine's vector intrinsics, which fall back to scalar
+// code on platforms without them. Every filter is evaluated for every axis and the configured one is selected, so the
+// cost doesn't depend on the configuration.
+class FAxisFilterBank
+{
+public:
+	static constexpr uint32 NumAxes = FAxisFilterProfile::MaxAxes;
+
+	explicit FAxisFilterBank(const FAxisFilterProfile& Profile);
+
+	// Filter NumAxes values, rounded to whole counts, the first call primes the filters with In
+	void Apply(const float* In, float* Out, float DeltaTime);
+
+	// Nanoseconds per device per sample of filtering NumDevices devices with a mix of filters
+	static double Benchmark(uint32 NumDevices, uint32 NumSamples);
+
+private:
+	static constexpr uint32 NumRegisters = NumAxes / 4;
+	static constexpr uint32 MedianTaps = 5;
+
+	// Cut-offs and beta are premultiplied by 2 pi
+	FAxisFilterRegister MinCutoff[NumRegisters];
+	FAxisFilterRegister Beta[NumRegisters];
+	FAxisFilterRegister DerivativeCutoff[NumRegisters];
+	FAxisFilterRegister SmoothMask[NumRegisters];
+	FAxisFilterRegister Median3Mask[NumRegisters];
+	FAxisFilterRegister Median5Mask[NumRegisters];
+
+	FAxisFilterRegister Smoothed[NumRegisters];
+	FAxisFilterRegister Derivative[NumRegisters];
+	FAxisFilterRegister PreviousInput[NumRegisters];
+	FAxisFilterRegister History[MedianTaps][NumRegisters];
+
+	bool bPrimed;
+};
@@ -0,0 +1,61 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AxisFilter.h"
+#include "Calibration.h"
+
+// Normalises the axes of every device in one pass. Each device gets eight lanes in arrays of raw values, parameters
+// and results, the parameters are worked out from the calibration when it changes so converting is the same few
+// vector operations for every lane.
+class FAxisNormalizer
+{
+public:
+	static constexpr uint32 LanesPerDevice = FAxisFilterBank::NumAxes;
+
+	// Lanes for one more device, returns the first lane
+	uint32 AddDevice();
+	void Reset();
+
+	// Axes inside DeadZone (0..1) of the centre read as centred, the rest of the range is rescaled to start from there
+	void SetAxis(uint32 Lane, const FAxisCalibration& Calibration, float DeadZone);
+
+	float* GetInput(uint32 Lane) { return Input.GetData() + Lane; }
+	const float* GetOutput(uint32 Lane) const { return Output.GetData() + Lane; }
+
+	void Convert();
+
+	int32 NumLanes() const { return Input.Num(); }
+
+private:
+	typedef TArray<float, TAlignedHeapAllocator<16>> FLaneArray;
+
+	FLaneArray Input;
+	FLaneArray Center;
+	FLaneArray ScaleBelow;
+	FLaneArray ScaleAbove;
+	FLaneArray DeadZone;
+	FLaneArray DeadZoneScale;
+	FLaneArray Sign;
+	FLaneArray Output;
+};
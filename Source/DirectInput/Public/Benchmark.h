@@ -0,0 +1,59 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FDirectInputDevice;
+
+struct FBenchmarkResult
+{
+	FString Name;
+	uint32 NumDevices = 0;
+	uint32 NumFrames = 0;
+	double NanosecondsPerDeviceFrame = 0.0;
+	double EventsPerSecond = 0.0;
+	// How far apart the devices are
+	uint32 DeviceStride = 0;
+	// Dispatch pass over unchanged devices with cold caches, in ns per device, with the current layout and with the one
+	// before the metadata was split off. Only measured by the Dispatch case.
+	double DispatchNanoseconds = 0.0;
+	double LegacyDispatchNanoseconds = 0.0;
+	// Creating a device without its objects in the device cache, in ns per device, for the Startup case whose
+	// NanosecondsPerDeviceFrame is the time with them
+	double UncachedStartupNanoseconds = 0.0;
+};
+
+// Times polling, diffing, dispatch and force feedback against simulated devices. Baselines are kept per case in the
+// [DirectInput.Benchmarks] section of the input config.
+class FDirectInputBenchmark
+{
+public:
+	static const TArray<FString>& GetCaseNames();
+
+	// False if there is no case with that name
+	static bool Run(FDirectInputDevice& InputDevice, const FString& Name, uint32 NumFrames, FBenchmarkResult& OutResult);
+
+	// False if the result is slower than its baseline by more than Threshold (0.1 is 10%), or there is no baseline
+	static bool CompareWithBaseline(const FBenchmarkResult& Result, float Threshold, double& OutBaseline);
+	static void SaveBaseline(const FBenchmarkResult& Result);
+};
@@ -1,316 +1,129 @@
-﻿/* 
- * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
- * 
- * Permission is hereby granted, free of charge, to any person obtaining a copy of 
- * this software and associated documentation files (the "Software"), to deal in the 
- * Software without restriction, including without limitation the rights to use, copy, 
- * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
- * and to permit persons to whom the Software is furnished to do so, subject to the 
- * following conditions:
- *
- * The above copyright notice and this permission notice shall be included in all 
- * copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
- * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
- * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
- * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
- * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
- * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
-*/
-
-#pragma once
-
-#include "InputCoreTypes.h"
-
-struct FDirectInputKeyNames
-{
-	static const FGamepadKeyNames::Type Axis1;
-	static const FGamepadKeyNames::Type Axis2;
-	static const FGamepadKeyNames::Type Axis3;
-	static const FGamepadKeyNames::Type Axis4;
-	static const FGamepadKeyNames::Type Axis5;
-	static const FGamepadKeyNames::Type Axis6;
-	static const FGamepadKeyNames::Type Axis7;
-	static const FGamepadKeyNames::Type Axis8;
-
-	static const FGamepadKeyNames::Type Button1;
-	static const FGamepadKeyNames::Type Button2;
-	static const FGamepadKeyNames::Type Button3;
-	static const FGamepadKeyNames::Type Button4;
-	static const FGamepadKeyNames::Type Button5;
-	static const FGamepadKeyNames::Type Button6;
-	static const FGamepadKeyNames::Type Button7;
-	static const FGamepadKeyNames::Type Button8;
-	static const FGamepadKeyNames::Type Button9;
-	static const FGamepadKeyNames::Type Button10;
-	static const FGamepadKeyNames::Type Button11;
-	static const FGamepadKeyNames::Type Button12;
-	static const FGamepadKeyNames::Type Button13;
-	static const FGamepadKeyNames::Type Button14;
-	static const FGamepadKeyNames::Type Button15;
-	static const FGamepadKeyNames::Type Button16;
-	static const FGamepadKeyNames::Type Button17;
-	static const FGamepadKeyNames::Type Button18;
-	static const FGamepadKeyNames::Type Button19;
-	static const FGamepadKeyNames::Type Button20;
-	static const FGamepadKeyNames::Type Button21;
-	static const FGamepadKeyNames::Type Button22;
-	static const FGamepadKeyNames::Type Button23;
-	static const FGamepadKeyNames::Type Button24;
-	static const FGamepadKeyNames::Type Button25;
-	static const FGamepadKeyNames::Type Button26;
-	static const FGamepadKeyNames::Type Button27;
-	static const FGamepadKeyNames::Type Button28;
-	static const FGamepadKeyNames::Type Button29;
-	static const FGamepadKeyNames::Type Button30;
-	static const FGamepadKeyNames::Type Button31;
-	static const FGamepadKeyNames::Type Button32;
-	static const FGamepadKeyNames::Type Button33;
-	static const FGamepadKeyNames::Type Button34;
-	static const FGamepadKeyNames::Type Button35;
-	static const FGamepadKeyNames::Type Button36;
-	static const FGamepadKeyNames::Type Button37;
-	static const FGamepadKeyNames::Type Button38;
-	static const FGamepadKeyNames::Type Button39;
-	static const FGamepadKeyNames::Type Button40;
-	static const FGamepadKeyNames::Type Button41;
-	static const FGamepadKeyNames::Type Button42;
-	static const FGamepadKeyNames::Type Button43;
-	static const FGamepadKeyNames::Type Button44;
-	static const FGamepadKeyNames::Type Button45;
-	static const FGamepadKeyNames::Type Button46;
-	static const FGamepadKeyNames::Type Button47;
-	static const FGamepadKeyNames::Type Button48;
-	static const FGamepadKeyNames::Type Button49;
-	static const FGamepadKeyNames::Type Button50;
-	static const FGamepadKeyNames::Type Button51;
-	static const FGamepadKeyNames::Type Button52;
-	static const FGamepadKeyNames::Type Button53;
-	static const FGamepadKeyNames::Type Button54;
-	static const FGamepadKeyNames::Type Button55;
-	static const FGamepadKeyNames::Type Button56;
-	static const FGamepadKeyNames::Type Button57;
-	static const FGamepadKeyNames::Type Button58;
-	static const FGamepadKeyNames::Type Button59;
-	static const FGamepadKeyNames::Type Button60;
-	static const FGamepadKeyNames::Type Button61;
-	static const FGamepadKeyNames::Type Button62;
-	static const FGamepadKeyNames::Type Button63;
-	static const FGamepadKeyNames::Type Button64;
-	static const FGamepadKeyNames::Type Button65;
-	static const FGamepadKeyNames::Type Button66;
-	static const FGamepadKeyNames::Type Button67;
-	static const FGamepadKeyNames::Type Button68;
-	static const FGamepadKeyNames::Type Button69;
-	static const FGamepadKeyNames::Type Button70;
-	static const FGamepadKeyNames::Type Button71;
-	static const FGamepadKeyNames::Type Button72;
-	static const FGamepadKeyNames::Type Button73;
-	static const FGamepadKeyNames::Type Button74;
-	static const FGamepadKeyNames::Type Button75;
-	static const FGamepadKeyNames::Type Button76;
-	static const FGamepadKeyNames::Type Button77;
-	static const FGamepadKeyNames::Type Button78;
-	static const FGamepadKeyNames::Type Button79;
-	static const FGamepadKeyNames::Type Button80;
-	static const FGamepadKeyNames::Type Button81;
-	static const FGamepadKeyNames::Type Button82;
-	static const FGamepadKeyNames::Type Button83;
-	static const FGamepadKeyNames::Type Button84;
-	static const FGamepadKeyNames::Type Button85;
-	static const FGamepadKeyNames::Type Button86;
-	static const FGamepadKeyNames::Type Button87;
-	static const FGamepadKeyNames::Type Button88;
-	static const FGamepadKeyNames::Type Button89;
-	static const FGamepadKeyNames::Type Button90;
-	static const FGamepadKeyNames::Type Button91;
-	static const FGamepadKeyNames::Type Button92;
-	static const FGamepadKeyNames::Type Button93;
-	static const FGamepadKeyNames::Type Button94;
-	static const FGamepadKeyNames::Type Button95;
-	static const FGamepadKeyNames::Type Button96;
-	static const FGamepadKeyNames::Type Button97;
-	static const FGamepadKeyNames::Type Button98;
-	static const FGamepadKeyNames::Type Button99;
-	static const FGamepadKeyNames::Type Button100;
-	static const FGamepadKeyNames::Type Button101;
-	static const FGamepadKeyNames::Type Button102;
-	static const FGamepadKeyNames::Type Button103;
-	static const FGamepadKeyNames::Type Button104;
-	static const FGamepadKeyNames::Type Button105;
-	static const FGamepadKeyNames::Type Button106;
-	static const FGamepadKeyNames::Type Button107;
-	static const FGamepadKeyNames::Type Button108;
-	static const FGamepadKeyNames::Type Button109;
-	static const FGamepadKeyNames::Type Button110;
-	static const FGamepadKeyNames::Type Button111;
-	static const FGamepadKeyNames::Type Button112;
-	static const FGamepadKeyNames::Type Button113;
-	static const FGamepadKeyNames::Type Button114;
-	static const FGamepadKeyNames::Type Button115;
-	static const FGamepadKeyNames::Type Button116;
-	static const FGamepadKeyNames::Type Button117;
-	static const FGamepadKeyNames::Type Button118;
-	static const FGamepadKeyNames::Type Button119;
-	static const FGamepadKeyNames::Type Button120;
-	static const FGamepadKeyNames::Type Button121;
-	static const FGamepadKeyNames::Type Button122;
-	static const FGamepadKeyNames::Type Button123;
-	static const FGamepadKeyNames::Type Button124;
-	static const FGamepadKeyNames::Type Button125;
-	static const FGamepadKeyNames::Type Button126;
-	static const FGamepadKeyNames::Type Button127;
-	static const FGamepadKeyNames::Type Button128;
-
-	static const FGamepadKeyNames::Type Pov1;
-	static const FGamepadKeyNames::Type Pov2;
-	static const FGamepadKeyNames::Type Pov3;
-	static const FGamepadKeyNames::Type Pov4;
-};
-
-struct FDirectInputKeys
-{
-	static const FKey Axis1;
-	static const FKey Axis2;
-	static const FKey Axis3;
-	static const FKey Axis4;
-	static const FKey Axis5;
-	static const FKey Axis6;
-	static const FKey Axis7;
-	static const FKey Axis8;
-
-	static const FKey Button1;
-	static const FKey Button2;
-	static const FKey Button3;
-	static const FKey Button4;
-	static const FKey Button5;
-	static const FKey Button6;
-	static const FKey Button7;
-	static const FKey Button8;
-	static const FKey Button9;
-	static const FKey Button10;
-	static const FKey Button11;
-	static const FKey Button12;
-	static const FKey Button13;
-	static const FKey Button14;
-	static const FKey Button15;
-	static const FKey Button16;
-	static const FKey Button17;
-	static const FKey Button18;
-	static const FKey Button19;
-	static const FKey Button20;
-	static const FKey Button21;
-	static const FKey Button22;
-	static const FKey Button23;
-	static const FKey Button24;
-	static const FKey Button25;
-	static const FKey Button26;
-	static const FKey Button27;
-	static const FKey Button28;
-	static const FKey Button29;
-	static const FKey Button30;
-	static const FKey Button31;
-	static const FKey Button32;
-	static const FKey Button33;
-	static const FKey Button34;
-	static const FKey Button35;
-	static const FKey Button36;
-	static const FKey Button37;
-	static const FKey Button38;
-	static const FKey Button39;
-	static const FKey Button40;
-	static const FKey Button41;
-	static const FKey Button42;
-	static const FKey Button43;
-	static const FKey Button44;
-	static const FKey Button45;
-	static const FKey Button46;
-	static const FKey Button47;
-	static const FKey Button48;
-	static const FKey Button49;
-	static const FKey Button50;
-	static const FKey Button51;
-	static const FKey Button52;
-	static const FKey Button53;
-	static const FKey Button54;
-	static const FKey Button55;
-	static const FKey Button56;
-	static const FKey Button57;
-	static const FKey Button58;
-	static const FKey Button59;
-	static const FKey Button60;
-	static const FKey Button61;
-	static const FKey Button62;
-	static const FKey Button63;
-	static const FKey Button64;
-	static const FKey Button65;
-	static const FKey Button66;
-	static const FKey Button67;
-	static const FKey Button68;
-	static const FKey Button69;
-	static const FKey Button70;
-	static const FKey Button71;
-	static const FKey Button72;
-	static const FKey Button73;
-	static const FKey Button74;
-	static const FKey Button75;
-	static const FKey Button76;
-	static const FKey Button77;
-	static const FKey Button78;
-	static const FKey Button79;
-	static const FKey Button80;
-	static const FKey Button81;
-	static const FKey Button82;
-	static const FKey Button83;
-	static const FKey Button84;
-	static const FKey Button85;
-	static const FKey Button86;
-	static const FKey Button87;
-	static const FKey Button88;
-	static const FKey Button89;
-	static const FKey Button90;
-	static const FKey Button91;
-	static const FKey Button92;
-	static const FKey Button93;
-	static const FKey Button94;
-	static const FKey Button95;
-	static const FKey Button96;
-	static const FKey Button97;
-	static const FKey Button98;
-	static const FKey Button99;
-	static const FKey Button100;
-	static const FKey Button101;
-	static const FKey Button102;
-	static const FKey Button103;
-	static const FKey Button104;
-	static const FKey Button105;
-	static const FKey Button106;
-	static const FKey Button107;
-	static const FKey Button108;
-	static const FKey Button109;
-	static const FKey Button110;
-	static const FKey Button111;
-	static const FKey Button112;
-	static const FKey Button113;
-	static const FKey Button114;
-	static const FKey Button115;
-	static const FKey Button116;
-	static const FKey Button117;
-	static const FKey Button118;
-	static const FKey Button119;
-	static const FKey Button120;
-	static const FKey Button121;
-	static const FKey Button122;
-	static const FKey Button123;
-	static const FKey Button124;
-	static const FKey Button125;
-	static const FKey Button126;
-	static const FKey Button127;
-	static const FKey Button128;
-
-	static const FKey Pov1;
-	static const FKey Pov2;
-	static const FKey Pov3;
-	static const FKey Pov4;
-};
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "InputCoreTypes.h"
+
+// Keys of the previous release, before the key names were generated, calling Key(Name) for each of them. Their names
+// are the same as those of the shared keys so FDirectInputKeys::Axis1 equals FKey(FDirectInputKeys::Shared.Axes[0]).
+#define DIRECTINPUT_LEGACY_KEYS(Key) \
+	Key(Axis1) Key(Axis2) Key(Axis3) Key(Axis4) Key(Axis5) Key(Axis6) Key(Axis7) Key(Axis8) \
+	Key(Button1) Key(Button2) Key(Button3) Key(Button4) Key(Button5) Key(Button6) Key(Button7) Key(Button8) \
+	Key(Button9) Key(Button10) Key(Button11) Key(Button12) Key(Button13) Key(Button14) Key(Button15) Key(Button16) \
+	Key(Button17) Key(Button18) Key(Button19) Key(Button20) Key(Button21) Key(Button22) Key(Button23) Key(Button24) \
+	Key(Button25) Key(Button26) Key(Button27) Key(Button28) Key(Button29) Key(Button30) Key(Button31) Key(Button32) \
+	Key(Button33) Key(Button34) Key(Button35) Key(Button36) Key(Button37) Key(Button38) Key(Button39) Key(Button40) \
+	Key(Button41) Key(Button42) Key(Button43) Key(Button44) Key(Button45) Key(Button46) Key(Button47) Key(Button48) \
+	Key(Button49) Key(Button50) Key(Button51) Key(Button52) Key(Button53) Key(Button54) Key(Button55) Key(Button56) \
+	Key(Button57) Key(Button58) Key(Button59) Key(Button60) Key(Button61) Key(Button62) Key(Button63) Key(Button64) \
+	Key(Button65) Key(Button66) Key(Button67) Key(Button68) Key(Button69) Key(Button70) Key(Button71) Key(Button72) \
+	Key(Button73) Key(Button74) Key(Button75) Key(Button76) Key(Button77) Key(Button78) Key(Button79) Key(Button80) \
+	Key(Button81) Key(Button82) Key(Button83) Key(Button84) Key(Button85) Key(Button86) Key(Button87) Key(Button88) \
+	Key(Button89) Key(Button90) Key(Button91) Key(Button92) Key(Button93) Key(Button94) Key(Button95) Key(Button96) \
+	Key(Button97) Key(Button98) Key(Button99) Key(Button100) Key(Button101) Key(Button102) Key(Button103) Key(Button104) \
+	Key(Button105) Key(Button106) Key(Button107) Key(Button108) Key(Button109) Key(Button110) Key(Button111) Key(Button112) \
+	Key(Button113) Key(Button114) Key(Button115) Key(Button116) Key(Button117) Key(Button118) Key(Button119) Key(Button120) \
+	Key(Button121) Key(Button122) Key(Button123) Key(Button124) Key(Button125) Key(Button126) Key(Button127) Key(Button128) \
+	Key(Pov1) Key(Pov2) Key(Pov3) Key(Pov4)
+
+#define DIRECTINPUT_DEPRECATED_KEY_NAME(Name) \
+	UE_DEPRECATED(1.0, "Use the generated names in FDirectInputKeys::Shared instead.") \
+	static const FGamepadKeyNames::Type Name;
+
+#define DIRECTINPUT_DEPRECATED_KEY(Name) \
+	UE_DEPRECATED(1.0, "Use FKey with the generated names in FDirectInputKeys::Shared instead.") \
+	static const FKey Name;
+
+// Key names for every object a device can have, generated by Generate and indexed by the object's index on the device.
+struct FDirectInputKeySet
+{
+	static constexpr uint32 NumAxes = 8;
+	static constexpr uint32 NumButtons = 128;
+	static constexpr uint32 NumPovs = 4;
+	static constexpr uint32 NumPovDirections = 8;
+
+	FName Axes[NumAxes];
+	FName Buttons[NumButtons];
+	FName Povs[NumPovs];
+	FName PovX[NumPovs];
+	FName PovY[NumPovs];
+	FName PovDirections[NumPovs * NumPovDirections];
+
+	// Namespace goes between DirectInput_ and the object in the key names, DisplayPrefix before the object in the
+	// display names. Both are empty for the shared keys.
+	void Generate(const FString& Namespace, const FText& InDisplayPrefix, FName InCategory);
+
+	// Register the keys of the first InNumAxes axes, InNumButtons buttons and InNumPovs POVs, keys that are already
+	// registered are skipped so this can be called again as devices with more objects show up.
+	void Register(uint32 InNumAxes, uint32 InNumButtons, uint32 InNumPovs);
+
+private:
+	FText DisplayPrefix;
+	FName Category;
+	uint32 NumRegisteredAxes = 0;
+	uint32 NumRegisteredButtons = 0;
+	uint32 NumRegisteredPovs = 0;
+};
+
+// Deprecated, will be removed in the next release
+struct FDirectInputKeyNames
+{
+	DIRECTINPUT_LEGACY_KEYS(DIRECTINPUT_DEPRECATED_KEY_NAME)
+};
+
+// Keys shared by every device and separated by controller id, the keys of the combined device, and in per-device mode a
+// set of keys for each device slot, DirectInput_Dev<Slot>_Axis1 and so on.
+struct FDirectInputKeys
+{
+	static constexpr uint32 NumAxes = FDirectInputKeySet::NumAxes;
+	static constexpr uint32 NumButtons = FDirectInputKeySet::NumButtons;
+	static constexpr uint32 NumPovs = FDirectInputKeySet::NumPovs;
+	static constexpr uint32 NumPovDirections = FDirectInputKeySet::NumPovDirections;
+
+	static FDirectInputKeySet Shared;
+
+	// Deprecated, will be removed in the next release
+	DIRECTINPUT_LEGACY_KEYS(DIRECTINPUT_DEPRECATED_KEY)
+
+	// Keys of the combined device
+	static FName CombinedAxes[NumAxes];
+	static FName CombinedButtons[NumButtons];
+	static FName CombinedPovs[NumPovs];
+
+	static void Initialize();
+
+	static void RegisterKeys(uint32 InNumAxes, uint32 InNumButtons, uint32 InNumPovs) { Shared.Register(InNumAxes, InNumButtons, InNumPovs); }
+	static void RegisterCombinedKeys(uint32 InNumAxes, uint32 InNumButtons, uint32 InNumPovs);
+
+	// Slot of a device instance, from 1, kept in the [DirectInput.KeySlots] section of the input config so a device
+	// has the same keys from one run to the next. A device seen for the first time gets the lowest free slot.
+	static uint32 GetDeviceSlot(const FGuid& InstanceGuid);
+	// Keys of a slot, generated the first time and registered for as many objects as its devices have
+	static const FDirectInputKeySet& RegisterDeviceKeys(uint32 Slot, const FString& DeviceName, uint32 InNumAxes, uint32 InNumButtons, uint32 InNumPovs);
+
+private:
+	static TMap<uint32, TUniquePtr<FDirectInputKeySet>> DeviceKeys;
+
+	static uint32 NumRegisteredCombinedAxes;
+	static uint32 NumRegisteredCombinedButtons;
+	static uint32 NumRegisteredCombinedPovs;
+};
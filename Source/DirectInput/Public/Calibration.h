@@ -0,0 +1,60 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Raw extents of an axis used to normalise it to -1..1, each side of the centre is scaled separately
+struct FAxisCalibration
+{
+	int32 Min;
+	int32 Center;
+	int32 Max;
+	bool bInvert;
+
+	float Normalize(int32 Value) const;
+};
+
+struct FCalibrationProfile
+{
+	static constexpr uint32 MaxAxes = 8;
+
+	uint32 NumAxes;
+	FAxisCalibration Axes[MaxAxes];
+};
+
+// Calibration profiles keyed by product GUID, stored in a small binary file
+class FCalibrationStore
+{
+public:
+	bool Load(const FString& Filename);
+	bool Save(const FString& Filename) const;
+
+	const FCalibrationProfile* Find(const FGuid& Product) const { return Profiles.Find(Product); }
+	void Set(const FGuid& Product, const FCalibrationProfile& Profile) { Profiles.Add(Product, Profile); }
+	void Remove(const FGuid& Product) { Profiles.Remove(Product); }
+
+	int32 Num() const { return Profiles.Num(); }
+
+private:
+	TMap<FGuid, FCalibrationProfile> Profiles;
+};
@@ -0,0 +1,86 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "Joystick.h"
+
+// One logical controller built from objects of several physical devices, such as the wheel, pedals and shifter of a
+// rig. Each object is taken from the first device with the configured product, and the merged state is kept in two
+// slots like FJoystick so changes are found by comparing them.
+class FCombinedDevice
+{
+public:
+	FCombinedDevice();
+	~FCombinedDevice() = default;
+
+	// Read the mappings from the [DirectInput] section of the input config:
+	// +CombinedAxis=<ProductGuid>,<SourceAxis>,<TargetAxis> and likewise CombinedButton and CombinedPov
+	void LoadConfig();
+	bool IsEnabled() const { return NumAxes > 0 || NumButtons > 0 || NumPovs > 0; }
+
+	// Resolve the product of each mapping to a device, call again when devices have been added
+	void Bind(const FJoystickArray& Devices);
+
+	// Merge the current state of the bound devices, returns true if the combined state changed
+	bool Merge(const FJoystickArray& Devices);
+
+	uint32 GetNumAxes() const { return NumAxes; }
+	uint32 GetNumButtons() const { return NumButtons; }
+	uint32 GetNumPovs() const { return NumPovs; }
+
+	int32 GetAxisValue(uint32 Axis) const { return States[StateIndex].Axes[Axis]; }
+	int32 GetButtonValue(uint32 Button) const { return (States[StateIndex].Buttons[Button / 32] >> (Button % 32)) & 1; }
+	int32 GetPovValue(uint32 Pov) const { return static_cast<int32>(States[StateIndex].Povs[Pov]); }
+
+	bool IsAxisChanged(uint32 Axis) const { return States[0].Axes[Axis] != States[1].Axes[Axis]; }
+	bool IsButtonChanged(uint32 Button) const { return ((States[0].Buttons[Button / 32] ^ States[1].Buttons[Button / 32]) >> (Button % 32)) & 1; }
+	bool IsPovChanged(uint32 Pov) const { return States[0].Povs[Pov] != States[1].Povs[Pov]; }
+
+private:
+	struct FMapping
+	{
+		FGuid Product;
+		uint32 Source;
+		uint32 Target;
+		int32 DeviceIndex;
+	};
+
+	struct FState
+	{
+		int32 Axes[FJoystick::MaxAxes];
+		uint32 Buttons[FJoystick::MaxButtons / 32];
+		uint32 Povs[FJoystick::MaxPovs];
+	};
+
+	static void LoadMappings(const TCHAR* Key, uint32 MaxTarget, TArray<FMapping>& OutMappings, uint32& OutCount);
+
+	TArray<FMapping> AxisMappings;
+	TArray<FMapping> ButtonMappings;
+	TArray<FMapping> PovMappings;
+
+	uint32 NumAxes;
+	uint32 NumButtons;
+	uint32 NumPovs;
+
+	FState States[2];
+	uint32 StateIndex;
+};
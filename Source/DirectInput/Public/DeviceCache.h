@@ -0,0 +1,91 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// What an axis is to DirectInput, in the order of the DIJOYSTATE members that have always given the axes their indices
+enum class EDeviceAxis : uint8
+{
+	X,
+	Y,
+	Z,
+	RX,
+	RY,
+	RZ,
+	Slider,
+	Unknown
+};
+
+// What the plugin needs to know about an axis, POV or button, copied out of DirectInput's object enumeration
+struct FDeviceObject
+{
+	uint32 Type = 0;
+	EDeviceAxis Axis = EDeviceAxis::Unknown;
+	uint32 Flags = 0;
+	uint16 UsagePage = 0;
+	uint16 Usage = 0;
+	uint32 MaxForce = 0;
+	uint32 ForceResolution = 0;
+	int32 RangeMin = 0;
+	int32 RangeMax = 65535;
+	FString Name;
+};
+
+// Index of each axis among Objects as numbered by DIJOYSTATE, X, Y, Z, Rx, Ry, Rz and two sliders, so an axis keeps its
+// index whatever order the device enumerates its objects in. Axes without a DIJOYSTATE member, and sliders past the
+// second, take the free indices in enumeration order. OutIndices follows Objects, with INDEX_NONE for everything that
+// isn't an axis or didn't fit. Returns one past the highest index used.
+uint32 GetAxisIndices(const TArray<FDeviceObject>& Objects, uint32 MaxAxes, TArray<int32>& OutIndices);
+
+struct FDeviceCacheKey
+{
+	FDeviceCacheKey() = default;
+	FDeviceCacheKey(const FGuid& InProduct, uint32 InFirmwareRevision, uint32 InHardwareRevision);
+
+	FGuid Product;
+	uint32 FirmwareRevision = 0;
+	uint32 HardwareRevision = 0;
+
+	bool operator==(const FDeviceCacheKey& Other) const;
+	friend uint32 GetTypeHash(const FDeviceCacheKey& Key);
+};
+
+// Objects of previously seen devices keyed by product and revision, so known devices can skip enumerating them
+class FDeviceCache
+{
+public:
+	bool Load(const FString& Filename);
+	bool Save(const FString& Filename);
+
+	const TArray<FDeviceObject>* Find(const FDeviceCacheKey& Key) const { return Entries.Find(Key); }
+	void Set(const FDeviceCacheKey& Key, const TArray<FDeviceObject>& Objects);
+
+	bool IsDirty() const { return bDirty; }
+
+	// Highest number of axes, buttons and POVs of any cached device
+	void GetMaxObjectCounts(uint32& OutNumAxes, uint32& OutNumButtons, uint32& OutNumPovs) const;
+
+private:
+	TMap<FDeviceCacheKey, TArray<FDeviceObject>> Entries;
+	bool bDirty = false;
+};
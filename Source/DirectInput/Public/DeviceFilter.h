@@ -0,0 +1,66 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// What enumeration tells about a device before it is created
+struct FDeviceDescription
+{
+	// DI8DEVTYPE_* and the subtype within it
+	uint8 Type;
+	uint8 SubType;
+	uint16 VendorId;
+	uint16 ProductId;
+	FGuid Product;
+	FString Name;
+};
+
+// A device matches a rule when it matches every field the rule sets
+struct FDeviceRule
+{
+	TOptional<uint8> Type;
+	TOptional<uint8> SubType;
+	TOptional<uint16> VendorId;
+	TOptional<uint16> ProductId;
+	TOptional<FGuid> Product;
+
+	bool Matches(const FDeviceDescription& Device) const;
+};
+
+// Which devices are created at all, read from the [DirectInput] section of the input config with one or more of
+// Type=<Name|Number>, SubType=<Number>, Vid=<Hex>, Pid=<Hex> and Product=<Guid> separated by spaces:
+// +IncludeDevice=Type=Driving
+// +ExcludeDevice=Vid=0x046D Pid=0xC262
+// A device is created if it matches an include rule and no exclude rule. Without include rules, driving and flight
+// devices are included.
+class FDeviceFilter
+{
+public:
+	void LoadConfig();
+
+	bool IsIncluded(const FDeviceDescription& Device) const;
+
+private:
+	TArray<FDeviceRule> Includes;
+	TArray<FDeviceRule> Excludes;
+};
@@ -1,58 +1,126 @@
-/* 
- * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
- * 
- * Permission is hereby granted, free of charge, to any person obtaining a copy of 
- * this software and associated documentation files (the "Software"), to deal in the 
- * Software without restriction, including without limitation the rights to use, copy, 
- * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
- * and to permit persons to whom the Software is furnished to do so, subject to the 
- * following conditions:
- *
- * The above copyright notice and this permission notice shall be included in all 
- * copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
- * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
- * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
- * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
- * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
- * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
-*/
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "InputDevice/Public/IInputDevice.h"
-#include "InputDevice/Public/IInputDeviceModule.h"
-
-class IDInputDevice : public IInputDevice
-{
-public:
-	IDInputDevice(const TSharedRef<FGenericApplicationMessageHandler> &InMessageHandler);
-	virtual ~IDInputDevice() override {};
-	
-protected:
-	TSharedRef<FGenericApplicationMessageHandler> MessageHandler;
-};
-
-class FDirectInputModule : public IInputDeviceModule
-{
-	virtual TSharedPtr<class IInputDevice> CreateInputDevice(const TSharedRef<FGenericApplicationMessageHandler> &InMessageHandler) override;
-	TSharedPtr<class IDInputDevice> DirectInputDevice;
-	
-public:
-	TSharedPtr<class IDInputDevice>& GetDirectInputDevice() { return DirectInputDevice; }
-	
-	virtual void StartupModule() override;
-	virtual void ShutdownModule() override;
-
-	static inline FDirectInputModule& Get()
-	{
-		return FModuleManager::LoadModuleChecked<FDirectInputModule>("DirectInput");
-	}
-
-	static inline bool IsAvailable()
-	{
-		return FModuleManager::Get().IsModuleLoaded("DirectInput");
-	}
-};
+/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InputDevice/Public/IInputDevice.h"
+#include "InputDevice/Public/IInputDeviceModule.h"
+#include "AxisFilter.h"
+#include "Calibration.h"
+#include "DeviceCache.h"
+#include "DeviceFilter.h"
+#include "ForceConditions.h"
+#include "Remap.h"
+#include "StateSnapshot.h"
+
+class FForceStream;
+class UForceEffect;
+class FInputHistory;
+
+DECLARE_STATS_GROUP(TEXT("DirectInput"), STATGROUP_DirectInput, STATCAT_Advanced);
+
+// Force for a controller in the units of SetChannelValue (-10000..10000), called on the force feedback thread every tick
+using FForceFeedbackCallback = TFunction<float(int32 ControllerId, double Time)>;
+
+class IDInputDevice : public IInputDevice
+{
+public:
+	IDInputDevice(const TSharedRef<FGenericApplicationMessageHandler> &InMessageHandler);
+	virtual ~IDInputDevice() override {};
+
+	/** Sample history of a controller, nullptr if it doesn't exist or history is disabled. The history itself can be read from any thread. */
+	virtual TSharedPtr<const FInputHistory, ESPMode::ThreadSafe> GetHistory(int32 ControllerId) const = 0;
+
+	/** Force for a controller to be sent on the next tick of the force feedback thread, can be called from any thread. Only used when ForceFeedbackRate is set. */
+	virtual void SetForceFeedbackTarget(int32 ControllerId, float Magnitude) = 0;
+	/** Ask Callback for the force of every controller on each tick of the force feedback thread instead of using the targets, an unset callback goes back to the targets. Game thread only. */
+	virtual void SetForceFeedbackCallback(FForceFeedbackCallback Callback) = 0;
+	/** Spring, damper, friction and inertia on a controller, played by the device where it can and synthesised from the polled position where it can't. Game thread only. */
+	virtual void SetForceConditions(int32 ControllerId, const FForceConditions& Conditions) = 0;
+	/** Start streaming a waveform to a controller at SampleRate samples per second, uploaded every frame. Samples are pushed to the returned stream from one generator thread at a time and it lives as long as the controller. nullptr if the controller can't play it or streams at another rate. Game thread only. */
+	virtual FForceStream* EnableForceStream(int32 ControllerId, uint32 SampleRate) = 0;
+	/** Create the effects of an asset on every device that can play them, so the first play doesn't have to. Game thread only. */
+	virtual void PreloadForceEffect(const UForceEffect& Effect) = 0;
+	/** Start the effects of an asset on a controller, created on the first play unless preloaded. Iterations of 0 plays until stopped. Game thread only. */
+	virtual bool PlayForceEffect(int32 ControllerId, const UForceEffect& Effect, uint32 Iterations = 1) = 0;
+	virtual bool StopForceEffect(int32 ControllerId, const UForceEffect& Effect) = 0;
+	/** Release the effects created for an asset id on every device, done by the asset when it is destroyed or reimported. Game thread only. */
+	virtual void UnloadForceEffect(const FGuid& Id) = 0;
+
+	TSharedRef<FGenericApplicationMessageHandler> GetMessageHandler() const { return MessageHandler; }
+	
+protected:
+	TSharedRef<FGenericApplicationMessageHandler> MessageHandler;
+};
+
+class FDirectInputModule : public IInputDeviceModule
+{
+	virtual TSharedPtr<class IInputDevice> CreateInputDevice(const TSharedRef<FGenericApplicationMessageHandler> &InMessageHandler) override;
+	TSharedPtr<class IDInputDevice> DirectInputDevice;
+	TUniquePtr<FStateSnapshot[]> Snapshots;
+	FCalibrationStore Calibration;
+	FDeviceCache DeviceCache;
+	FRemapStore Remaps;
+	FAxisFilterStore Filters;
+	FDeviceFilter DeviceFilter;
+	
+public:
+	TSharedPtr<class IDInputDevice>& GetDirectInputDevice() { return DirectInputDevice; }
+	
+	virtual void StartupModule() override;
+	virtual void ShutdownModule() override;
+
+	static constexpr int32 MaxControllers = 16;
+
+	/** Copy the latest state of a controller, can be called from any thread. Returns false if the controller hasn't published a state, or in the unlikely case that the read kept racing the publisher (see FStateSnapshot). */
+	DIRECTINPUT_API bool GetState(int32 ControllerId, FDirectInputState& OutState) const;
+	FStateSnapshot* GetSnapshot(int32 ControllerId) const;
+
+	/** Calibration profiles loaded at startup, applied to devices as they are found */
+	FCalibrationStore& GetCalibration() { return Calibration; }
+	bool SaveCalibration() const;
+	static FString GetCalibrationFilename();
+
+	/** Objects of known devices, saved whenever new devices have been added */
+	FDeviceCache& GetDeviceCache() { return DeviceCache; }
+	bool SaveDeviceCache();
+	static FString GetDeviceCacheFilename();
+
+	/** Remap rules read from the input config, compiled into each device as it is found */
+	const FRemapStore& GetRemaps() const { return Remaps; }
+
+	/** Axis filters read from the input config, applied to devices as they are found */
+	const FAxisFilterStore& GetFilters() const { return Filters; }
+
+	/** Include and exclude rules read from the input config, checked before a device is created */
+	const FDeviceFilter& GetDeviceFilter() const { return DeviceFilter; }
+
+	static inline FDirectInputModule& Get()
+	{
+		return FModuleManager::LoadModuleChecked<FDirectInputModule>("DirectInput");
+	}
+
+	static inline bool IsAvailable()
+	{
+		return FModuleManager::Get().IsModuleLoaded("DirectInput");
+	}
+};
@@ -1,51 +1,100 @@
-﻿/* 
- * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
- * 
- * Permission is hereby granted, free of charge, to any person obtaining a copy of 
- * this software and associated documentation files (the "Software"), to deal in the 
- * Software without restriction, including without limitation the rights to use, copy, 
- * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
- * and to permit persons to whom the Software is furnished to do so, subject to the 
- * following conditions:
- *
- * The above copyright notice and this permission notice shall be included in all 
- * copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
- * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
- * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
- * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
- * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
- * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
-*/
-
-#pragma once
-
-#include "DirectInput.h"
-
-class FDirectInputDevice : public IDInputDevice
-{
-public:
-	FDirectInputDevice(const TSharedRef<FGenericApplicationMessageHandler> &InMessageHandler);
-	virtual ~FDirectInputDevice() override;
-	/** Tick the interface (e.g. check for new controllers) */
-	virtual void Tick(float DeltaTime) override;
-	/** Poll for controller state and send events if needed */
-	virtual void SendControllerEvents() override;
-	/** Set which MessageHandler will get the events from SendControllerEvents. */
-	virtual void SetMessageHandler(const TSharedRef<FGenericApplicationMessageHandler> &InMessageHandler) override;
-	/** Exec handler to allow console commands to be passed through for debugging */
-	virtual bool Exec(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar) override;
-	// IForceFeedbackSystem pass through functions
-	virtual void SetChannelValue(int32 ControllerId, FForceFeedbackChannelType ChannelType, float Value) override;
-	virtual void SetChannelValues(int32 ControllerId, const FForceFeedbackValues &Values) override;
-	
-	TArray<FName> AxisNames;
-	TArray<FName> ButtonNames;
-	TArray<FName> PovNames;
-
-	FName DirectInputInterfaceName;
-
-private:
-	float TimeSinceLastCheck;
-};
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "DirectInput.h"
+#include "PollScheduler.h"
+
+class FCombinedDevice;
+class FDirectInputSoakTest;
+class FForceFeedbackThread;
+class FTelemetryPublisher;
+
+class FDirectInputDevice : public IDInputDevice
+{
+public:
+	FDirectInputDevice(const TSharedRef<FGenericApplicationMessageHandler> &InMessageHandler);
+	virtual ~FDirectInputDevice() override;
+	/** Tick the interface (e.g. check for new controllers) */
+	virtual void Tick(float DeltaTime) override;
+	/** Poll for controller state and send events if needed */
+	virtual void SendControllerEvents() override;
+	/** Poll every device and send its events, also in the editor, used by SendControllerEvents and the benchmarks */
+	void SendDeviceEvents();
+	/** Set which MessageHandler will get the events from SendControllerEvents. */
+	virtual void SetMessageHandler(const TSharedRef<FGenericApplicationMessageHandler> &InMessageHandler) override;
+	/** Exec handler to allow console commands to be passed through for debugging */
+	virtual bool Exec(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar) override;
+	// IForceFeedbackSystem pass through functions
+	virtual void SetChannelValue(int32 ControllerId, FForceFeedbackChannelType ChannelType, float Value) override;
+	virtual void SetChannelValues(int32 ControllerId, const FForceFeedbackValues &Values) override;
+	// IDInputDevice
+	virtual TSharedPtr<const FInputHistory, ESPMode::ThreadSafe> GetHistory(int32 ControllerId) const override;
+	virtual void SetForceFeedbackTarget(int32 ControllerId, float Magnitude) override;
+	virtual void SetForceFeedbackCallback(FForceFeedbackCallback Callback) override;
+	virtual void SetForceConditions(int32 ControllerId, const FForceConditions& Conditions) override;
+	virtual FForceStream* EnableForceStream(int32 ControllerId, uint32 SampleRate) override;
+	virtual void PreloadForceEffect(const UForceEffect& Effect) override;
+	virtual bool PlayForceEffect(int32 ControllerId, const UForceEffect& Effect, uint32 Iterations) override;
+	virtual bool StopForceEffect(int32 ControllerId, const UForceEffect& Effect) override;
+	virtual void UnloadForceEffect(const FGuid& Id) override;
+
+	uint32 GetHistoryCapacity() const { return HistoryCapacity; }
+	float GetDeadZone() const { return DeadZone; }
+	bool IsPerDeviceKeys() const { return bPerDeviceKeys; }
+	FTelemetryPublisher* GetTelemetry() const { return Telemetry.Get(); }
+	const FPollScheduler& GetScheduler() const { return Scheduler; }
+	bool IsSoakRunning() const { return Soak.IsValid(); }
+
+	uint32 GetForceFeedbackRate() const { return ForceFeedbackRate; }
+	// Stops the force feedback thread until resumed, so a test can drive simulated devices with a thread of its own
+	void SuspendForceFeedback();
+	void ResumeForceFeedback();
+	
+	FName DirectInputInterfaceName;
+
+private:
+	void SendCombinedEvents();
+
+	float TimeSinceLastCheck;
+	uint32 HistoryCapacity;
+	float DeadZone;
+
+	// Each device sends keys of its own, DirectInput_Dev<Slot>_..., instead of the shared keys
+	bool bPerDeviceKeys;
+
+	TUniquePtr<FCombinedDevice> Combined;
+	int32 CombinedControllerId;
+
+	TUniquePtr<FTelemetryPublisher> Telemetry;
+
+	FPollScheduler Scheduler;
+
+	// Pushes forces at ForceFeedbackRate on its own thread when set, SetChannelValue only sets its targets then
+	TUniquePtr<FForceFeedbackThread> ForceFeedback;
+	uint32 ForceFeedbackRate;
+	FForceFeedbackCallback ForceFeedbackCallback;
+	bool bForceFeedbackSuspended;
+
+	// Set while DINPUT SOAK runs, its Tick polls the simulated devices in place of SendControllerEvents
+	TUniquePtr<FDirectInputSoakTest> Soak;
+};
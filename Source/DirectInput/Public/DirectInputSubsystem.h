@@ -0,0 +1,101 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "StateSnapshot.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Tickable.h"
+#include "DirectInput.h"
+#include "DirectInputSubsystem.generated.h"
+
+// Latest polled state of every controller for systems that would rather ask than listen to input events. The states
+// are copied from the snapshots once per frame, queries read the copies and never allocate. Controllers beyond
+// FDirectInputModule::MaxControllers don't publish a state and read as disconnected.
+UCLASS()
+class DIRECTINPUT_API UDirectInputSubsystem : public UGameInstanceSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override { return bInitialized; }
+	virtual bool IsTickableWhenPaused() const override { return true; }
+	virtual TStatId GetStatId() const override;
+
+	// True once the controller has published a state
+	UFUNCTION(BlueprintPure, Category = "DirectInput")
+	bool IsConnected(int32 ControllerId) const;
+
+	// Normalised to -1..1, 0 for a missing controller or axis
+	UFUNCTION(BlueprintPure, Category = "DirectInput")
+	float GetAxis(int32 ControllerId, int32 Axis) const;
+
+	UFUNCTION(BlueprintPure, Category = "DirectInput")
+	bool GetButton(int32 ControllerId, int32 Button) const;
+
+	// Hundredths of degrees clockwise from north, -1 when centred
+	UFUNCTION(BlueprintPure, Category = "DirectInput")
+	int32 GetPov(int32 ControllerId, int32 Pov) const;
+
+	// Edges between the states of the previous and this frame
+	UFUNCTION(BlueprintPure, Category = "DirectInput")
+	bool WasPressedThisFrame(int32 ControllerId, int32 Button) const;
+
+	UFUNCTION(BlueprintPure, Category = "DirectInput")
+	bool WasReleasedThisFrame(int32 ControllerId, int32 Button) const;
+
+	// Every axis of the controller, empty for a missing controller. Valid until the next frame.
+	TArrayView<const float> GetAllAxes(int32 ControllerId) const;
+
+	// Reuses the memory of OutAxes, so passing the same array every frame doesn't allocate
+	UFUNCTION(BlueprintCallable, Category = "DirectInput", meta = (DisplayName = "Get All Axes"))
+	void K2_GetAllAxes(int32 ControllerId, TArray<float>& OutAxes) const;
+
+	// Start an imported effect on a controller, Iterations of 0 plays until stopped
+	UFUNCTION(BlueprintCallable, Category = "DirectInput")
+	bool PlayForceEffect(int32 ControllerId, UForceEffect* Effect, int32 Iterations = 1);
+
+	UFUNCTION(BlueprintCallable, Category = "DirectInput")
+	bool StopForceEffect(int32 ControllerId, UForceEffect* Effect);
+
+	// Create the effects on every device now instead of on their first play
+	UFUNCTION(BlueprintCallable, Category = "DirectInput")
+	void PreloadForceEffect(UForceEffect* Effect);
+
+private:
+	const FDirectInputState* GetCurrent(int32 ControllerId) const;
+	const FDirectInputState* GetPrevious(int32 ControllerId) const;
+
+	static constexpr int32 MaxControllers = FDirectInputModule::MaxControllers;
+
+	// Two frames of states, Current selects this frame's
+	FDirectInputState States[2][MaxControllers];
+	bool bConnected[2][MaxControllers];
+	uint32 Current = 0;
+
+	bool bInitialized = false;
+};
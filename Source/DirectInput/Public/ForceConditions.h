@@ -0,0 +1,86 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Condition effects on the force feedback axis. Forces are fractions of the device's full force and positions are the
+// normalised axis, -1..1.
+struct FForceConditions
+{
+	// Pulls towards Center with Spring of full force at full deflection from the centre
+	float Center = 0.0f;
+	float Spring = 0.0f;
+	// Opposes speed with Damper of full force at a normalised unit per second
+	float Damper = 0.0f;
+	// Opposes any movement with a constant force
+	float Friction = 0.0f;
+	// Opposes acceleration with Inertia of full force at a normalised unit per second squared
+	float Inertia = 0.0f;
+	// Most force the conditions add together
+	float Saturation = 1.0f;
+
+	bool IsActive() const { return Spring != 0.0f || Damper != 0.0f || Friction != 0.0f || Inertia != 0.0f; }
+};
+
+enum class EForceCondition : uint8
+{
+	Spring,
+	Damper,
+	Friction,
+	Inertia,
+	Count,
+};
+
+// Computes the conditions a device can't play itself from the polled position and its derivatives, to be added to the
+// constant force. A handful of operations per update, cheap enough for any poll rate.
+class FConditionSynthesizer
+{
+public:
+	void SetConditions(const FForceConditions& InConditions, uint32 InHardwareMask);
+	bool IsActive() const { return bActive; }
+
+	// Force in the units of the constant force (-10000..10000) for the position at Time
+	float Update(float Position, double Time);
+	float GetForce() const { return Force; }
+
+	// DI_FFNOMINALMAX, the full force of a device
+	static constexpr float FullForce = 10000.0f;
+
+	// Movement slower than this many ranges per second fades the friction out so it doesn't chatter at rest
+	static constexpr float FrictionSpeed = 0.05f;
+	// Weight of the newest sample in the smoothed speed and acceleration, differences of polled positions are noisy
+	static constexpr float Smoothing = 0.5f;
+
+private:
+	FForceConditions Conditions;
+	// Conditions the device plays itself, left out here
+	uint32 HardwareMask = 0;
+	bool bActive = false;
+
+	bool bHasSample = false;
+	float LastPosition = 0.0f;
+	double LastTime = 0.0;
+	float Velocity = 0.0f;
+	float Acceleration = 0.0f;
+	float Force = 0.0f;
+};
@@ -0,0 +1,93 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "ForceEffect.generated.h"
+
+// One effect of an effect file, the parameters of a DIEFFECT without the pointers. Axes are indices in the order of
+// DIJOYSTATE (X, Y, Z, Rx, Ry, Rz and the sliders), which is also where the data format of a device puts its axes.
+struct FForceEffectData
+{
+	FGuid Type;
+	FString Name;
+
+	uint32 Flags = 0;
+	uint32 Duration = 0;
+	uint32 SamplePeriod = 0;
+	uint32 Gain = 0;
+	uint32 TriggerButton = 0;
+	uint32 TriggerRepeatInterval = 0;
+	uint32 StartDelay = 0;
+
+	TArray<uint8> Axes;
+	TArray<int32> Direction;
+
+	bool bEnvelope = false;
+	uint32 AttackLevel = 0;
+	uint32 AttackTime = 0;
+	uint32 FadeLevel = 0;
+	uint32 FadeTime = 0;
+
+	// Type specific parameters as they are, except for custom forces whose samples are kept apart
+	TArray<uint8> Parameters;
+	TArray<int32> Samples;
+
+	friend FArchive& operator<<(FArchive& Ar, FForceEffectData& Data);
+};
+
+// Force feedback effects imported from an effect file. They are stored in a compact binary form, created on each
+// device the first time they are played or preloaded and started from then on without building any parameters.
+UCLASS(BlueprintType)
+class DIRECTINPUT_API UForceEffect : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Serialize(FArchive& Ar) override;
+	virtual void PostInitProperties() override;
+	virtual void BeginDestroy() override;
+
+	const TArray<FForceEffectData>& GetEffects() const { return Effects; }
+	void SetEffects(TArray<FForceEffectData>&& InEffects);
+
+	// Names the effects on the devices, a new one for every import so devices never play stale parameters
+	const FGuid& GetId() const { return Id; }
+
+#if WITH_EDITORONLY_DATA
+	UPROPERTY(VisibleAnywhere, Category = "DirectInput")
+	FString SourceFile;
+#endif
+
+	UPROPERTY(VisibleAnywhere, Category = "DirectInput")
+	int32 NumEffects = 0;
+
+private:
+	// Releases what the devices created for the current id
+	void Unload() const;
+
+	UPROPERTY()
+	FGuid Id;
+
+	TArray<FForceEffectData> Effects;
+};
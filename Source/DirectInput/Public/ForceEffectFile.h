@@ -0,0 +1,64 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "Windows/WindowsApplication.h"
+#include "ForceEffect.h"
+
+#define DIRECTINPUT_VERSION 0x0800
+#include <dinput.h>
+
+// Effect files as written by the Force Editor, read and written by DirectInput itself
+class DIRECTINPUT_API FForceEffectFile
+{
+public:
+	static bool Read(const FString& Filename, TArray<FForceEffectData>& OutEffects);
+	static bool Write(const FString& Filename, const TArray<FForceEffectData>& Effects);
+};
+
+// DIEFFECT built from effect data, pointing into storage of its own. The axes of the device and of DIJOYSTATE are both
+// laid out as one LONG each from offset 0, so an axis keeps its index. AxisMask has a bit for each index the device has
+// an axis at, the other axes of the effect are skipped. An effect left without axes is played on the lowest one.
+class FForceEffectConfig
+{
+public:
+	FForceEffectConfig(const FForceEffectData& Data, uint32 AxisMask);
+	FForceEffectConfig(const FForceEffectConfig&) = delete;
+	FForceEffectConfig& operator=(const FForceEffectConfig&) = delete;
+
+	const GUID& GetType() const { return Type; }
+	const DIEFFECT* GetEffect() const { return &Effect; }
+	DIEFFECT* GetEffect() { return &Effect; }
+	// Axes of the effect the device doesn't have
+	int32 GetNumSkippedAxes() const { return NumSkippedAxes; }
+
+private:
+	GUID Type;
+	DIEFFECT Effect;
+	DIENVELOPE Envelope;
+	DICUSTOMFORCE CustomForce;
+	TArray<DWORD, TInlineAllocator<8>> Axes;
+	TArray<LONG, TInlineAllocator<8>> Direction;
+	TArray<uint8, TInlineAllocator<32>> Parameters;
+	TArray<LONG> Samples;
+	int32 NumSkippedAxes = 0;
+};
@@ -0,0 +1,102 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "LatencyHistogram.h"
+#include "DirectInput.h"
+
+#include <atomic>
+
+class FRunnableThread;
+
+struct FForceFeedbackStats
+{
+	double Rate = 0.0;
+	uint64 NumTicks = 0;
+	uint64 NumUpdates = 0;
+
+	// Difference between each tick interval and the nominal one, in microseconds
+	double JitterMean = 0.0;
+	double JitterP99 = 0.0;
+	double JitterMax = 0.0;
+
+	// From a target being set to the effect being updated with it, in microseconds
+	double LatencyP50 = 0.0;
+	double LatencyP99 = 0.0;
+	double LatencyMax = 0.0;
+};
+
+// Pushes constant forces to the devices at a fixed rate on its own thread, so the torque isn't limited to one step per
+// frame. Each tick reads the latest target of every controller, written from any thread without locking, or asks the
+// callback for the force instead. Updates go through FJoystick::UpdateEffect, only when the force changed, which
+// takes the lock of the device so they don't overlap a poll or effect change on the game thread.
+class FForceFeedbackThread : public FRunnable
+{
+public:
+	static constexpr int32 MaxControllers = FDirectInputModule::MaxControllers;
+
+	FForceFeedbackThread(uint32 InRate, FForceFeedbackCallback InCallback);
+	virtual ~FForceFeedbackThread() override;
+
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+	// Can be called from any thread, picked up on the next tick
+	void SetTarget(int32 ControllerId, float Magnitude);
+	// Software conditions added to the target or the callback's force
+	void SetConditionForce(int32 ControllerId, float Magnitude);
+
+	uint32 GetRate() const { return Rate; }
+	// Over the last second
+	FForceFeedbackStats GetStats() const;
+
+private:
+	void Tick(double Now);
+	void PublishStats(double Elapsed);
+
+	const uint32 Rate;
+	const FForceFeedbackCallback Callback;
+
+	struct FTarget
+	{
+		std::atomic<float> Magnitude { 0.0f };
+		std::atomic<uint64> Cycles { 0 };
+		std::atomic<float> Condition { 0.0f };
+	};
+
+	FTarget Targets[MaxControllers];
+	float Sent[MaxControllers];
+	uint64 SentCycles[MaxControllers];
+
+	FLatencyHistogram Jitter;
+	FLatencyHistogram Latency;
+	uint64 NumTicks;
+	uint64 NumUpdates;
+
+	mutable FCriticalSection StatsLock;
+	FForceFeedbackStats Stats;
+
+	std::atomic<bool> bStopping;
+	FRunnableThread* Thread;
+};
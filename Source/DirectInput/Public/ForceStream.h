@@ -0,0 +1,72 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <atomic>
+
+// Samples of a force waveform, -1..1, from a generator on any thread to the upload on the game thread. The generator
+// writes into a single producer, single consumer ring without locking. The upload drains it into one of two blocks in
+// turn, so the block last handed to the driver is never the one being filled and neither side waits on the other.
+class FForceStream
+{
+public:
+	FForceStream(uint32 InSampleRate, float BufferSeconds);
+
+	uint32 GetSampleRate() const { return SampleRate; }
+	uint32 GetSamplePeriod() const { return 1000000 / SampleRate; }
+	// Samples the ring holds, a power of two
+	uint32 GetCapacity() const { return Ring.Num(); }
+
+	// Generator side, only one thread at a time. Samples that don't fit are dropped, returns how many were taken.
+	int32 Push(const float* Samples, int32 Num);
+
+	// Upload side. Fills the other block with what has arrived and makes it current. False if nothing has, the last
+	// block is left as it was.
+	bool Fill();
+
+	// Current block in the units of the force (-10000..10000), and which of the two it is
+	const int32* GetBlock() const { return Blocks[Current].GetData(); }
+	int32 GetBlockSize() const { return Blocks[Current].Num(); }
+	uint32 GetBlockIndex() const { return Current; }
+	// Playing time of the current block in microseconds
+	uint32 GetBlockDuration() const { return static_cast<uint32>(static_cast<uint64>(Blocks[Current].Num()) * 1000000 / SampleRate); }
+
+	// Sine approximating the current block for devices without custom forces: peak amplitude around the mean, and
+	// the period from the zero crossings, in microseconds
+	void GetPeriodic(uint32& OutMagnitude, int32& OutOffset, uint32& OutPeriod) const;
+
+	// Most samples uploaded at a time, a tenth of a second
+	uint32 GetMaxBlockSize() const { return FMath::Max(SampleRate / 10, 1u); }
+
+private:
+	const uint32 SampleRate;
+
+	TArray<float> Ring;
+	uint32 Mask;
+	std::atomic<uint32> Head;
+	std::atomic<uint32> Tail;
+
+	TArray<int32> Blocks[2];
+	uint32 Current;
+};
@@ -0,0 +1,75 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <atomic>
+
+// Raw state of a device at one point in time
+struct FInputSample
+{
+	double Time;
+	int32 Axes[8];
+	uint32 Buttons[4];
+	uint32 Povs[4];
+
+	bool IsButtonPressed(const uint32 Button) const { return (Buttons[Button / 32] >> (Button % 32)) & 1; }
+};
+
+// Bounded history of samples for one device. Samples are pushed by the thread polling the device and can be queried
+// from any thread without locking, each slot is guarded by a sequence counter and a read that races the writer retries
+// up to MaxReadAttempts times.
+class FInputHistory
+{
+public:
+	FInputHistory(uint32 InCapacity);
+	~FInputHistory() = default;
+
+	static constexpr uint32 MaxReadAttempts = 64;
+
+	uint32 GetCapacity() const { return Capacity; }
+
+	void Push(const FInputSample& Sample);
+
+	// Axis value at Time, linearly interpolated between the samples around it and clamped to the oldest and newest
+	bool GetAxisAt(uint32 Axis, double Time, float& OutValue) const;
+	// Button state of the latest sample at or before Time
+	bool GetButtonAt(uint32 Button, double Time, bool& OutPressed) const;
+	// POV value of the latest sample at or before Time
+	bool GetPovAt(uint32 Pov, double Time, uint32& OutValue) const;
+
+private:
+	struct FSlot
+	{
+		std::atomic<uint32> Sequence;
+		uint64 Index;
+		FInputSample Sample;
+	};
+
+	bool ReadSlot(uint64 Index, FInputSample& OutSample) const;
+	bool FindSamples(double Time, FInputSample& OutBefore, FInputSample& OutAfter, bool& bOutHasAfter) const;
+
+	uint32 Capacity;
+	TUniquePtr<FSlot[]> Slots;
+	std::atomic<uint64> Head;
+};
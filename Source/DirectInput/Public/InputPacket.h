@@ -0,0 +1,76 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "StateSnapshot.h"
+
+// Which parts of a device state are replicated and how many bits each axis is quantised to
+struct FInputPacketFormat
+{
+	FInputPacketFormat(uint32 InNumAxes, uint32 InAxisBits, uint32 InNumButtons);
+
+	void SetAxisBits(uint32 Axis, uint32 Bits);
+
+	static constexpr uint32 MaxAxes = 8;
+	static constexpr uint32 MaxButtons = 128;
+	static constexpr uint32 MaxAxisBits = 16;
+
+	uint32 NumAxes;
+	uint32 AxisBits[MaxAxes];
+	uint32 NumButtons;
+};
+
+// Quantised device state, the unit that is replicated and acknowledged
+struct FInputPacket
+{
+	FInputPacket();
+
+	uint32 Axes[FInputPacketFormat::MaxAxes];
+	uint32 Buttons[FInputPacketFormat::MaxButtons / 32];
+
+	bool operator==(const FInputPacket& Other) const;
+	bool operator!=(const FInputPacket& Other) const { return !(*this == Other); }
+};
+
+// Packs device state into a bit stream. Each axis and each group of 32 buttons is sent as a changed bit followed by
+// its value only when it differs from the baseline, which should be the last packet the receiver acknowledged (or a
+// default constructed packet before anything has been acknowledged).
+class FInputPacketCodec
+{
+public:
+	FInputPacketCodec(const FInputPacketFormat& InFormat);
+
+	void Quantize(const FDirectInputState& State, FInputPacket& OutPacket) const;
+	void Dequantize(const FInputPacket& Packet, FDirectInputState& OutState) const;
+
+	// Writes or reads depending on the archive, bit archives such as FBitWriter and FBitReader pack tightly
+	void Serialize(FArchive& Ar, FInputPacket& Packet, const FInputPacket& Baseline) const;
+
+	// Number of bits Serialize writes for Packet against Baseline
+	uint32 GetSerializedBits(const FInputPacket& Packet, const FInputPacket& Baseline) const;
+
+	const FInputPacketFormat& GetFormat() const { return Format; }
+
+private:
+	FInputPacketFormat Format;
+};
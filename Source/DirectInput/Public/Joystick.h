@@ -1,94 +1,316 @@
-﻿/* 
- * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
- * 
- * Permission is hereby granted, free of charge, to any person obtaining a copy of 
- * this software and associated documentation files (the "Software"), to deal in the 
- * Software without restriction, including without limitation the rights to use, copy, 
- * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
- * and to permit persons to whom the Software is furnished to do so, subject to the 
- * following conditions:
- *
- * The above copyright notice and this permission notice shall be included in all 
- * copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
- * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
- * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
- * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
- * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
- * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
-*/
-
-#pragma once
-
-#include "Windows/WindowsApplication.h"
-
-#define DIRECTINPUT_VERSION 0x0800
-#include <dinput.h>
-
-class FJoystick
-{
-public:
-	FJoystick(LPDIRECTINPUTDEVICE8 device);
-	~FJoystick() = default;
-	void Release() const;
-
-	GUID GetProductGui() const;
-	FString GetProductGuidAsString() const;
-	FString GetProductName() const;
-	
-	GUID GetInstanceGuid() const;
-	FString GetInstanceGuidAsString() const;
-	FString GetInstanceName() const;
-
-	GUID GetForceDriverGuid() const;
-	FString GetForceDriverGuidAsString() const;
-	
-	uint32 GetNumAxes() const { return Capabilities.dwAxes; }
-	uint32 GetNumButtons() const { return Capabilities.dwButtons; }
-	uint32 GetNumPovs() const { return Capabilities.dwPOVs; }
-
-	bool IsAvailable() const { return Available; }
-
-	bool Poll();
-
-	int32 GetAxisValue(uint32 Axis) const;
-	int32 GetButtonValue(uint32 Button) const;
-	int32 GetPovValue(uint32 Pov) const;
-
-	bool IsAxisChanged(uint32 Axis) const;
-	bool IsButtonChanged(uint32 Button) const;
-	bool IsPovChanged(uint32 Pov) const;
-
-	FString GetAxisName(uint32 Axis) const;
-	uint32 GetAxisMaxForce(uint32 Axis) const;
-	uint32 GetAxisForceResolution(uint32 Axis) const;
-	bool IsForceActuator(uint32 Axis) const;
-
-	bool UpdateEffect(int Magnitude);
-	
-	BOOL EnumerateAxes(LPCDIDEVICEOBJECTINSTANCE ObjectInstance);
-
-private:
-	bool TryAcquireDevice();
-	bool GetDeviceInfo();
-	bool GetCapabilities();
-	void GetObjects();
-
-	bool CreateEffect(uint32 Axis);
-	bool StopEffect() const;
-
-	LPDIRECTINPUTEFFECT Effect;
-	LPDIRECTINPUTDEVICE8 Device;
-	DIDEVICEINSTANCE Instance;
-	DIDEVCAPS Capabilities;
-
-	bool Available;
-
-	DIJOYSTATE2 CurrentState;
-	DIJOYSTATE2 PreviousState;
-
-	DIEFFECT EffectConfig;
-
-	LPCDIDEVICEOBJECTINSTANCE AxisInstances[8];
-};
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "Windows/WindowsApplication.h"
+#include "AxisFilter.h"
+#include "AxisNormalizer.h"
+#include "Bindings.h"
+#include "Calibration.h"
+#include "DeviceCache.h"
+#include "ForceConditions.h"
+#include "ForceEffectFile.h"
+#include "ForceStream.h"
+#include "InputHistory.h"
+#include "PollScheduler.h"
+#include "Remap.h"
+#include "StateSnapshot.h"
+#include "TelemetryPublisher.h"
+
+#define DIRECTINPUT_VERSION 0x0800
+#include <dinput.h>
+
+inline FGuid ToFGuid(const GUID& Guid)
+{
+	return FGuid(
+		Guid.Data1,
+		static_cast<uint32>(Guid.Data2) << 16 | Guid.Data3,
+		static_cast<uint32>(Guid.Data4[0]) << 24 | Guid.Data4[1] << 16 | Guid.Data4[2] << 8 | Guid.Data4[3],
+		static_cast<uint32>(Guid.Data4[4]) << 24 | Guid.Data4[5] << 16 | Guid.Data4[6] << 8 | Guid.Data4[7]);
+}
+
+inline GUID ToGuid(const FGuid& Guid)
+{
+	GUID Result;
+	Result.Data1 = Guid.A;
+	Result.Data2 = static_cast<uint16>(Guid.B >> 16);
+	Result.Data3 = static_cast<uint16>(Guid.B);
+	for (uint32 Index = 0; Index < 4; Index++)
+	{
+		Result.Data4[Index] = static_cast<uint8>(Guid.C >> (24 - Index * 8));
+		Result.Data4[Index + 4] = static_cast<uint8>(Guid.D >> (24 - Index * 8));
+	}
+	return Result;
+}
+
+// Members read by the poll and dispatch of every frame come first, followed by the two state slots, so stepping through
+// the devices only touches a few cache lines of each. Everything else is kept out of line in FInfo.
+class alignas(PLATFORM_CACHE_LINE_SIZE) FJoystick
+{
+public:
+	FJoystick(LPDIRECTINPUTDEVICE8 device, FDeviceCache* Cache = nullptr);
+	~FJoystick() = default;
+	void Release() const;
+
+	GUID GetProductGui() const;
+	FString GetProductGuidAsString() const;
+	FString GetProductName() const;
+	
+	GUID GetInstanceGuid() const;
+	FString GetInstanceGuidAsString() const;
+	const FString& GetInstanceName() const;
+
+	GUID GetForceDriverGuid() const;
+	FString GetForceDriverGuidAsString() const;
+	
+	static constexpr uint32 MaxAxes = 8;
+	static constexpr uint32 MaxButtons = 128;
+	static constexpr uint32 MaxPovs = 4;
+
+	// POV hats decode to eight directions clockwise from up, or centred
+	static constexpr uint32 NumPovDirections = 8;
+	static constexpr uint32 PovCentered = NumPovDirections;
+
+	uint32 GetNumAxes() const { return NumAxes; }
+	uint32 GetNumButtons() const { return NumButtons; }
+	uint32 GetNumPovs() const { return NumPovs; }
+
+	bool IsAvailable() const { return Available; }
+
+	bool Poll();
+	// Interrupt driven devices update their state without Poll, which Poll skips for them
+	bool IsPolledDevice() const { return bPolledDevice; }
+	FPollSchedule& GetSchedule() { return Schedule; }
+
+	void EnableHistory(uint32 Capacity);
+	TSharedPtr<const FInputHistory, ESPMode::ThreadSafe> GetHistory() const { return History; }
+
+	void SetSnapshot(FStateSnapshot* InSnapshot) { Snapshot = InSnapshot; }
+	void SetTelemetry(FTelemetryPublisher* InTelemetry, uint32 InSlot);
+	// Publish the polled state, once the normaliser has converted the axes of every polled device
+	void PublishState();
+
+	// Normalise the axes in a batch shared by all devices, DeadZone is the fraction of each side of the centre that
+	// reads as centred
+	void SetNormalizer(FAxisNormalizer* InNormalizer, float InDeadZone);
+
+	void ApplyCalibration(const FCalibrationProfile& Profile);
+	FCalibrationProfile GetCalibration() const;
+	// Record the extents each axis reaches until calibration is stopped, which applies and returns them. Axes should be
+	// at rest when calibration starts, their position then becomes the centre.
+	void StartCalibration();
+	FCalibrationProfile StopCalibration();
+	bool IsCalibrating() const { return bCalibrating; }
+
+	// Keys the objects are sent as unless remapped, the shared keys until set. Takes effect with the next ApplyRemap.
+	void SetKeys(const FDirectInputKeySet& InKeys) { Info->Keys = &InKeys; }
+	const FDirectInputKeySet& GetKeys() const { return *Info->Keys; }
+
+	// Compile the keys each object is sent as, nullptr restores the default keys
+	void ApplyRemap(const FRemapProfile* Profile);
+	const FRemapTable& GetRemap() const { return Info->Remap; }
+	// Value of the combined axis whose first axis is Axis
+	float GetCombinedAxisValue(uint32 Axis) const;
+
+	// Filter the axes as configured on every poll, nullptr turns filtering off
+	void SetFilters(const FAxisFilterProfile* Profile);
+	bool IsFiltered() const { return Filter.IsValid(); }
+
+	int32 GetAxisValue(uint32 Axis) const;
+	// Raw value after filtering, or the raw value if the device isn't filtered
+	float GetFilteredAxisValue(uint32 Axis) const;
+	float GetNormalizedAxisValue(uint32 Axis) const;
+	// Normalised value mapped back onto the range reported by the driver, so calibration and dead zone apply to the
+	// input events without changing the units bindings were made for
+	float GetCalibratedAxisValue(uint32 Axis) const;
+	int32 GetButtonValue(uint32 Button) const;
+	int32 GetPovValue(uint32 Pov) const;
+	uint32 GetPovDirection(uint32 Pov) const;
+	uint32 GetPreviousPovDirection(uint32 Pov) const;
+
+	bool IsStateChanged() const;
+	bool IsAxisChanged(uint32 Axis) const;
+	bool IsButtonChanged(uint32 Button) const;
+	bool IsPovChanged(uint32 Pov) const;
+
+	FString GetAxisName(uint32 Axis) const;
+	uint32 GetAxisMaxForce(uint32 Axis) const;
+	uint32 GetAxisForceResolution(uint32 Axis) const;
+	bool IsForceActuator(uint32 Axis) const;
+
+	bool UpdateEffect(int Magnitude);
+
+	// Constant force set by the game, sent with the software conditions added
+	bool SetConstantForce(int Magnitude);
+	int GetConstantForce() const { return Info->ConstantForce; }
+
+	// Conditions the device supports are played by its own condition effects, the rest are synthesised in software
+	void SetConditions(const FForceConditions& InConditions);
+	bool HasSoftwareConditions() const { return bSoftwareConditions; }
+	// Software conditions from the polled position, in the units of the constant force
+	float SynthesizeConditions(double Time);
+	float GetConditionForce() const { return Info->Conditions.GetForce(); }
+
+	// Stream a waveform as a custom force, or as a sine approximating it on devices without custom forces
+	FForceStream* EnableForceStream(uint32 SampleRate);
+	FForceStream* GetForceStream() const { return Stream.Get(); }
+	bool IsStreamApproximated() const { return Info->bStreamPeriodic; }
+	// Queue what the generator has produced to play when the queued block ends, once that is within two updates
+	bool UpdateForceStream();
+
+	// Effects of an asset are created once, devices without force feedback or that reject them keep an empty entry. A
+	// full device makes room by releasing the least recently started assets that aren't playing.
+	bool LoadForceEffect(const FGuid& Id, const TArray<FForceEffectData>& Effects);
+	bool IsForceEffectLoaded(const FGuid& Id) const { return Info->EffectCache.Contains(Id); }
+	// Stops and releases the effects of an asset
+	void UnloadForceEffect(const FGuid& Id);
+	// Iterations of 0 plays until stopped
+	bool StartForceEffect(const FGuid& Id, uint32 Iterations) const;
+	bool StopForceEffect(const FGuid& Id) const;
+	
+	BOOL EnumerateObjects(LPCDIDEVICEOBJECTINSTANCE ObjectInstance);
+
+private:
+	bool TryAcquireDevice();
+	bool ReadState(uint32 NextIndex);
+	bool GetDeviceInfo();
+	bool GetCapabilities();
+	void GetObjects();
+	void BuildDataFormat();
+	void AddAxes(const TArray<FDeviceObject>& Enumerated);
+	void AddObjects(const TArray<FDeviceObject>& Enumerated, DWORD TypeMask, uint32 MaxCount, uint32 Size, uint32& OutCount);
+
+	const uint8* GetCurrentState() const { return StateSlots[StateIndex]; }
+	const uint8* GetPreviousState() const { return StateSlots[StateIndex ^ 1]; }
+
+	void FillSample(const uint8* State, FInputSample& OutSample) const;
+	void RecordSample();
+	bool RecordEvents();
+	void UpdateNormalizer();
+	void RecordExtents();
+	void FilterAxes();
+
+	bool CreateEffect(uint32 Axis);
+	bool EvictForceEffect(const FGuid& Keep);
+	bool StopEffect() const;
+	void GetConditionSupport();
+	bool UpdateConditionEffect(EForceCondition Condition, float Coefficient);
+
+	// Buffered events read per poll for the history
+	static constexpr uint32 HistoryBufferSize = 256;
+
+	// Largest data format, axes (LONG), POVs (DWORD) and buttons (BYTE), in whole cache lines
+	static constexpr uint32 MaxDataSize = Align(MaxAxes * sizeof(LONG) + MaxPovs * sizeof(DWORD) + MaxButtons, PLATFORM_CACHE_LINE_SIZE);
+
+	struct FInfo
+	{
+		// Held by every method that calls the device or its effects, as the force feedback thread updates the constant
+		// force while the game thread polls. Recursive, so those methods can call each other.
+		FCriticalSection DeviceLock;
+
+		DIDEVICEINSTANCE Instance;
+		DIDEVCAPS Capabilities;
+		FString InstanceName;
+
+		float DeadZone;
+		uint32 TelemetrySlot;
+
+		// State after the last event added to the history
+		FInputSample HistoryState;
+
+		// Data format built from the device objects, laid out as axes (LONG), POVs (DWORD) and buttons (BYTE)
+		TArray<FDeviceObject> Objects;
+		TArray<DIOBJECTDATAFORMAT> ObjectFormats;
+
+		FAxisCalibration AxisCalibrations[MaxAxes];
+		int32 ObservedMin[MaxAxes];
+		int32 ObservedMax[MaxAxes];
+		int32 RestPosition[MaxAxes];
+
+		const FDirectInputKeySet* Keys;
+		FRemapTable Remap;
+
+		// Filtered axes in two slots that follow StateIndex
+		float FilteredAxes[2][MaxAxes];
+		double LastFilterTime;
+
+		LPDIRECTINPUTEFFECT Effect;
+		DIEFFECT EffectConfig;
+		int ConstantForce;
+
+		// Hardware condition effects, created when first used
+		LPDIRECTINPUTEFFECT ConditionEffects[static_cast<uint32>(EForceCondition::Count)];
+		uint32 HardwareConditions;
+		FForceConditions ConditionSettings;
+		FConditionSynthesizer Conditions;
+
+		// Blocks are played by the two effects in turn, each queued to start when the block before it ends
+		LPDIRECTINPUTEFFECT StreamEffects[2];
+		bool bStreamPeriodic;
+		// In FPlatformTime::Seconds, when the last queued block ends and when the stream was last updated
+		double StreamEnd;
+		double LastStreamUpdate;
+
+		// Created effects by the id of their asset, and when they were last loaded or started on EffectClock
+		struct FCachedEffect
+		{
+			TArray<LPDIRECTINPUTEFFECT> Handles;
+			uint64 LastUsed = 0;
+		};
+		TMap<FGuid, FCachedEffect> EffectCache;
+		uint64 EffectClock;
+	};
+
+	LPDIRECTINPUTDEVICE8 Device;
+	TUniquePtr<FInfo> Info;
+
+	FAxisNormalizer* Normalizer;
+	FStateSnapshot* Snapshot;
+	FTelemetryPublisher* Telemetry;
+	TUniquePtr<FAxisFilterBank> Filter;
+	TUniquePtr<FForceStream> Stream;
+	TSharedPtr<FInputHistory, ESPMode::ThreadSafe> History;
+
+	uint32 NumAxes;
+	uint32 NumButtons;
+	uint32 NumPovs;
+	uint32 PovOffset;
+	uint32 ButtonOffset;
+	uint32 DataSize;
+	uint32 StateIndex;
+	uint32 NormalizerLane;
+
+	FPollSchedule Schedule;
+
+	bool Available;
+	bool bPolledDevice;
+	// Set while polls fail so an outage is only logged once
+	bool bInputLost;
+	bool bCalibrating;
+	bool bSoftwareConditions;
+
+	// Two state slots of DataSize bytes each, StateIndex selects the current one and the other is the previous
+	alignas(PLATFORM_CACHE_LINE_SIZE) uint8 StateSlots[2][MaxDataSize];
+};
+
+// The default allocator only aligns to 16 bytes, which would let the devices straddle cache lines
+typedef TArray<FJoystick, TAlignedHeapAllocator<PLATFORM_CACHE_LINE_SIZE>> FJoystickArray;
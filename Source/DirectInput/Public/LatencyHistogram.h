@@ -0,0 +1,78 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// One bucket per microsecond, anything slower is counted in the last one
+class FLatencyHistogram
+{
+public:
+	static constexpr uint32 NumBuckets = 10000;
+
+	FLatencyHistogram()
+	{
+		Buckets.SetNumZeroed(NumBuckets);
+	}
+
+	void Add(const double Microseconds)
+	{
+		Buckets[FMath::Min(static_cast<uint32>(FMath::Max(Microseconds, 0.0)), NumBuckets - 1)]++;
+		Count++;
+		Sum += Microseconds;
+		Max = FMath::Max(Max, Microseconds);
+	}
+
+	// Upper edge of the bucket the percentile falls in
+	double GetPercentile(const double Fraction) const
+	{
+		const uint64 Target = FMath::Max<uint64>(static_cast<uint64>(FMath::CeilToDouble(Fraction * Count)), 1);
+		uint64 Seen = 0;
+		for (uint32 Bucket = 0; Bucket < NumBuckets; Bucket++)
+		{
+			Seen += Buckets[Bucket];
+			if (Seen >= Target)
+			{
+				return Bucket + 1.0;
+			}
+		}
+		return 0.0;
+	}
+
+	double GetMean() const { return Count > 0 ? Sum / Count : 0.0; }
+	double GetMax() const { return Max; }
+	uint64 GetCount() const { return Count; }
+
+	void Reset()
+	{
+		FMemory::Memzero(Buckets.GetData(), Buckets.Num() * sizeof(uint64));
+		Count = 0;
+		Sum = 0.0;
+		Max = 0.0;
+	}
+
+private:
+	TArray<uint64> Buckets;
+	uint64 Count = 0;
+	double Sum = 0.0;
+	double Max = 0.0;
+};
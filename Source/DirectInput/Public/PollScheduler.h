@@ -0,0 +1,77 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// How often one device is read and how far it has backed off while idle
+struct FPollSchedule
+{
+	// Frames between reads from the device's priority class
+	uint32 Interval = 1;
+	// Factor the interval is multiplied by while the device is idle
+	uint32 Backoff = 1;
+	uint32 IdleSamples = 0;
+	uint32 FramesSinceRead = 0;
+};
+
+// Decides which devices are read each frame and counts the driver calls that saves, configured in the [DirectInput]
+// section of the input config:
+// +PollPriority=<ProductGuid>,<Full|Half|Low|Frames>
+// PollIdleSamples=<Unchanged reads before a device backs off, 0 never backs off>
+// PollMaxBackoff=<Most frames between reads of an idle device>
+// PollThrottledInterval=<Frames between reads of every device while the application is unfocused or paused>
+class FPollScheduler
+{
+public:
+	void LoadConfig();
+
+	// Interval of the priority class of a product, 1 if it has none
+	uint32 GetInterval(const FGuid& Product) const;
+
+	// Once per frame before the devices are read
+	void BeginFrame();
+	bool IsThrottled() const { return FrameThrottle > 1; }
+
+	// Counts the frame towards the next read, true when the device is due
+	bool IsDue(FPollSchedule& Schedule) const;
+	// After a read, a changed device goes back to its priority interval and an idle one backs off
+	void RecordRead(FPollSchedule& Schedule, bool bChanged) const;
+
+	// Driver calls made and saved compared to calling Poll and GetDeviceState on every device every frame
+	void RecordCalls(uint32 Made, uint32 Saved);
+	double GetCallsPerSecond() const;
+	double GetSavedCallsPerSecond() const;
+	void ResetCounters();
+
+private:
+	TMap<FGuid, uint32> Intervals;
+	uint32 IdleSamples = 0;
+	uint32 MaxBackoff = 8;
+	uint32 ThrottledInterval = 1;
+
+	uint32 FrameThrottle = 1;
+
+	uint64 NumCalls = 0;
+	uint64 NumSavedCalls = 0;
+	double CounterStartTime = 0.0;
+};
@@ -0,0 +1,103 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DeviceCache.h"
+
+struct FDirectInputKeySet;
+
+// How two pedals on separate axes are merged into one, the first adds to the centre and the second subtracts from it
+enum class ERemapCombine : uint8
+{
+	None,
+	Positive,
+	Negative,
+};
+
+struct FAxisRemapRule
+{
+	uint32 Source;
+	FName Target;
+	bool bInvert;
+	ERemapCombine Combine;
+};
+
+struct FButtonRemapRule
+{
+	uint32 Source;
+	FName Target;
+	bool bInvert;
+};
+
+struct FRemapProfile
+{
+	TArray<FAxisRemapRule> Axes;
+	TArray<FButtonRemapRule> Buttons;
+};
+
+// Remap rules keyed by product GUID, read from the [DirectInput] section of the input config:
+// +AxisRemap=<ProductGuid>,<SourceAxis>,<TargetKey>[,Invert][,Positive|Negative]
+// +ButtonRemap=<ProductGuid>,<SourceButton>,<TargetKey>[,Invert]
+class FRemapStore
+{
+public:
+	void LoadConfig();
+
+	const FRemapProfile* Find(const FGuid& Product) const { return Profiles.Find(Product); }
+	int32 Num() const { return Profiles.Num(); }
+
+private:
+	TMap<FGuid, FRemapProfile> Profiles;
+};
+
+// Remap rules of one device compiled to tables indexed by the object's index on the device, objects without a rule
+// keep their default key and a target of None drops the object.
+struct FRemapTable
+{
+	static constexpr uint32 MaxAxes = 8;
+	static constexpr uint32 MaxButtons = 128;
+
+	struct FAxis
+	{
+		FName Key;
+		// Raw value is sent as Offset + Scale * Value, or added to the centre of its combined axis
+		float Scale;
+		float Offset;
+		// First axis of the combined axis this one is part of, INDEX_NONE if it isn't combined
+		int32 Combine;
+	};
+
+	struct FButton
+	{
+		FName Key;
+		bool bInvert;
+	};
+
+	FAxis Axes[MaxAxes];
+	FButton Buttons[MaxButtons];
+	float CombineCenter[MaxAxes];
+
+	// AxisObjects are the device's axes in order, used for the ranges to invert and combine over. Objects the profile
+	// doesn't map send the device's own keys from Keys.
+	void Compile(const FRemapProfile* Profile, const FDirectInputKeySet& Keys, const FDeviceObject* AxisObjects, uint32 NumAxes, uint32 NumButtons);
+};
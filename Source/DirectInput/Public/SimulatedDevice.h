@@ -0,0 +1,141 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "Joystick.h"
+
+class FDirectInputDevice;
+
+// A DirectInput device whose state is set from code, so FJoystick and the dispatch can be driven without hardware by
+// the benchmarks and the soak test. Disconnects and failures to reacquire can be injected to exercise recovery.
+class FSimulatedDevice : public IDirectInputDevice8
+{
+public:
+	FSimulatedDevice(uint32 InIndex, uint32 InNumAxes, uint32 InNumButtons, uint32 InNumPovs);
+
+	uint32 GetNumAxes() const { return NumAxes; }
+	uint32 GetNumButtons() const { return NumButtons; }
+	uint32 GetNumPovs() const { return NumPovs; }
+
+	void SetAxis(uint32 Axis, LONG Value) { Axes[Axis] = Value; }
+	void SetButton(uint32 Button, bool bPressed) { Buttons[Button] = bPressed ? 0x80 : 0x00; }
+	void SetPov(uint32 Pov, DWORD Value) { Povs[Pov] = Value; }
+
+	LONG GetAxis(uint32 Axis) const { return Axes[Axis]; }
+	bool GetButton(uint32 Button) const { return Buttons[Button] != 0; }
+	DWORD GetPov(uint32 Pov) const { return Povs[Pov]; }
+
+	// While disconnected polls and reads fail with input lost and the device can't be acquired
+	void SetConnected(bool bInConnected);
+	bool IsConnected() const { return bConnected; }
+	// Fail the next Count attempts to acquire the device even if it is connected
+	void FailAcquire(uint32 Count) { AcquireFailures = Count; }
+	bool IsAcquired() const { return bAcquired; }
+
+	// Number of successful reads of the state
+	uint64 GetNumStateReads() const { return NumStateReads; }
+
+	// Number of times an effect of the device had its parameters set
+	uint64 GetNumEffectUpdates() const { return NumEffectUpdates; }
+	void AddEffectUpdate() { NumEffectUpdates++; }
+
+	// IUnknown
+	STDMETHOD(QueryInterface)(REFIID Riid, LPVOID* Object) override;
+	STDMETHOD_(ULONG, AddRef)() override;
+	STDMETHOD_(ULONG, Release)() override;
+
+	// IDirectInputDevice8
+	STDMETHOD(GetCapabilities)(LPDIDEVCAPS DevCaps) override;
+	STDMETHOD(EnumObjects)(LPDIENUMDEVICEOBJECTSCALLBACK Callback, LPVOID Ref, DWORD Flags) override;
+	STDMETHOD(GetProperty)(REFGUID Property, LPDIPROPHEADER Header) override;
+	STDMETHOD(SetProperty)(REFGUID Property, LPCDIPROPHEADER Header) override;
+	STDMETHOD(Acquire)() override;
+	STDMETHOD(Unacquire)() override;
+	STDMETHOD(GetDeviceState)(DWORD Size, LPVOID Data) override;
+	STDMETHOD(GetDeviceData)(DWORD ObjectDataSize, LPDIDEVICEOBJECTDATA ObjectData, LPDWORD InOut, DWORD Flags) override;
+	STDMETHOD(SetDataFormat)(LPCDIDATAFORMAT Format) override;
+	STDMETHOD(SetEventNotification)(HANDLE Event) override;
+	STDMETHOD(SetCooperativeLevel)(HWND Window, DWORD Flags) override;
+	STDMETHOD(GetObjectInfo)(LPDIDEVICEOBJECTINSTANCE ObjectInstance, DWORD Object, DWORD How) override;
+	STDMETHOD(GetDeviceInfo)(LPDIDEVICEINSTANCE DeviceInstance) override;
+	STDMETHOD(RunControlPanel)(HWND Owner, DWORD Flags) override;
+	STDMETHOD(Initialize)(HINSTANCE Instance, DWORD Version, REFGUID Guid) override;
+	STDMETHOD(CreateEffect)(REFGUID Guid, LPCDIEFFECT Effect, LPDIRECTINPUTEFFECT* OutEffect, LPUNKNOWN Outer) override;
+	STDMETHOD(EnumEffects)(LPDIENUMEFFECTSCALLBACK Callback, LPVOID Ref, DWORD Type) override;
+	STDMETHOD(GetEffectInfo)(LPDIEFFECTINFO EffectInfo, REFGUID Guid) override;
+	STDMETHOD(GetForceFeedbackState)(LPDWORD Out) override;
+	STDMETHOD(SendForceFeedbackCommand)(DWORD Flags) override;
+	STDMETHOD(EnumCreatedEffectObjects)(LPDIENUMCREATEDEFFECTOBJECTSCALLBACK Callback, LPVOID Ref, DWORD Flags) override;
+	STDMETHOD(Escape)(LPDIEFFESCAPE EffectEscape) override;
+	STDMETHOD(Poll)() override;
+	STDMETHOD(SendDeviceData)(DWORD ObjectDataSize, LPCDIDEVICEOBJECTDATA ObjectData, LPDWORD InOut, DWORD Flags) override;
+	STDMETHOD(EnumEffectsInFile)(LPCTSTR FileName, LPDIENUMEFFECTSINFILECALLBACK Callback, LPVOID Ref, DWORD Flags) override;
+	STDMETHOD(WriteEffectToFile)(LPCTSTR FileName, DWORD Entries, LPDIFILEEFFECT Effects, DWORD Flags) override;
+	STDMETHOD(BuildActionMap)(LPDIACTIONFORMAT ActionFormat, LPCTSTR UserName, DWORD Flags) override;
+	STDMETHOD(SetActionMap)(LPDIACTIONFORMAT ActionFormat, LPCTSTR UserName, DWORD Flags) override;
+	STDMETHOD(GetImageInfo)(LPDIDEVICEIMAGEINFOHEADER ImageInfo) override;
+
+private:
+	virtual ~FSimulatedDevice() = default;
+
+	uint32 Index;
+	uint32 NumAxes;
+	uint32 NumButtons;
+	uint32 NumPovs;
+
+	LONG Axes[FJoystick::MaxAxes];
+	BYTE Buttons[FJoystick::MaxButtons];
+	DWORD Povs[FJoystick::MaxPovs];
+
+	TArray<DIOBJECTDATAFORMAT> ObjectFormats;
+	DWORD DataSize;
+
+	bool bConnected;
+	bool bAcquired;
+	uint32 AcquireFailures;
+	uint64 NumStateReads;
+	uint64 NumEffectUpdates;
+	ULONG RefCount;
+};
+
+// Puts simulated devices in place of the connected ones, with their events going to MessageHandler, until the scope
+// ends. Only use it on the game thread, where the devices are polled.
+class FSimulatedDeviceScope
+{
+public:
+	FSimulatedDeviceScope(FDirectInputDevice& InInputDevice, const TSharedRef<FGenericApplicationMessageHandler>& MessageHandler, uint32 NumDevices, uint32 NumAxes, uint32 NumButtons, uint32 NumPovs);
+	~FSimulatedDeviceScope();
+
+	FSimulatedDevice& GetDevice(uint32 Index) { return *Devices[Index]; }
+	uint32 Num() const { return Devices.Num(); }
+
+private:
+	FDirectInputDevice& InputDevice;
+	TArray<FSimulatedDevice*> Devices;
+
+	FJoystickArray SavedDevices;
+	FAxisNormalizer SavedNormalizer;
+	TSharedRef<FGenericApplicationMessageHandler> SavedMessageHandler;
+
+	// Objects are only enumerated for the first device, the rest come from the cache like known devices do
+	FDeviceCache Cache;
+};
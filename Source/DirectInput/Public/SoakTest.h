@@ -0,0 +1,123 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LatencyHistogram.h"
+
+class FDirectInputDevice;
+class FEdgeTrackingMessageHandler;
+class FSimulatedDeviceScope;
+
+struct FSoakTestSettings
+{
+	uint32 NumDevices = 32;
+	uint32 Rate = 1000;
+	double Minutes = 60.0;
+	int32 Seed = 1;
+
+	// Per device, on average once every this many seconds
+	double DisconnectInterval = 120.0;
+};
+
+struct FSoakTestResult
+{
+	uint64 NumFrames = 0;
+	uint64 NumEvents = 0;
+	uint64 NumEdges = 0;
+
+	// Button edges that never arrived after a successful poll, and ones that arrived twice
+	uint64 NumLostEdges = 0;
+	uint64 NumDuplicateEdges = 0;
+
+	uint64 NumDisconnects = 0;
+	uint64 NumAcquireFailures = 0;
+
+	FString ReportPath;
+
+	bool IsPassed() const { return NumLostEdges == 0 && NumDuplicateEdges == 0; }
+};
+
+// Runs simulated devices with seeded random input, disconnects and failed reacquires at a fixed rate for a long time,
+// checking every button edge arrives exactly once. Memory, dispatch latency and frame cost are tracked over the run and
+// written to a report in Saved/DirectInput. Everything happens on the game thread like the polling it stands in for:
+// the simulated devices replace the connected ones from construction to destruction, and each Tick runs the frames that
+// have come due since the last, so the game keeps ticking. Meant for unattended runs such as
+// -ExecCmds="DINPUT SOAK 32 720".
+class FDirectInputSoakTest
+{
+public:
+	FDirectInputSoakTest(FDirectInputDevice& InInputDevice, const FSoakTestSettings& InSettings);
+	~FDirectInputSoakTest();
+
+	void Tick();
+	// Ends the run on the next tick, the result covers the frames run so far
+	void Stop() { bStopping = true; }
+
+	bool IsDone() const { return bDone; }
+	// Only valid once done
+	const FSoakTestResult& GetResult() const { return Result; }
+
+private:
+	// Input and faults of one simulated device, each with its own stream so a seed replays the same run
+	struct FDriver
+	{
+		FRandomStream Random;
+		uint64 NumStateReads = 0;
+		uint32 OfflineFrames = 0;
+	};
+
+	void RunFrame();
+	void DriveDevice(uint32 Index);
+	void ReportInterval();
+	void Finish();
+
+	FDirectInputDevice& InputDevice;
+	const FSoakTestSettings Settings;
+	FSoakTestResult Result;
+
+	TSharedRef<FEdgeTrackingMessageHandler> Handler;
+	TUniquePtr<FSimulatedDeviceScope> Simulated;
+	TArray<FDriver> Drivers;
+
+	FString Report;
+	FLatencyHistogram FrameCost;
+	FLatencyHistogram IntervalFrameCost;
+
+	// Frames are due at the soak rate from StartTime, Frame counts those run or dropped
+	uint32 Rate;
+	uint64 NumFrames;
+	uint64 Frame;
+	uint64 NextReportFrame;
+	double StartTime;
+	double NextFrameTime;
+
+	// Frames that came due while the game was slower to tick than the catch up allows
+	uint64 NumDroppedFrames;
+	uint64 IntervalDroppedFrames;
+
+	double StartMegabytes;
+	double PeakMegabytes;
+
+	bool bStopping;
+	bool bDone;
+};
@@ -0,0 +1,74 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <atomic>
+
+// Latest state of a device with axes normalised to -1..1 over the range reported by the driver
+struct FDirectInputState
+{
+	double Time;
+	uint64 Sequence;
+
+	uint32 NumAxes;
+	uint32 NumButtons;
+	uint32 NumPovs;
+
+	float Axes[8];
+	uint32 Buttons[4];
+	uint32 Povs[4];
+
+	bool IsButtonPressed(const uint32 Button) const { return Button < NumButtons && ((Buttons[Button / 32] >> (Button % 32)) & 1); }
+};
+
+// Publishes the state of one device to any number of readers on any thread. The writer fills a slot that isn't the
+// latest one and then makes it the latest, so readers never wait on a write in progress and only retry if the writer
+// has cycled through every slot while they were copying. That takes NumSlots publishes, one per frame, so a retry
+// means the reader was descheduled mid-copy. Reads are lock-free rather than wait-free: a reader gives up after
+// MaxReadAttempts, which a single writer can't cause without the reader being starved for that many frames.
+class FStateSnapshot
+{
+public:
+	FStateSnapshot();
+	~FStateSnapshot() = default;
+
+	void Publish(const FDirectInputState& State);
+
+	// False until the first state has been published, or if every attempt raced the writer
+	bool Read(FDirectInputState& OutState) const;
+
+	static constexpr uint32 MaxReadAttempts = 64;
+
+private:
+	static constexpr uint32 NumSlots = 4;
+
+	struct FSlot
+	{
+		std::atomic<uint64> Sequence;
+		FDirectInputState State;
+	};
+
+	FSlot Slots[NumSlots];
+	std::atomic<uint64> Latest;
+};
@@ -0,0 +1,158 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+// Layout of the shared memory written by FTelemetryPublisher and a lock-free reader for it. Plain C++ without the
+// engine so external tools can include this header alone, on any platform that can map the region or a copy of it.
+//
+// The region is an FHeader followed by MaxDevices slots of DeviceSize bytes. Version changes whenever a field moves or
+// changes meaning. Fields may be appended to FHeader and FDevice without a new version, readers step by HeaderSize and
+// DeviceSize so they keep working.
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+namespace DirectInputTelemetry
+{
+	static constexpr uint32_t Magic = 0x54454944; // "DIET"
+	static constexpr uint32_t Version = 2;
+
+	static constexpr uint32_t MaxDevices = 16;
+	static constexpr uint32_t MaxAxes = 8;
+	static constexpr uint32_t MaxButtons = 128;
+	static constexpr uint32_t MaxPovs = 4;
+	static constexpr uint32_t NameSize = 64;
+
+	struct FHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t HeaderSize;
+		uint32_t DeviceSize;
+		uint32_t MaxDevices;
+		// Slots below this have been assigned a device
+		uint32_t NumDevices;
+		// Timestamps are in ticks of the publisher's high resolution clock (QueryPerformanceCounter on Windows)
+		uint64_t TicksPerSecond;
+		uint64_t ProcessId;
+	};
+
+	struct FDeviceState
+	{
+		// Times the device has been published, 0 for a slot that hasn't been yet
+		uint64_t PublishCount;
+		uint64_t Timestamp;
+
+		// In the memory layout of a Windows GUID, Data1, Data2 and Data3 little-endian followed by the eight bytes of
+		// Data4, so they can be copied into a GUID as they are. {00112233-4455-6677-8899-AABBCCDDEEFF} is stored as
+		// 33 22 11 00 55 44 77 66 88 99 AA BB CC DD EE FF.
+		uint8_t ProductGuid[16];
+		uint8_t InstanceGuid[16];
+		// UTF-8, always terminated
+		char Name[NameSize];
+
+		uint32_t NumAxes;
+		uint32_t NumButtons;
+		uint32_t NumPovs;
+		uint32_t Reserved;
+
+		// Normalised to -1..1 with calibration and dead zone applied
+		float Axes[MaxAxes];
+		// One bit per button
+		uint32_t Buttons[MaxButtons / 32];
+		// Hundredths of degrees clockwise from north, 0xFFFF in the low word when centred
+		uint32_t Povs[MaxPovs];
+
+		bool IsButtonPressed(const uint32_t Button) const { return Button < NumButtons && ((Buttons[Button / 32] >> (Button % 32)) & 1); }
+	};
+
+	// Each slot has a cache line to itself
+	struct alignas(64) FDevice
+	{
+		// Odd while the publisher writes the slot
+		std::atomic<uint64_t> Sequence;
+		FDeviceState State;
+	};
+
+	static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t) && std::atomic<uint64_t>::is_always_lock_free, "The sequence must be a plain lock-free word to be shared between processes");
+	static_assert(sizeof(FHeader) == 40, "FHeader layout changed, bump Version");
+	static_assert(sizeof(FDevice) == 256, "FDevice layout changed, bump Version");
+
+	// Slots start on the first cache line after the header
+	inline uint64_t GetDeviceOffset(const uint32_t HeaderSize, const uint32_t DeviceSize, const uint32_t Index)
+	{
+		const uint64_t FirstDevice = (static_cast<uint64_t>(HeaderSize) + alignof(FDevice) - 1) / alignof(FDevice) * alignof(FDevice);
+		return FirstDevice + static_cast<uint64_t>(Index) * DeviceSize;
+	}
+
+	inline uint64_t GetRegionSize()
+	{
+		return GetDeviceOffset(sizeof(FHeader), sizeof(FDevice), MaxDevices);
+	}
+
+	// False if the region wasn't written by a publisher of this version or is smaller than its header says
+	inline bool IsCompatible(const void* Region, const uint64_t Size)
+	{
+		if (Region == nullptr || Size < sizeof(FHeader))
+		{
+			return false;
+		}
+
+		const FHeader& Header = *static_cast<const FHeader*>(Region);
+		return Header.Magic == Magic
+			&& Header.Version == Version
+			&& Header.HeaderSize >= sizeof(FHeader)
+			&& Header.DeviceSize >= sizeof(FDevice)
+			&& Size >= GetDeviceOffset(Header.HeaderSize, Header.DeviceSize, Header.MaxDevices);
+	}
+
+	// Copies a consistent state of a device without blocking the publisher. False if the slot has never been published,
+	// or it was rewritten during every attempt. Only call on a region IsCompatible accepted.
+	inline bool ReadDevice(const void* Region, const uint32_t Index, FDeviceState& OutState, const uint32_t MaxAttempts = 64)
+	{
+		const FHeader& Header = *static_cast<const FHeader*>(Region);
+		if (Index >= Header.MaxDevices)
+		{
+			return false;
+		}
+
+		const FDevice& Device = *reinterpret_cast<const FDevice*>(static_cast<const uint8_t*>(Region) + GetDeviceOffset(Header.HeaderSize, Header.DeviceSize, Index));
+		for (uint32_t Attempt = 0; Attempt < MaxAttempts; Attempt++)
+		{
+			const uint64_t Before = Device.Sequence.load(std::memory_order_acquire);
+			if (Before & 1)
+			{
+				continue;
+			}
+
+			std::memcpy(&OutState, &Device.State, sizeof(FDeviceState));
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			if (Device.Sequence.load(std::memory_order_relaxed) == Before)
+			{
+				return OutState.PublishCount > 0;
+			}
+		}
+		return false;
+	}
+}
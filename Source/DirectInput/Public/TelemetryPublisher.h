@@ -0,0 +1,50 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "StateSnapshot.h"
+#include "TelemetryLayout.h"
+
+// Writes the latest state of each device into a named shared memory region laid out as in TelemetryLayout.h, so
+// dashboards and motion platforms can read it without opening the devices themselves. Only used on the game thread.
+class FTelemetryPublisher
+{
+public:
+	FTelemetryPublisher();
+	~FTelemetryPublisher();
+
+	// Creates the region, e.g. Local\DirectInputTelemetry, or takes over one left by an earlier run
+	bool Open(const FString& Name);
+	void Close();
+	bool IsOpen() const { return Header != nullptr; }
+
+	// Identity of the device in a slot, written once when the device is found
+	void SetDevice(uint32 Slot, const FGuid& ProductGuid, const FGuid& InstanceGuid, const FString& Name);
+	void Publish(uint32 Slot, const FDirectInputState& State);
+
+private:
+	DirectInputTelemetry::FDevice* GetDevice(uint32 Slot) const;
+
+	void* Mapping;
+	DirectInputTelemetry::FHeader* Header;
+};
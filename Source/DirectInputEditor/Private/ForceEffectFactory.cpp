@@ -0,0 +1,78 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "ForceEffectFactory.h"
+#include "ForceEffect.h"
+#include "ForceEffectFile.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+UForceEffectFactory::UForceEffectFactory()
+{
+	SupportedClass = UForceEffect::StaticClass();
+	bCreateNew = false;
+	bEditorImport = true;
+	Formats.Add(TEXT("ffe;Force feedback effects"));
+}
+
+UObject* UForceEffectFactory::FactoryCreateFile(UClass* InClass, UObject* InParent, FName InName, EObjectFlags Flags, const FString& Filename, const TCHAR* Parms, FFeedbackContext* Warn, bool& bOutOperationCanceled)
+{
+	TArray<FForceEffectData> Effects;
+	if (!FForceEffectFile::Read(Filename, Effects) || Effects.Num() == 0)
+	{
+		Warn->Logf(ELogVerbosity::Error, TEXT("No effects could be read from %s"), *Filename);
+		return nullptr;
+	}
+
+	UForceEffect* Asset = NewObject<UForceEffect>(InParent, InClass, InName, Flags);
+	Asset->SetEffects(MoveTemp(Effects));
+	Asset->SourceFile = Filename;
+	return Asset;
+}
+
+UForceEffectExporter::UForceEffectExporter()
+{
+	SupportedClass = UForceEffect::StaticClass();
+	bText = false;
+	FormatExtension.Add(TEXT("ffe"));
+	FormatDescription.Add(TEXT("Force feedback effects"));
+}
+
+bool UForceEffectExporter::ExportBinary(UObject* Object, const TCHAR* Type, FArchive& Ar, FFeedbackContext* Warn, int32 FileIndex, uint32 PortFlags)
+{
+	const UForceEffect* Asset = CastChecked<UForceEffect>(Object);
+
+	// DirectInput only writes effect files by name, so the file is written aside and copied into the archive
+	const FString Filename = FPaths::CreateTempFilename(*FPaths::ProjectIntermediateDir(), TEXT("ForceEffect"), TEXT(".ffe"));
+	TArray<uint8> Data;
+	const bool bWritten = FForceEffectFile::Write(Filename, Asset->GetEffects()) && FFileHelper::LoadFileToArray(Data, *Filename);
+	IFileManager::Get().Delete(*Filename);
+
+	if (!bWritten)
+	{
+		Warn->Logf(ELogVerbosity::Error, TEXT("Failed to export %s"), *Asset->GetName());
+		return false;
+	}
+
+	Ar.Serialize(Data.GetData(), Data.Num());
+	return true;
+}
@@ -0,0 +1,216 @@
+﻿/* 
+ * Copyright (c) 2022 Anders Dahnielson <anders@dahnielson.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in the 
+ * Software without restriction, including without limitation the rights to use, copy, 
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, subject to the 
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Standalone check of TelemetryLayout.h without the engine. A writer thread publishes a device as fast as it can
+// through one mapping of a file while a reader calls ReadDevice through another, the way a tool in another process
+// would. Every field of a published state is derived from its publish count, so a copy mixing two publishes shows up.
+//
+//   cmake -S Tools/TelemetryTest -B Build && cmake --build Build && ctest --test-dir Build
+//   c++ -std=c++17 -O2 -pthread -I Source/DirectInput/Public Tools/TelemetryTest/TelemetryTest.cpp
+
+#include "TelemetryLayout.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace DirectInputTelemetry;
+
+static void* MapRegion(const int File, const uint64_t Size)
+{
+	void* Region = mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_SHARED, File, 0);
+	return Region == MAP_FAILED ? nullptr : Region;
+}
+
+static FDevice& GetDevice(void* Region, const uint32_t Index)
+{
+	const FHeader& Header = *static_cast<const FHeader*>(Region);
+	return *reinterpret_cast<FDevice*>(static_cast<uint8_t*>(Region) + GetDeviceOffset(Header.HeaderSize, Header.DeviceSize, Index));
+}
+
+// Same steps as FTelemetryPublisher::Open
+static void WriteHeader(void* Region)
+{
+	FHeader& Header = *static_cast<FHeader*>(Region);
+	Header.Version = Version;
+	Header.HeaderSize = sizeof(FHeader);
+	Header.DeviceSize = sizeof(FDevice);
+	Header.MaxDevices = MaxDevices;
+	Header.NumDevices = 1;
+	Header.TicksPerSecond = 1000000000;
+	Header.ProcessId = static_cast<uint64_t>(getpid());
+	std::atomic_thread_fence(std::memory_order_release);
+	Header.Magic = Magic;
+}
+
+static void FillState(FDeviceState& State, const uint64_t Count)
+{
+	State.PublishCount = Count;
+	State.Timestamp = Count * 3;
+	State.NumAxes = static_cast<uint32_t>(Count % MaxAxes);
+	State.NumButtons = static_cast<uint32_t>(Count % MaxButtons);
+	State.NumPovs = static_cast<uint32_t>(Count % MaxPovs);
+	for (uint32_t Axis = 0; Axis < MaxAxes; Axis++)
+	{
+		State.Axes[Axis] = static_cast<float>((Count + Axis) % 1000);
+	}
+	for (uint32_t Word = 0; Word < MaxButtons / 32; Word++)
+	{
+		State.Buttons[Word] = static_cast<uint32_t>(Count * (Word + 1));
+	}
+	for (uint32_t Pov = 0; Pov < MaxPovs; Pov++)
+	{
+		State.Povs[Pov] = static_cast<uint32_t>(Count + Pov);
+	}
+	std::memset(State.Name, 'A' + static_cast<int>(Count % 26), NameSize - 1);
+	State.Name[NameSize - 1] = '\0';
+}
+
+// Same steps as FTelemetryPublisher::Publish
+static void Publish(FDevice& Device, const uint64_t Count)
+{
+	const uint64_t Sequence = Device.Sequence.load(std::memory_order_relaxed);
+	Device.Sequence.store(Sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	FillState(Device.State, Count);
+
+	Device.Sequence.store(Sequence + 2, std::memory_order_release);
+}
+
+static bool IsConsistent(const FDeviceState& State)
+{
+	FDeviceState Expected;
+	std::memset(&Expected, 0, sizeof(Expected));
+	FillState(Expected, State.PublishCount);
+	std::memcpy(Expected.ProductGuid, State.ProductGuid, sizeof(Expected.ProductGuid));
+	std::memcpy(Expected.InstanceGuid, State.InstanceGuid, sizeof(Expected.InstanceGuid));
+	Expected.Reserved = State.Reserved;
+	return std::memcmp(&Expected, &State, sizeof(FDeviceState)) == 0;
+}
+
+int main(int ArgC, char** ArgV)
+{
+	const double Seconds = ArgC > 1 ? std::atof(ArgV[1]) : 2.0;
+
+	char Path[] = "/tmp/DirectInputTelemetryXXXXXX";
+	const int File = mkstemp(Path);
+	if (File < 0 || ftruncate(File, static_cast<off_t>(GetRegionSize())) != 0)
+	{
+		std::perror("Could not create the region");
+		return 1;
+	}
+	unlink(Path);
+
+	// Two mappings of the file, one for each side, like two processes would have
+	void* WriterRegion = MapRegion(File, GetRegionSize());
+	void* ReaderRegion = MapRegion(File, GetRegionSize());
+	if (WriterRegion == nullptr || ReaderRegion == nullptr)
+	{
+		std::perror("Could not map the region");
+		return 1;
+	}
+
+	int Failures = 0;
+	if (IsCompatible(ReaderRegion, GetRegionSize()))
+	{
+		std::printf("FAILED: an empty region is compatible\n");
+		Failures++;
+	}
+
+	WriteHeader(WriterRegion);
+	if (!IsCompatible(ReaderRegion, GetRegionSize()) || IsCompatible(ReaderRegion, GetRegionSize() - 1))
+	{
+		std::printf("FAILED: compatibility of a written region\n");
+		Failures++;
+	}
+
+	FDeviceState State;
+	if (ReadDevice(ReaderRegion, 0, State) || ReadDevice(ReaderRegion, MaxDevices, State))
+	{
+		std::printf("FAILED: read an unpublished or missing slot\n");
+		Failures++;
+	}
+
+	std::atomic<bool> bStopping(false);
+	std::atomic<uint64_t> NumPublished(0);
+	std::thread Writer([&]()
+	{
+		FDevice& Device = GetDevice(WriterRegion, 0);
+		uint64_t Count = 0;
+		while (!bStopping.load(std::memory_order_relaxed))
+		{
+			Publish(Device, ++Count);
+		}
+		NumPublished = Count;
+	});
+
+	uint64_t NumReads = 0;
+	uint64_t NumFailedReads = 0;
+	uint64_t NumTorn = 0;
+	uint64_t NumBackwards = 0;
+	uint64_t LastCount = 0;
+
+	const auto EndTime = std::chrono::steady_clock::now() + std::chrono::duration<double>(Seconds);
+	while (std::chrono::steady_clock::now() < EndTime)
+	{
+		if (!ReadDevice(ReaderRegion, 0, State))
+		{
+			NumFailedReads++;
+			continue;
+		}
+
+		NumReads++;
+		NumTorn += IsConsistent(State) ? 0 : 1;
+		NumBackwards += State.PublishCount < LastCount ? 1 : 0;
+		LastCount = State.PublishCount;
+	}
+
+	bStopping = true;
+	Writer.join();
+
+	std::printf("%llu publishes, %llu reads, %llu gave up after every attempt, %llu torn, %llu went backwards\n",
+		static_cast<unsigned long long>(NumPublished.load()), static_cast<unsigned long long>(NumReads), static_cast<unsigned long long>(NumFailedReads),
+		static_cast<unsigned long long>(NumTorn), static_cast<unsigned long long>(NumBackwards));
+
+	if (NumTorn > 0 || NumBackwards > 0)
+	{
+		std::printf("FAILED: inconsistent reads\n");
+		Failures++;
+	}
+	if (NumReads == 0)
+	{
+		std::printf("FAILED: no read succeeded\n");
+		Failures++;
+	}
+
+	munmap(WriterRegion, GetRegionSize());
+	munmap(ReaderRegion, GetRegionSize());
+	close(File);
+
+	std::printf("%s\n", Failures == 0 ? "PASSED" : "FAILED");
+	return Failures == 0 ? 0 : 1;
+}